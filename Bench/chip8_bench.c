@@ -0,0 +1,561 @@
+/////////////////////////////////////////////////
+/// Includes
+/////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "CHIP8/CHIP8.h"
+#include "CHIP8/CHIP8_Render.h"
+#include "Tools/chip8_tools.h"
+
+/////////////////////////////////////////////////
+/// Defines
+/////////////////////////////////////////////////
+
+#define BENCH_DEFAULT_CYCLES    20000000u   /// Instructions per case and engine
+#define BENCH_DEFAULT_REPEATS   3u          /// The fastest of these runs is reported
+#define BENCH_DEFAULT_TOLERANCE 10.0        /// Percent slower than the baseline that counts as a regression
+#define BENCH_CHUNK_CYCLES      1000000u
+#define BENCH_FRAMES_IPS        600000u     /// Speed of the end-to-end frames case
+#define BENCH_RENDER_FRAMES     100000u
+#define BENCH_MAX_RESULTS       64u
+#define BENCH_NAME_SIZE         32u
+
+/////////////////////////////////////////////////
+/// Typedef enumerations
+/////////////////////////////////////////////////
+
+typedef enum BENCH_MODE_TYPE
+{
+    BENCH_MODE_CYCLES = 0,  /// CHIP8_RunCycles back to back, measures dispatch and handlers only
+    BENCH_MODE_FRAMES,      /// CHIP8_RunFrames at BENCH_FRAMES_IPS, adds the scheduler and the timers
+
+} bench_mode_t;
+
+/////////////////////////////////////////////////
+/// Typedef structures
+/////////////////////////////////////////////////
+
+/// Micro-ROM assembled at start up, iteration and draws describe one pass of its loop
+typedef struct BENCH_CASE_STRUCT
+{
+    const char      *name;
+    const uint16_t  *program;
+    uint32_t        length;     /// Opcodes in program
+    uint32_t        iteration;  /// Instructions executed by one pass of the loop
+    uint32_t        draws;      /// DXYN executed by one pass of the loop
+    bench_mode_t    mode;
+
+} bench_case_t;
+
+typedef struct BENCH_RESULT_STRUCT
+{
+    char    name[BENCH_NAME_SIZE];
+    char    engine[BENCH_NAME_SIZE];
+    double  ips;
+    double  nsPerOp;
+    double  drawsPerS;
+
+} bench_result_t;
+
+/////////////////////////////////////////////////
+/// Local variables
+/////////////////////////////////////////////////
+
+/// Every loop bumps VE so no pass repeats the previous one and the idle loop detection never fires.
+
+/// 8XYN register operations
+static const uint16_t bench_alu[] =
+{
+    0x8014, 0x8125, 0x8236, 0x8307, 0x840E, 0x8511, 0x8622, 0x8733, 0x8804,
+    0x7E01, 0x1200,
+};
+
+/// 3XNN, 4XNN, 5XY0, 9XY0, EX9E and EXA1, taken and not taken, V0 = V1 = 0 and no key is pressed
+static const uint16_t bench_skip[] =
+{
+    0x3001, 0x4000, 0x5010, 0x6000, 0x9010, 0xE19E, 0xE1A1, 0x6000,
+    0x7E01, 0x1200,
+};
+
+/// 2NNN and 00EE
+static const uint16_t bench_call[] =
+{
+    0x2208, 0x2208, 0x7E01, 0x1200,
+    0x00EE,
+};
+
+/// Font glyphs drawn across the whole screen, with wrap around and collisions
+static const uint16_t bench_draw[] =
+{
+    0xF029, 0xD125, 0x7103, 0x7201, 0x7001, 0x1200,
+};
+
+/// FX33 into a scratch area past the program
+static const uint16_t bench_bcd[] =
+{
+    0xA400,
+    0xF033, 0x7007, 0x1202,
+};
+
+/// FX55 and FX65 of all sixteen registers
+static const uint16_t bench_block[] =
+{
+    0xA400, 0xFF55, 0xFF65, 0x7E01, 0x1200,
+};
+
+/// ALU, skip and jump mix, also the workload of the end-to-end frames case
+static const uint16_t bench_mix[] =
+{
+    0x6000,     /// 200: V0 = 0
+    0x6101,     /// 202: V1 = 1
+    0x8014,     /// 204: V0 += V1
+    0x8105,     /// 206: V1 -= V0
+    0x7201,     /// 208: V2 += 1
+    0x3200,     /// 20A: skip if V2 == 0
+    0x1204,     /// 20C: jump 204
+    0x8023,     /// 20E: V0 ^= V2
+    0x1204,     /// 210: jump 204
+};
+
+#define BENCH_CASE(name, program, iteration, draws, mode) \
+    { name, program, sizeof(program) / sizeof(program[0]), iteration, draws, mode }
+
+static const bench_case_t bench_cases[] =
+{
+    BENCH_CASE("alu",    bench_alu,   11, 0, BENCH_MODE_CYCLES),
+    BENCH_CASE("skip",   bench_skip,   8, 0, BENCH_MODE_CYCLES),
+    BENCH_CASE("call",   bench_call,   6, 0, BENCH_MODE_CYCLES),
+    BENCH_CASE("draw",   bench_draw,   6, 1, BENCH_MODE_CYCLES),
+    BENCH_CASE("bcd",    bench_bcd,    3, 0, BENCH_MODE_CYCLES),
+    BENCH_CASE("block",  bench_block,  5, 0, BENCH_MODE_CYCLES),
+    BENCH_CASE("mix",    bench_mix,    0, 0, BENCH_MODE_CYCLES),
+    BENCH_CASE("frames", bench_mix,    0, 0, BENCH_MODE_FRAMES),
+};
+
+#undef BENCH_CASE
+
+#define BENCH_CASE_COUNT    (sizeof(bench_cases) / sizeof(bench_cases[0]))
+
+static chip8_t chip;
+static chip8_keymap_t keymap;
+static uint32_t pixels[CHIP8_RENDER_PIXELS];
+static uint8_t micro_rom[CHIP8_MEMORY_SIZE - CHIP8_PROGRAM_START_ADDR];
+static bench_result_t results[BENCH_MAX_RESULTS];
+static uint32_t result_count;
+static bench_result_t baseline[BENCH_MAX_RESULTS];
+static uint32_t baseline_count;
+
+/////////////////////////////////////////////////
+/// Local functions
+/////////////////////////////////////////////////
+
+static void print_usage(const char *name);
+static uint32_t bench_assemble(const bench_case_t *bench, uint8_t *rom);
+static double bench_run(const char *name, const uint8_t *rom, uint32_t rom_size, bench_mode_t mode, chip8_engine_t engine,
+                        uint64_t cycles, uint32_t repeats, uint64_t *executed);
+static void bench_add(const char *name, chip8_engine_t engine, uint64_t executed, double elapsed, uint32_t iteration, uint32_t draws);
+static bool bench_write_json(const char *path, uint64_t cycles);
+static bool bench_load_baseline(const char *path);
+static const bench_result_t *bench_find_baseline(const bench_result_t *result);
+static void bench_render(void);
+
+/////////////////////////////////////////////////
+/// Main function
+/////////////////////////////////////////////////
+
+int main(int argc, char **argv)
+{
+    uint8_t *rom = NULL;
+    uint32_t rom_size = 0;
+    uint64_t cycles = BENCH_DEFAULT_CYCLES;
+    uint32_t repeats = BENCH_DEFAULT_REPEATS;
+    double tolerance = BENCH_DEFAULT_TOLERANCE;
+    chip8_engine_t only_engine = CHIP8_ENGINE_TOTAL;
+    const char *filter = NULL;
+    const char *json = NULL;
+    const char *baseline_path = NULL;
+    bool render = true;
+
+    for(int itr = 1; itr < argc; itr++)
+    {
+        const char *value = (itr + 1 < argc) ? argv[itr + 1] : NULL;
+
+        if( strcmp(argv[itr], "--no-render") == 0 )
+        {
+            render = false;
+            continue;
+        }
+        else if( argv[itr][0] != '-' )
+        {
+            /// The ROM, a second positional argument is the cycle budget
+            if( rom != NULL )
+            {
+                cycles = strtoull(argv[itr], NULL, 10);
+                continue;
+            }
+
+            rom = tools_load_rom(argv[itr], &rom_size);
+            if( rom == NULL )
+            {
+                puts("Failed to load file");
+                return -1;
+            }
+            continue;
+        }
+        else if( value == NULL )
+        {
+            print_usage(argv[0]);
+            return -1;
+        }
+        else if( strcmp(argv[itr], "--cycles") == 0 )
+        {
+            cycles = strtoull(value, NULL, 10);
+        }
+        else if( strcmp(argv[itr], "--repeat") == 0 )
+        {
+            repeats = (uint32_t)strtoul(value, NULL, 10);
+        }
+        else if( strcmp(argv[itr], "--engine") == 0 )
+        {
+            if( tools_parse_engine(value, &only_engine) == false )
+            {
+                printf("Unsupported engine: %s\n", value);
+                return -1;
+            }
+        }
+        else if( strcmp(argv[itr], "--filter") == 0 )
+        {
+            filter = value;
+        }
+        else if( strcmp(argv[itr], "--json") == 0 )
+        {
+            json = value;
+        }
+        else if( strcmp(argv[itr], "--baseline") == 0 )
+        {
+            baseline_path = value;
+        }
+        else if( strcmp(argv[itr], "--tolerance") == 0 )
+        {
+            tolerance = strtod(value, NULL);
+        }
+        else
+        {
+            print_usage(argv[0]);
+            return -1;
+        }
+
+        itr++;
+    }
+
+    if( cycles == 0 || repeats == 0 )
+    {
+        print_usage(argv[0]);
+        return -1;
+    }
+
+    if( baseline_path != NULL && bench_load_baseline(baseline_path) == false )
+    {
+        printf("Failed to load baseline %s\n", baseline_path);
+        return -1;
+    }
+
+    printf("%-10s %-10s %14s %10s %14s\n", "case", "engine", "IPS", "ns/op", "draws/s");
+
+    for(uint32_t engine = 0; engine < CHIP8_ENGINE_TOTAL; engine++)
+    {
+        if( only_engine != CHIP8_ENGINE_TOTAL && engine != (uint32_t)only_engine )
+        {
+            continue;
+        }
+
+        if( CHIP8_IsEngineSupported((chip8_engine_t)engine) == false )
+        {
+            printf("%-10s %-10s %14s %10s %14s\n", "*", CHIP8_GetEngineName((chip8_engine_t)engine), "n/a", "n/a", "n/a");
+            continue;
+        }
+
+        /// The micro-ROMs, then the given ROM end to end as the "rom" case
+        for(uint32_t itr = 0; itr <= BENCH_CASE_COUNT; itr++)
+        {
+            static const bench_case_t rom_case = { "rom", NULL, 0, 0, 0, BENCH_MODE_FRAMES };
+            const bench_case_t *bench = (itr < BENCH_CASE_COUNT) ? &bench_cases[itr] : &rom_case;
+            const uint8_t *image = micro_rom;
+            uint32_t image_size = 0;
+            uint64_t executed = 0;
+
+            if( (bench == &rom_case && rom == NULL) || (filter != NULL && strstr(bench->name, filter) == NULL) )
+            {
+                continue;
+            }
+
+            if( bench->program == NULL )
+            {
+                image = rom;
+                image_size = rom_size;
+            }
+            else
+            {
+                image_size = bench_assemble(bench, micro_rom);
+            }
+
+            double elapsed = bench_run(bench->name, image, image_size, bench->mode, (chip8_engine_t)engine, cycles, repeats, &executed);
+            if( elapsed < 0.0 )
+            {
+                return -1;
+            }
+
+            bench_add(bench->name, (chip8_engine_t)engine, executed, elapsed, bench->iteration, bench->draws);
+
+            const bench_result_t *result = &results[result_count - 1];
+            printf("%-10s %-10s %14.0f %10.2f ", result->name, result->engine, result->ips, result->nsPerOp);
+            if( result->drawsPerS > 0.0 )
+            {
+                printf("%14.0f\n", result->drawsPerS);
+            }
+            else
+            {
+                printf("%14s\n", "-");
+            }
+        }
+    }
+
+    free(rom);
+
+    int status = 0;
+
+    if( baseline_path != NULL )
+    {
+        uint32_t regressions = 0;
+
+        printf("\n%-10s %-10s %14s %14s %8s\n", "case", "engine", "IPS", "baseline", "delta");
+
+        for(uint32_t itr = 0; itr < result_count; itr++)
+        {
+            const bench_result_t *result = &results[itr];
+            const bench_result_t *base = bench_find_baseline(result);
+            if( base == NULL || base->ips <= 0.0 )
+            {
+                printf("%-10s %-10s %14.0f %14s %8s\n", result->name, result->engine, result->ips, "-", "-");
+                continue;
+            }
+
+            double delta = (result->ips - base->ips) * 100.0 / base->ips;
+            bool regressed = (delta < -tolerance);
+            regressions += regressed ? 1 : 0;
+
+            printf("%-10s %-10s %14.0f %14.0f %+7.1f%%%s\n", result->name, result->engine, result->ips, base->ips, delta, regressed ? "  REGRESSION" : "");
+        }
+
+        printf("%u regression(s) beyond %.1f%%\n", regressions, tolerance);
+        status = (regressions == 0) ? 0 : 1;
+    }
+
+    if( json != NULL && bench_write_json(json, cycles) == false )
+    {
+        printf("Failed to write %s\n", json);
+        status = -1;
+    }
+
+    if( render )
+    {
+        bench_render();
+    }
+
+    return status;
+}
+
+static void print_usage(const char *name)
+{
+    printf("Usage: %s [rom [cycles]] [--cycles N] [--repeat N] [--engine NAME] [--filter TEXT]\n"
+           "       %*s [--json FILE] [--baseline FILE] [--tolerance PERCENT] [--no-render]\n"
+           "  rom                 also run this ROM end to end as the \"rom\" case\n"
+           "  --cycles N          instructions per case and engine (default %u)\n"
+           "  --repeat N          runs per case, the fastest is kept (default %u)\n"
+           "  --filter TEXT       only run the cases whose name contains TEXT\n"
+           "  --json FILE         write the results as JSON\n"
+           "  --baseline FILE     compare against a previous --json output, exits with 1 on a regression\n"
+           "  --tolerance PERCENT slowdown accepted by --baseline (default %.0f)\n",
+           name, (int)strlen(name), "", BENCH_DEFAULT_CYCLES, BENCH_DEFAULT_REPEATS, BENCH_DEFAULT_TOLERANCE);
+}
+
+static uint32_t bench_assemble(const bench_case_t *bench, uint8_t *rom)
+{
+    for(uint32_t itr = 0; itr < bench->length; itr++)
+    {
+        rom[itr * 2] = (uint8_t)(bench->program[itr] >> 8);
+        rom[itr * 2 + 1] = (uint8_t)bench->program[itr];
+    }
+
+    return bench->length * 2;
+}
+
+static double bench_run(const char *name, const uint8_t *rom, uint32_t rom_size, bench_mode_t mode, chip8_engine_t engine,
+                        uint64_t cycles, uint32_t repeats, uint64_t *executed)
+{
+    double best = 0.0;
+
+    for(uint32_t run = 0; run < repeats; run++)
+    {
+        if( CHIP8_Init(&chip, &keymap, (uint8_t *)rom, rom_size) != CHIP8_ERROR_NO )
+        {
+            printf("Failed to init CHIP8 for %s\n", name);
+            return -1.0;
+        }
+
+        CHIP8_SetEngine(&chip, engine);
+
+        double start = tools_get_time_s();
+        if( mode == BENCH_MODE_FRAMES )
+        {
+            /// Whole 60 Hz frames covering the cycle budget
+            CHIP8_SetSpeed(&chip, BENCH_FRAMES_IPS);
+            CHIP8_RunFrames(&chip, (uint32_t)((cycles * CHIP8_TIMER_FREQUENCY_HZ + BENCH_FRAMES_IPS - 1) / BENCH_FRAMES_IPS));
+        }
+        else
+        {
+            /// Faults only stop a chunk early, keep going until the budget is spent or the ROM waits for a key
+            uint64_t done = 0;
+            while( done < cycles && !CHIP8_IsWaitingForKey(&chip) )
+            {
+                uint64_t chunk = cycles - done;
+                done += CHIP8_RunCycles(&chip, chunk > BENCH_CHUNK_CYCLES ? BENCH_CHUNK_CYCLES : (uint32_t)chunk);
+            }
+        }
+        double elapsed = tools_get_time_s() - start;
+
+        if( run == 0 || elapsed < best )
+        {
+            best = elapsed;
+        }
+        (*executed) = chip.scheduler.cycles;
+
+        CHIP8_Deinit(&chip);
+    }
+
+    return best;
+}
+
+static void bench_add(const char *name, chip8_engine_t engine, uint64_t executed, double elapsed, uint32_t iteration, uint32_t draws)
+{
+    if( result_count >= BENCH_MAX_RESULTS )
+    {
+        return;
+    }
+
+    bench_result_t *result = &results[result_count++];
+    snprintf(result->name, sizeof(result->name), "%s", name);
+    snprintf(result->engine, sizeof(result->engine), "%s", CHIP8_GetEngineName(engine));
+
+    result->ips = (elapsed > 0.0) ? (double)executed / elapsed : 0.0;
+    result->nsPerOp = (executed > 0) ? elapsed * 1e9 / (double)executed : 0.0;
+    result->drawsPerS = (iteration > 0) ? result->ips * draws / iteration : 0.0;
+}
+
+static bool bench_write_json(const char *path, uint64_t cycles)
+{
+    FILE *f = fopen(path, "w");
+    if( f == NULL )
+    {
+        return false;
+    }
+
+    /// One result per line, bench_load_baseline relies on it
+    fprintf(f, "{\n  \"cycles\": %llu,\n  \"results\": [\n", (unsigned long long)cycles);
+    for(uint32_t itr = 0; itr < result_count; itr++)
+    {
+        const bench_result_t *result = &results[itr];
+        fprintf(f, "    {\"case\": \"%s\", \"engine\": \"%s\", \"ips\": %.0f, \"ns_per_op\": %.4f, \"draws_per_s\": %.0f}%s\n",
+                result->name, result->engine, result->ips, result->nsPerOp, result->drawsPerS, (itr + 1 < result_count) ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+
+    bool failed = (ferror(f) != 0);
+    failed |= (fclose(f) != 0);
+
+    return !failed;
+}
+
+static bool bench_load_baseline(const char *path)
+{
+    char line[256];
+
+    FILE *f = fopen(path, "r");
+    if( f == NULL )
+    {
+        return false;
+    }
+
+    while( fgets(line, sizeof(line), f) != NULL && baseline_count < BENCH_MAX_RESULTS )
+    {
+        bench_result_t *base = &baseline[baseline_count];
+        const char *start = strchr(line, '{');
+
+        if( start != NULL && sscanf(start, "{\"case\": \"%31[^\"]\", \"engine\": \"%31[^\"]\", \"ips\": %lf, \"ns_per_op\": %lf, \"draws_per_s\": %lf",
+                                    base->name, base->engine, &base->ips, &base->nsPerOp, &base->drawsPerS) == 5 )
+        {
+            baseline_count++;
+        }
+    }
+
+    fclose(f);
+    return baseline_count > 0;
+}
+
+static const bench_result_t *bench_find_baseline(const bench_result_t *result)
+{
+    for(uint32_t itr = 0; itr < baseline_count; itr++)
+    {
+        if( strcmp(baseline[itr].name, result->name) == 0 && strcmp(baseline[itr].engine, result->engine) == 0 )
+        {
+            return &baseline[itr];
+        }
+    }
+
+    return NULL;
+}
+
+static void bench_render(void)
+{
+    uint32_t size = bench_assemble(&bench_cases[0], micro_rom);
+    CHIP8_Init(&chip, &keymap, micro_rom, size);
+
+    /// Checkerboard, half of the pixels lit
+    for(uint32_t y = 0; y < CHIP8_LORES_HEIGHT_SCREEN; y++)
+    {
+        chip.screen.rows[y][0] = (y & 1) ? 0xAAAAAAAAAAAAAAAAULL : 0x5555555555555555ULL;
+    }
+
+    printf("\n%-10s %14s %10s\n", "render", "frames/s", "ns/frame");
+
+    for(uint32_t format = 0; format < 3; format++)
+    {
+        static const char *format_names[3] = { "1bpp", "8bpp", "rgba" };
+
+        double start = tools_get_time_s();
+        for(uint32_t frame = 0; frame < BENCH_RENDER_FRAMES; frame++)
+        {
+            switch( format )
+            {
+                case 0:
+                    CHIP8_Render1bpp(&chip, (uint8_t *)pixels);
+                    break;
+
+                case 1:
+                    CHIP8_Render8bpp(&chip, (uint8_t *)pixels, 0xFF, 0x00);
+                    break;
+
+                default:
+                    CHIP8_RenderRGBA(&chip, pixels, 0xFFFFFFFFu, 0xFF000000u);
+                    break;
+            }
+        }
+        double elapsed = tools_get_time_s() - start;
+
+        printf("%-10s %14.0f %10.2f\n", format_names[format], (double)BENCH_RENDER_FRAMES / elapsed, elapsed * 1e9 / (double)BENCH_RENDER_FRAMES);
+    }
+
+    CHIP8_Deinit(&chip);
+}
@@ -3,6 +3,14 @@
 /////////////////////////////////////////////////
 
 #include "CHIP8.h"
+#include "CHIP8_Trace.h"
+#include "CHIP8_Stats.h"
+#include "CHIP8_Profile.h"
+#include "CHIP8_Jit.h"
+#include "CHIP8_State.h"
+#include "CHIP8_Movie.h"
+#include "CHIP8_Lockstep.h"
+#include "CHIP8_Font.h"     /// Generated from char_set.bin and char_set_big.bin
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -12,31 +20,187 @@
 /// Defines
 /////////////////////////////////////////////////
 
+#define CHIP8_US_PER_SECOND         1000000ULL
+#define CHIP8_UNBOUNDED_BATCH       1024    /// Instructions executed between clock reads in unbounded mode
+#define CHIP8_IDLE_MIN_BUDGET       32      /// Shorter runs are not worth probing for an idle loop
+#define CHIP8_IDLE_PROBE_CYCLES     16      /// Instructions the probe may run before giving up
+#define CHIP8_SCREEN_PIXEL(x)       (0x8000000000000000ULL >> (x))     /// Bit of pixel x inside its row word
+#define CHIP8_SCREEN_WORD_PIXELS    64
+#define CHIP8_SCREEN_SCROLL_PIXELS  4       /// Columns moved by 00FB and 00FC
+#define CHIP8_FNV_OFFSET_BASIS      0xCBF29CE484222325ULL
+#define CHIP8_FNV_PRIME             0x100000001B3ULL
+
+_Static_assert(sizeof(chip_font_image) == CHIP8_FONT_SIZE + CHIP8_BIG_FONT_SIZE, "char_set.bin and char_set_big.bin must hold 16 glyphs each");
+
+#if defined(__GNUC__) || defined(__clang__)
+#define CHIP8_HAS_COMPUTED_GOTO     1
+#else
+#define CHIP8_HAS_COMPUTED_GOTO     0
+#endif
+
+#if defined(__has_attribute)
+#if __has_attribute(musttail)
+#define CHIP8_HAS_MUSTTAIL          1
+#endif
+#endif
+#ifndef CHIP8_HAS_MUSTTAIL
+#define CHIP8_HAS_MUSTTAIL          0
+#endif
+#if CHIP8_HAS_MUSTTAIL && !defined(CHIP8_MUSTTAIL)
+#define CHIP8_MUSTTAIL              __attribute__((musttail))
+#endif
+
+#ifndef CHIP8_DEFAULT_ENGINE
+#if CHIP8_HAS_COMPUTED_GOTO
+#define CHIP8_DEFAULT_ENGINE        CHIP8_ENGINE_GOTO
+#else
+#define CHIP8_DEFAULT_ENGINE        CHIP8_ENGINE_SWITCH
+#endif
+#endif
+
+/// Every instruction handler, X(ID, name) expands to CHIP8_OP_ID and chip_op_name
+#define CHIP8_OP_LIST(X) \
+    X(DECODE, decode)               \
+    X(INVALID, invalid)             \
+    X(CLS, cls)                     \
+    X(RET, ret)                     \
+    X(SCD, scd)                     \
+    X(SCR, scr)                     \
+    X(SCL, scl)                     \
+    X(EXIT, exit)                   \
+    X(LOW, low)                     \
+    X(HIGH, high)                   \
+    X(JP, jp)                       \
+    X(CALL, call)                   \
+    X(SE_IMM, se_imm)               \
+    X(SNE_IMM, sne_imm)             \
+    X(SE_REG, se_reg)               \
+    X(LD_IMM, ld_imm)               \
+    X(ADD_IMM, add_imm)             \
+    X(LD_REG, ld_reg)               \
+    X(OR, or)                       \
+    X(AND, and)                     \
+    X(XOR, xor)                     \
+    X(ADD_REG, add_reg)             \
+    X(SUB, sub)                     \
+    X(SHR, shr)                     \
+    X(SUBN, subn)                   \
+    X(SHL, shl)                     \
+    X(SNE_REG, sne_reg)             \
+    X(LD_I, ld_i)                   \
+    X(JP_V0, jp_v0)                 \
+    X(RND, rnd)                     \
+    X(DRW, drw)                     \
+    X(DRW16, drw16)                 \
+    X(SKP, skp)                     \
+    X(SKNP, sknp)                   \
+    X(LD_VX_DT, ld_vx_dt)           \
+    X(LD_VX_K, ld_vx_k)             \
+    X(LD_DT_VX, ld_dt_vx)           \
+    X(LD_ST_VX, ld_st_vx)           \
+    X(ADD_I, add_i)                 \
+    X(LD_F, ld_f)                   \
+    X(LD_HF, ld_hf)                 \
+    X(LD_B, ld_b)                   \
+    X(LD_MEM_REGS, ld_mem_regs)     \
+    X(LD_REGS_MEM, ld_regs_mem)     \
+    X(LD_FLAGS_REGS, ld_flags_regs) \
+    X(LD_REGS_FLAGS, ld_regs_flags)
+
+/////////////////////////////////////////////////
+/// Typedef enumerations
+/////////////////////////////////////////////////
+
+typedef enum CHIP8_OP_TYPE
+{
+#define CHIP8_OP_ENUM(id, name) CHIP8_OP_##id,
+    CHIP8_OP_LIST(CHIP8_OP_ENUM)
+#undef CHIP8_OP_ENUM
+
+    CHIP8_OP_TOTAL
+} chip8_op_t;
+
+/////////////////////////////////////////////////
+/// Typedef functions
+/////////////////////////////////////////////////
+
+typedef chip8_error_t (*chip8_handler_t)(chip8_t *chip, const chip8_decoded_t *ins);
+
 /////////////////////////////////////////////////
 /// Static variables
 /////////////////////////////////////////////////
 
+static const chip8_handler_t chip_handlers[CHIP8_OP_TOTAL];
+
 /////////////////////////////////////////////////
 /// Prototype static functions
 /////////////////////////////////////////////////
 
-static bool move_character_set_to_virtual_ram(chip8_t *chip);
+static void move_character_set_to_virtual_ram(chip8_t *chip, const chip8_config_t *config);
 static void move_data_to_virtual_ram(chip8_t *chip, uint8_t *buff, uint32_t size);
-static bool chip_draw_sprite(chip8_t *chip, uint16_t x, uint16_t y, uint8_t *sprite, uint32_t num);
+static bool chip_draw_sprite(chip8_t *chip, uint16_t x, uint16_t y, const uint8_t *sprite, uint32_t num, bool wide);
+static bool chip_draw_sprite_hires(chip8_t *chip, uint16_t x, uint16_t y, const uint8_t *sprite, uint32_t num, bool wide);
 static void chip_screen_clean(chip8_t *chip);
-static chip8_error_t chip_set_pixel(chip8_t *chip, uint16_t x, uint16_t y);
+static void chip_screen_scroll_down(chip8_t *chip, uint32_t lines);
+static void chip_screen_scroll_columns(chip8_t *chip, bool left);
+static void chip_screen_set_hires(chip8_t *chip, bool hires);
+static void chip_screen_commit(chip8_t *chip, uint64_t changed_rows, uint64_t changed_left, uint64_t changed_right);
+static inline uint32_t chip_screen_width(const chip8_t *chip);
+static inline uint32_t chip_screen_height(const chip8_t *chip);
 static chip8_error_t chip_memory_write(chip8_t *chip, uint16_t index, uint8_t data);
 static chip8_error_t chip_memory_read(chip8_t *chip, uint16_t index, uint8_t *data);
 static chip8_error_t chip_stack_push(chip8_t *chip, uint16_t data);
 static chip8_error_t chip_stack_pop(chip8_t *chip, uint16_t *pdata);
-static chip8_error_t chip_execute_opcode(chip8_t *chip, uint16_t opcode);
+static void chip_decode(uint16_t opcode, chip8_decoded_t *ins);
+static void chip_decode_cache_build(chip8_t *chip);
+static inline const chip8_decoded_t *chip_fetch(chip8_t *chip, uint16_t pc, chip8_decoded_t *scratch);
+static inline const chip8_decoded_t *chip_fetch_next(chip8_t *chip, uint16_t *pc, chip8_decoded_t *scratch);
+static inline bool chip_retire(chip8_t *chip, chip8_error_t err, uint32_t event_mask, uint32_t *raised);
+static uint32_t chip_engine_switch(chip8_t *chip, uint32_t cycles, uint32_t event_mask, uint32_t *raised);
+static inline bool chip_op_is_pure(uint8_t op);
+static uint32_t chip_idle_probe(chip8_t *chip, uint32_t cycles, uint32_t *raised);
+static uint32_t chip_run_slice(chip8_t *chip, uint32_t cycles, uint32_t event_mask, uint32_t *events);
+static uint32_t chip_run_profiled(chip8_t *chip, uint32_t cycles, uint32_t event_mask, uint32_t *events);
+#if CHIP8_HAS_COMPUTED_GOTO
+static uint32_t chip_engine_goto(chip8_t *chip, uint32_t cycles, uint32_t event_mask, uint32_t *raised);
+#endif
+#if CHIP8_HAS_MUSTTAIL
+static uint32_t chip_engine_tailcall(chip8_t *chip, uint32_t cycles, uint32_t event_mask, uint32_t *raised);
+#endif
+#if CHIP8_HAS_JIT
+static uint32_t chip_engine_jit(chip8_t *chip, uint32_t cycles, uint32_t event_mask, uint32_t *raised);
+#endif
+#define CHIP8_OP_PROTOTYPE(id, name) static chip8_error_t chip_op_##name(chip8_t *chip, const chip8_decoded_t *ins);
+CHIP8_OP_LIST(CHIP8_OP_PROTOTYPE)
+#undef CHIP8_OP_PROTOTYPE
 static uint16_t chip_get_opcode(chip8_t *chip, uint16_t index);
+static chip8_error_t chip_scheduler_tick(chip8_t *chip);
+static void chip_timers_tick(chip8_t *chip);
+static void chip_wait_ticks(chip8_t *chip, uint32_t ticks);
+static uint64_t chip_get_time_us(void);
+static uint8_t chip_keymap_lookup(const chip8_keymap_t *keymap, uint32_t key);
+static void chip_input_drain(chip8_t *chip);
+static inline uint64_t chip_rotr64(uint64_t value, uint32_t shift);
+static inline void chip_rotr128(uint64_t *left, uint64_t *right, uint32_t shift);
+static inline uint8_t chip_random_byte(chip8_t *chip);
+
+static const chip8_handler_t chip_handlers[CHIP8_OP_TOTAL] =
+{
+#define CHIP8_OP_HANDLER(id, name) [CHIP8_OP_##id] = chip_op_##name,
+    CHIP8_OP_LIST(CHIP8_OP_HANDLER)
+#undef CHIP8_OP_HANDLER
+};
 
 /////////////////////////////////////////////////
 /// Public functions
 /////////////////////////////////////////////////
 
 chip8_error_t CHIP8_Init(chip8_t *chip, chip8_keymap_t *keymap, uint8_t *program_buff, uint32_t size)
+{
+    return CHIP8_InitWithConfig(chip, NULL, keymap, program_buff, size);
+}
+
+chip8_error_t CHIP8_InitWithConfig(chip8_t *chip, const chip8_config_t *config, chip8_keymap_t *keymap, uint8_t *program_buff, uint32_t size)
 {
     if(chip == NULL)
     {
@@ -45,506 +209,1909 @@ chip8_error_t CHIP8_Init(chip8_t *chip, chip8_keymap_t *keymap, uint8_t *program
 
     /// Clean CHIP8 structure data
     memset((void *)chip, 0, sizeof(chip8_t));
+    atomic_init(&chip->input.head, 0);
+    atomic_init(&chip->input.tail, 0);
+    atomic_init(&chip->input.dropped, 0);
 
-    /// Copy default character set to CHIP8 virtual memory
-    if( move_character_set_to_virtual_ram(chip) == false )
+    chip->keymap = keymap;
+    if( keymap != NULL )
     {
-        return CHIP8_ERROR_INIT;
+        CHIP8_KeymapBuild(keymap);
     }
 
+    /// Copy the built-in or caller supplied character sets to CHIP8 virtual memory
+    move_character_set_to_virtual_ram(chip, config);
+
+    CHIP8_SetSeed(chip, (config != NULL) ? config->seed : 0);
+
     /// Load program to virtual memory and set PC to 0x200
     move_data_to_virtual_ram(chip, program_buff, size);
     chip->registers.PC = CHIP8_PROGRAM_START_ADDR;
 
+    /// Decode the whole program region once
+    chip_decode_cache_build(chip);
+
+    /// Keep the portable engine if the configured default is unavailable
+    chip->engine = CHIP8_ENGINE_SWITCH;
+    CHIP8_SetEngine(chip, CHIP8_DEFAULT_ENGINE);
+
+    /// Default scheduler settings
+    chip->scheduler.ips = CHIP8_DEFAULT_IPS;
+    chip->scheduler.sliceUs = CHIP8_UNBOUNDED_SLICE_US;
+
     return CHIP8_ERROR_NO;
 }
 
+void CHIP8_Deinit(chip8_t *chip)
+{
+    if( chip == NULL )
+    {
+        return;
+    }
+
+    if( chip->trace != NULL )
+    {
+        CHIP8_TraceStop(chip, NULL);
+    }
+
+    if( chip->stats != NULL )
+    {
+        CHIP8_StatsStop(chip);
+    }
+
+    if( chip->profile != NULL )
+    {
+        CHIP8_ProfileStop(chip);
+    }
+
+    if( chip->movie != NULL )
+    {
+        CHIP8_MovieRecordStop(chip);
+    }
+
+    chip_jit_destroy(chip);
+}
+
 chip8_error_t CHIP8_Run(chip8_t *chip)
 {
-    uint16_t opcode = chip_get_opcode(chip, chip->registers.PC);
-    chip->registers.PC += 2;
+    uint32_t events = CHIP8_EVENT_NONE;
 
-    printf("INFO: OPCODE %04X | PC %04X\n", opcode, chip->registers.PC);
+    /// Same path as a batch of one, so queued input, the key wait and fault retirement all apply
+    CHIP8_RunUntil(chip, 1, CHIP8_EVENT_FAULT, &events);
+
+    if( (events & CHIP8_EVENT_FAULT) != 0 )
+    {
+        return chip->fault;
+    }
+
+    if( chip->keyWait )
+    {
+        return CHIP8_ERROR_WAITING_FOR_KEY;
+    }
 
-    chip_execute_opcode(chip, opcode);
     return CHIP8_ERROR_NO;
 }
 
-bool CHIP8_DrawSprite(chip8_t *chip, uint16_t x, uint16_t y, uint8_t *sprite, uint32_t num)
+uint32_t CHIP8_RunCycles(chip8_t *chip, uint32_t cycles)
 {
-    return chip_draw_sprite(chip, x, y, sprite, num);
+    return CHIP8_RunUntil(chip, cycles, CHIP8_EVENT_FAULT, NULL);
 }
 
-bool CHIP8_IsPixelSet(chip8_t *chip, uint16_t x, uint16_t y)
+uint32_t CHIP8_RunUntil(chip8_t *chip, uint32_t cycles, uint32_t event_mask, uint32_t *events)
 {
-    if(( x < 0 && CHIP8_HEIGHT_SCREEN >= x ) && ( y < 0 && CHIP8_WIDTH_SCREEN >= y ))
+    /// Queued key events land between instructions whichever call drives the VM, a release may also wake FX0A
+    chip_input_drain(chip);
+
+    /// The profiler cuts the run into slices and samples between them, the engines stay untouched
+    if( chip->profile != NULL )
     {
-        return false;
+        return chip_run_profiled(chip, cycles, event_mask, events);
     }
 
-    return chip->screen.buffer[y][x];
+    return chip_run_slice(chip, cycles, event_mask, events);
 }
 
-uint8_t CHIP8_GetDelayTimer(chip8_t *chip)
+chip8_error_t CHIP8_GetFault(chip8_t *chip)
 {
-    return chip->registers.delayTimer;
+    return chip->fault;
 }
 
-uint8_t CHIP8_GetSoundTimer(chip8_t *chip)
+chip8_error_t CHIP8_SetEngine(chip8_t *chip, chip8_engine_t engine)
 {
-    return chip->registers.soundTimer;
+    if( CHIP8_IsEngineSupported(engine) == false )
+    {
+        return CHIP8_ERROR_NOT_SUPPORTED;
+    }
+
+    if( engine == CHIP8_ENGINE_JIT )
+    {
+        chip8_error_t err = chip_jit_create(chip);
+        if( err != CHIP8_ERROR_NO )
+        {
+            return err;
+        }
+    }
+
+    chip->engine = engine;
+    return CHIP8_ERROR_NO;
 }
 
-void CHIP8_DecreaseDelayTimer(chip8_t *chip)
+void CHIP8_SetSeed(chip8_t *chip, uint64_t seed)
 {
-    chip->registers.delayTimer--;
+    chip->rng = chip_seed_state(seed);
 }
 
-void CHIP8_ResetSoundTimer(chip8_t *chip)
+bool CHIP8_IsEngineSupported(chip8_engine_t engine)
 {
-    chip->registers.soundTimer = 0;
+    switch( engine )
+    {
+        case CHIP8_ENGINE_SWITCH:
+            return true;
+
+        case CHIP8_ENGINE_GOTO:
+            return CHIP8_HAS_COMPUTED_GOTO;
+
+        case CHIP8_ENGINE_TAILCALL:
+            return CHIP8_HAS_MUSTTAIL;
+
+        case CHIP8_ENGINE_JIT:
+            return CHIP8_HAS_JIT;
+
+        default:
+            return false;
+    }
 }
 
-/////////////////////////////////////////////////
-/// Prototype static functions
-/////////////////////////////////////////////////
+const char *CHIP8_GetEngineName(chip8_engine_t engine)
+{
+    static const char *names[CHIP8_ENGINE_TOTAL] =
+    {
+        [CHIP8_ENGINE_SWITCH]   = "switch",
+        [CHIP8_ENGINE_GOTO]     = "goto",
+        [CHIP8_ENGINE_TAILCALL] = "tailcall",
+        [CHIP8_ENGINE_JIT]      = "jit",
+    };
+
+    return ((uint32_t)engine < CHIP8_ENGINE_TOTAL) ? names[engine] : "unknown";
+}
 
-static bool move_character_set_to_virtual_ram(chip8_t *chip)
+chip8_error_t CHIP8_SetSpeed(chip8_t *chip, uint32_t ips)
 {
-    const char char_set_path[] = "./bin/char_set.bin";
-    uint8_t *buff = NULL;
-    uint16_t size = 0;
+    if(chip == NULL)
+    {
+        return CHIP8_ERROR_INIT;
+    }
 
-    FILE *f = fopen(char_set_path, "rb");
-    if (!f)
+    /// An unbounded speed depends on host time, a recording could not replay it
+    if( ips == CHIP8_IPS_UNBOUNDED && chip->movie != NULL )
     {
-        puts("Failed to open file.");
-        return false;
+        return CHIP8_ERROR_NOT_SUPPORTED;
     }
 
-    /// Get file size
-    fseek(f, 0, SEEK_END);
-    size = ftell(f);
-    fseek(f, 0, SEEK_SET);
+    chip->scheduler.ips = ips;
+    chip->scheduler.ipsRemainder = 0;
 
-    /// Allocate memory
-    buff = (uint8_t *)malloc(size);
-    if(buff == NULL)
+    if( chip->movie != NULL )
     {
-        puts("Failed to allocate memory");
-        return false;
+        chip_movie_event(chip, CHIP8_MOVIE_RECORD_SPEED, ips);
     }
 
-    memset(buff, 0, size);
-    size_t res = fread(buff, size, 1, f);
-    if(res != 1)
+    return CHIP8_ERROR_NO;
+}
+
+chip8_error_t CHIP8_Update(chip8_t *chip, uint32_t elapsed_us)
+{
+    chip8_error_t err = CHIP8_ERROR_NO;
+    uint32_t ticks = 0;
+
+    /// Accumulate host time scaled by the tick rate so one tick is exactly 1/60 s
+    chip->scheduler.timeAccum += (uint64_t)elapsed_us * CHIP8_TIMER_FREQUENCY_HZ;
+
+    while( chip->scheduler.timeAccum >= CHIP8_US_PER_SECOND )
     {
-        /// Clean memory and free it
-        memset(buff, 0, size);
-        free(buff);
+        chip->scheduler.timeAccum -= CHIP8_US_PER_SECOND;
 
-        puts("Failed to read from file.");
-        return false;
+        /// Drop the backlog after a host stall instead of spiralling behind
+        if( ticks >= CHIP8_MAX_TICKS_PER_UPDATE )
+        {
+            chip->scheduler.timeAccum %= CHIP8_US_PER_SECOND;
+            break;
+        }
+
+        /// Timers keep running while the VM waits for a key
+        err = chip_scheduler_tick(chip);
+        if( err != CHIP8_ERROR_NO && err != CHIP8_ERROR_WAITING_FOR_KEY )
+        {
+            break;
+        }
+
+        ticks++;
     }
 
-    for(uint32_t itr = 0; itr < size; itr++)
+    return err;
+}
+
+chip8_error_t CHIP8_RunFrame(chip8_t *chip)
+{
+    return chip_scheduler_tick(chip);
+}
+
+chip8_error_t CHIP8_RunFrames(chip8_t *chip, uint32_t frames)
+{
+    chip8_error_t err = CHIP8_ERROR_NO;
+
+    for(uint32_t frame = 0; frame < frames; frame++)
     {
-        chip->memory[itr] = buff[itr];
+        /// Nothing can wake the VM before the next key event, a recording needs every tick for its checkpoints
+        if( chip->keyWait && chip->movie == NULL
+            && atomic_load_explicit(&chip->input.head, memory_order_acquire) == atomic_load_explicit(&chip->input.tail, memory_order_relaxed) )
+        {
+            chip_wait_ticks(chip, frames - frame);
+            return CHIP8_ERROR_WAITING_FOR_KEY;
+        }
+
+        err = chip_scheduler_tick(chip);
+        if( err != CHIP8_ERROR_NO && err != CHIP8_ERROR_WAITING_FOR_KEY )
+        {
+            break;
+        }
     }
 
-    /// Clean memory and free it
-    memset(buff, 0, size);
-    free(buff);
+    return err;
+}
 
-    return true;
+bool CHIP8_IsWaitingForKey(chip8_t *chip)
+{
+    return chip->keyWait;
 }
 
-static void move_data_to_virtual_ram(chip8_t *chip, uint8_t *buff, uint32_t size)
+uint32_t CHIP8_GetAchievedIps(chip8_t *chip)
 {
-    for(uint32_t itr = 0; itr < size; itr++)
+    return chip->scheduler.achievedIps;
+}
+
+bool CHIP8_DrawSprite(chip8_t *chip, uint16_t x, uint16_t y, uint8_t *sprite, uint32_t num)
+{
+    return chip_draw_sprite(chip, x, y, sprite, num, false);
+}
+
+bool CHIP8_IsPixelSet(chip8_t *chip, uint16_t x, uint16_t y)
+{
+    if( x >= chip_screen_width(chip) || y >= chip_screen_height(chip) )
     {
-        chip->memory[itr + CHIP8_PROGRAM_START_ADDR] = buff[itr];
+        return false;
     }
+
+    return (chip->screen.rows[y][x / CHIP8_SCREEN_WORD_PIXELS] & CHIP8_SCREEN_PIXEL(x % CHIP8_SCREEN_WORD_PIXELS)) != 0;
 }
 
-static bool chip_draw_sprite(chip8_t *chip, uint16_t x, uint16_t y, uint8_t *sprite, uint32_t num)
+void CHIP8_GetFramebuffer(chip8_t *chip, chip8_framebuffer_t *framebuffer)
 {
-    //Local variables
-    bool pixel_collision = false;
+    framebuffer->rows = chip->screen.rows[0];
+    framebuffer->width = (uint16_t)chip_screen_width(chip);
+    framebuffer->height = (uint16_t)chip_screen_height(chip);
+    framebuffer->stride = sizeof(chip->screen.rows[0]);
+}
 
-    for(uint32_t ly = 0; ly < num; ly++)
+uint64_t CHIP8_ScreenHash(chip8_t *chip)
+{
+    /// FNV-1a over the active rows, left pixels first so the value does not depend on host byte order.
+    /// A low resolution screen hashes exactly like the 64x32 screen it is.
+    uint64_t hash = CHIP8_FNV_OFFSET_BASIS;
+    uint32_t height = chip_screen_height(chip);
+    uint32_t words = chip_screen_width(chip) / CHIP8_SCREEN_WORD_PIXELS;
+
+    for(uint32_t row = 0; row < height; row++)
     {
-        uint8_t c = sprite[ly];
-        for(uint32_t lx = 0; lx < 8; lx++)
+        for(uint32_t word = 0; word < words; word++)
         {
-            if( (c & (0b10000000 >> lx)) == 0 )
-            {
-                continue;
-            }
-
-            if(chip->screen.buffer[(ly+y)%CHIP8_HEIGHT_SCREEN][(lx+x)%CHIP8_WIDTH_SCREEN] == true)
+            for(int32_t shift = 56; shift >= 0; shift -= 8)
             {
-                pixel_collision = true;
+                hash ^= (chip->screen.rows[row][word] >> shift) & 0xFF;
+                hash *= CHIP8_FNV_PRIME;
             }
-
-            chip->screen.buffer[(ly+y)%CHIP8_HEIGHT_SCREEN][(lx+x)%CHIP8_WIDTH_SCREEN] ^= true;
         }
     }
 
-    return pixel_collision;
+    return hash;
 }
 
-static void chip_screen_clean(chip8_t *chip)
+uint32_t CHIP8_GetScreenGeneration(chip8_t *chip)
 {
-    memset((void *)chip->screen.buffer, 0, sizeof(chip->screen.buffer));
+    return chip->screen.generation;
 }
 
-static chip8_error_t chip_set_pixel(chip8_t *chip, uint16_t x, uint16_t y)
+bool CHIP8_GetDirtyRegion(chip8_t *chip, uint64_t *rows, chip8_rect_t *rect)
 {
-    if((y >= CHIP8_HEIGHT_SCREEN && y < 0) && (x >= CHIP8_WIDTH_SCREEN) && x < 0)
+    const uint64_t dirty_rows = chip->screen.dirtyRows;
+    const uint64_t *dirty_columns = chip->screen.dirtyColumns;
+
+    if( rows != NULL )
     {
-        return CHIP8_ERROR_SCREEN_INVALID_COORDINATES;
+        (*rows) = dirty_rows;
     }
 
-    chip->screen.buffer[y][x] = true;
-    return CHIP8_ERROR_NO;
+    if( dirty_rows == 0 )
+    {
+        return false;
+    }
+
+    if( rect != NULL )
+    {
+        /// Bounding box of the dirty rows and columns, a sprite wrapping around an edge spans the whole axis
+        uint16_t top = 0;
+        uint16_t bottom = (uint16_t)(chip_screen_height(chip) - 1);
+        uint16_t left = 0;
+        uint16_t right = (uint16_t)(chip_screen_width(chip) - 1);
+
+        while( (dirty_rows & (1ULL << top)) == 0 )
+        {
+            top++;
+        }
+        while( (dirty_rows & (1ULL << bottom)) == 0 )
+        {
+            bottom--;
+        }
+        while( (dirty_columns[left / CHIP8_SCREEN_WORD_PIXELS] & CHIP8_SCREEN_PIXEL(left % CHIP8_SCREEN_WORD_PIXELS)) == 0 )
+        {
+            left++;
+        }
+        while( (dirty_columns[right / CHIP8_SCREEN_WORD_PIXELS] & CHIP8_SCREEN_PIXEL(right % CHIP8_SCREEN_WORD_PIXELS)) == 0 )
+        {
+            right--;
+        }
+
+        rect->x = left;
+        rect->y = top;
+        rect->width = right - left + 1;
+        rect->height = bottom - top + 1;
+    }
+
+    return true;
 }
-static chip8_error_t chip_memory_write(chip8_t *chip, uint16_t index, uint8_t data)
+
+void CHIP8_ClearDirty(chip8_t *chip)
 {
-    if(index > CHIP8_MEMORY_SIZE)
+    chip->screen.dirtyRows = 0;
+    memset(chip->screen.dirtyColumns, 0, sizeof(chip->screen.dirtyColumns));
+}
+
+void CHIP8_KeymapBuild(chip8_keymap_t *keymap)
+{
+    memset(keymap->reverse, CHIP8_KEYMAP_UNMAPPED, sizeof(keymap->reverse));
+
+    /// Walk backwards so a host key mapped twice resolves to the lowest CHIP-8 key
+    for(int32_t itr = CHIP8_KEY_ID_TOTAL - 1; itr >= 0; itr--)
     {
-        return CHIP8_ERROR_INVALID_INDEX;
+        if( keymap->map[itr] < CHIP8_KEYMAP_HOST_KEYS )
+        {
+            keymap->reverse[keymap->map[itr]] = (uint8_t)itr;
+        }
     }
-
-    chip->memory[index] = data;
-    return CHIP8_ERROR_NO;
 }
 
-static chip8_error_t chip_memory_read(chip8_t *chip, uint16_t index, uint8_t *data)
+chip8_error_t CHIP8_SetKey(chip8_t *chip, uint32_t key, bool state)
 {
-    if(index > CHIP8_MEMORY_SIZE)
+    uint8_t id = chip_keymap_lookup(chip->keymap, key);
+    if( id == CHIP8_KEYMAP_UNMAPPED )
     {
-        return CHIP8_ERROR_INVALID_INDEX;
+        return CHIP8_ERROR_INVALID_KEYBOARD_INDEX;
     }
 
-    (*data) = chip->memory[index];
-    return CHIP8_ERROR_NO;
+    return CHIP8_SetKeyId(chip, (chip8_key_id_t)id, state);
 }
 
-static chip8_error_t chip_stack_push(chip8_t *chip, uint16_t data)
+chip8_error_t CHIP8_SetKeyId(chip8_t *chip, chip8_key_id_t id, bool state)
 {
-    if( chip->registers.SP >= CHIP8_STACK_DEPTH_TOTAL )
+    if( (uint32_t)id >= CHIP8_KEY_ID_TOTAL )
     {
-        return CHIP8_ERROR_STACK_FULL;
+        return CHIP8_ERROR_INVALID_KEYBOARD_INDEX;
     }
 
-    chip->stack[chip->registers.SP] = data;
-    chip->registers.SP++;
+    uint16_t keys = state ? (uint16_t)(chip->keys | (1u << id)) : (uint16_t)(chip->keys & ~(1u << id));
+    if( keys == chip->keys )
+    {
+        return CHIP8_ERROR_NO;
+    }
 
-    return CHIP8_ERROR_NO;
-}
+    chip->keys = keys;
 
-static chip8_error_t chip_stack_pop(chip8_t *chip, uint16_t *pdata)
-{
-    if( chip->registers.SP <= 0 )
+    /// Only transitions are recorded, a replay sets the same key state at the same point
+    if( chip->movie != NULL )
     {
-        return CHIP8_ERROR_STACK_EMPTY;
+        chip_movie_event(chip, CHIP8_MOVIE_RECORD_KEY, (uint64_t)id | (state ? CHIP8_MOVIE_KEY_PRESSED : 0u));
     }
 
-    chip->registers.SP--;
-    *(pdata) = chip->stack[chip->registers.SP];
+    /// FX0A completes on the release of a key pressed during the wait, like the COSMAC VIP
+    if( chip->keyWait )
+    {
+        if( state )
+        {
+            chip->keyWaitPressed |= (uint16_t)(1u << id);
+        }
+        else if( chip->keyWaitPressed & (1u << id) )
+        {
+            chip->registers.V[chip->keyWaitReg] = (uint8_t)id;
+            chip->keyWait = false;
+        }
+    }
 
     return CHIP8_ERROR_NO;
 }
 
-static chip8_error_t chip_execute_opcode(chip8_t *chip, uint16_t opcode)
+chip8_error_t CHIP8_PushKeyEvent(chip8_t *chip, uint32_t key, bool state)
 {
-    ///Local variables
-    uint8_t code = (opcode & 0xF000) >> 12;
-    uint8_t x, y, temp_code, hundreds, tens, units;
-    uint16_t n = 0, kk = 0;
-    uint8_t *sprite = NULL;
-    chip8_error_t err = CHIP8_ERROR_NO;
+    chip8_input_t *input = &chip->input;
 
-    switch(code)
+    uint8_t id = chip_keymap_lookup(chip->keymap, key);
+    if( id == CHIP8_KEYMAP_UNMAPPED )
     {
-        case 0x0:
-            switch(opcode)
-            {
-                case 0x00E0: /// Clear screen.
-                    chip_screen_clean(chip);
-                    break;
+        return CHIP8_ERROR_INVALID_KEYBOARD_INDEX;
+    }
 
-                case 0x00EE: /// Return from subroutine.
-                    err = chip_stack_pop(chip, &chip->registers.PC);
-                    break;
+    uint32_t head = atomic_load_explicit(&input->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&input->tail, memory_order_acquire);
+    if( head - tail >= CHIP8_INPUT_QUEUE_SIZE )
+    {
+        atomic_fetch_add_explicit(&input->dropped, 1, memory_order_relaxed);
+        return CHIP8_ERROR_DATA_OVERSIZE;
+    }
 
-                default:
-                    err = CHIP8_ERROR_INVALID_OPCODE;
-                    break;
-            }
-            break;
+    chip8_key_event_t *event = &input->ring[head & (CHIP8_INPUT_QUEUE_SIZE - 1)];
+    event->timestampUs = chip_get_time_us();
+    event->id = id;
+    event->state = state;
 
-        case 0x1:   /// Jump to address NNN.
-            chip->registers.PC = opcode & 0x0FFF;
-            break;
+    atomic_store_explicit(&input->head, head + 1, memory_order_release);
+    return CHIP8_ERROR_NO;
+}
 
-        case 0x2:   /// Call subroutine at NNN.
-            chip_stack_push(chip, chip->registers.PC);
-            chip->registers.PC = opcode & 0x0FFF;
-            break;
+uint16_t CHIP8_GetKeys(chip8_t *chip)
+{
+    return chip->keys;
+}
 
-        case 0x3:   /// Skip next instruction if Vx = NN.
-            n = (opcode & 0x0F00) >> 8;
-            kk = opcode & 0x00FF;
-            if(chip->registers.V[n] == kk)
-            {
-                chip->registers.PC += 2;
-            }
-            break;
+uint8_t CHIP8_GetDelayTimer(chip8_t *chip)
+{
+    return chip->registers.delayTimer;
+}
 
-        case 0x4:   /// Skip next instruction if Vx != NN.
-            n = (opcode & 0x0F00) >> 8;
-            kk = opcode & 0x00FF;
-            if(chip->registers.V[n] != kk)
-            {
-                chip->registers.PC += 2;
-            }
-            break;
+uint8_t CHIP8_GetSoundTimer(chip8_t *chip)
+{
+    return chip->registers.soundTimer;
+}
 
-        case 0x5:   /// Skip next instruction if Vx = Vy.
-            x = (opcode & 0x0F00) >> 8;
-            y = (opcode & 0x00F0) >> 4;
-            if(chip->registers.V[x] == chip->registers.V[y])
-            {
-                chip->registers.PC += 2;
-            }
-            break;
+void CHIP8_DecreaseDelayTimer(chip8_t *chip)
+{
+    chip->registers.delayTimer--;
+}
 
-        case 0x6:   /// Set Vx = NN.
-            n = (opcode & 0x0F00) >> 8;
-            kk = opcode & 0x00FF;
-            chip->registers.V[n] = kk;
-            break;
+void CHIP8_ResetSoundTimer(chip8_t *chip)
+{
+    chip->registers.soundTimer = 0;
+}
 
-        case 0x7:   /// Set Vx = Vx + NN.
-            n = (opcode & 0x0F00) >> 8;
-            kk = opcode & 0x00FF;
-            chip->registers.V[n] += kk;
-            break;
+/////////////////////////////////////////////////
+/// Internal functions
+/////////////////////////////////////////////////
 
-        case 0x8:   /// 8XXX opcode instruction
-            temp_code = opcode & 0x000F;
-            switch(temp_code)
-            {
-                case 0x0:   /// Set Vx = Vy.
-                    x = (opcode & 0x0F00) >> 8;
-                    y = (opcode & 0x00F0) >> 4;
-                    chip->registers.V[x] = chip->registers.V[y];
-                    break;
+uint64_t chip_seed_state(uint64_t seed)
+{
+    /// splitmix64 spreads low entropy seeds over the whole state
+    uint64_t z = ((seed != 0) ? seed : CHIP8_DEFAULT_SEED) + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z = z ^ (z >> 31);
+
+    /// xorshift64* must not start from zero
+    return (z != 0) ? z : CHIP8_DEFAULT_SEED;
+}
 
-                case 0x1:   /// Set Vx = Vx OR Vy.
-                    x = (opcode & 0x0F00) >> 8;
-                    y = (opcode & 0x00F0) >> 4;
-                    chip->registers.V[x] |= chip->registers.V[y];
-                    break;
+void chip_state_reload(chip8_t *chip, const uint8_t *memory)
+{
+    /// Snapshots of one session mostly share the program, unchanged words keep their decode entries and JIT blocks
+    for(uint32_t index = 0; index < CHIP8_MEMORY_SIZE; index += sizeof(uint64_t))
+    {
+        uint64_t current;
+        uint64_t restored;
+
+        memcpy(&current, &chip->memory[index], sizeof(current));
+        memcpy(&restored, &memory[index], sizeof(restored));
+        if( current == restored )
+        {
+            continue;
+        }
+
+        for(uint32_t byte = index; byte < index + sizeof(uint64_t); byte++)
+        {
+            if( chip->memory[byte] != memory[byte] )
+            {
+                chip_memory_write(chip, (uint16_t)byte, memory[byte]);
+            }
+        }
+    }
+}
+
+void chip_screen_invalidate(chip8_t *chip)
+{
+    uint32_t height = chip_screen_height(chip);
+
+    chip->screen.dirtyRows = (height < 64) ? (1ULL << height) - 1 : UINT64_MAX;
+    memset(chip->screen.dirtyColumns, 0xFF, sizeof(chip->screen.dirtyColumns));
+    chip->screen.generation++;
+}
+
+/////////////////////////////////////////////////
+/// Prototype static functions
+/////////////////////////////////////////////////
+
+static void move_character_set_to_virtual_ram(chip8_t *chip, const chip8_config_t *config)
+{
+    /// Both fonts are adjacent in memory and in the generated image
+    memcpy(&chip->memory[CHIP8_FONT_ADDR], chip_font_image, sizeof(chip_font_image));
+
+    if( config != NULL && config->font != NULL )
+    {
+        memcpy(&chip->memory[CHIP8_FONT_ADDR], config->font, CHIP8_FONT_SIZE);
+    }
+
+    if( config != NULL && config->bigFont != NULL )
+    {
+        memcpy(&chip->memory[CHIP8_BIG_FONT_ADDR], config->bigFont, CHIP8_BIG_FONT_SIZE);
+    }
+}
+
+static void move_data_to_virtual_ram(chip8_t *chip, uint8_t *buff, uint32_t size)
+{
+    for(uint32_t itr = 0; itr < size; itr++)
+    {
+        chip->memory[itr + CHIP8_PROGRAM_START_ADDR] = buff[itr];
+    }
+}
+
+static bool chip_draw_sprite(chip8_t *chip, uint16_t x, uint16_t y, const uint8_t *sprite, uint32_t num, bool wide)
+{
+    if( chip->screen.hires )
+    {
+        return chip_draw_sprite_hires(chip, x, y, sprite, num, wide);
+    }
+
+    //Local variables
+    uint64_t collision = 0;
+    uint64_t changed_rows = 0;
+    uint64_t changed_columns = 0;
+    uint32_t shift = x % CHIP8_LORES_WIDTH_SCREEN;
+
+    for(uint32_t ly = 0; ly < num; ly++)
+    {
+        /// Place the sprite row at the left edge and rotate it to x, wrapping around the row
+        uint64_t bits = wide ? ((uint64_t)sprite[2 * ly] << 56) | ((uint64_t)sprite[2 * ly + 1] << 48) : (uint64_t)sprite[ly] << 56;
+        uint64_t mask = chip_rotr64(bits, shift);
+        uint32_t index = (ly + y) % CHIP8_LORES_HEIGHT_SCREEN;
+        uint64_t *row = &chip->screen.rows[index][0];
+
+        collision |= (*row & mask);
+        *row ^= mask;
+
+        /// Every set sprite bit flips its pixel
+        changed_rows |= (uint64_t)(mask != 0) << index;
+        changed_columns |= mask;
+    }
+
+    if( changed_columns != 0 )
+    {
+        chip_screen_commit(chip, changed_rows, changed_columns, 0);
+    }
+
+    return collision != 0;
+}
+
+static bool chip_draw_sprite_hires(chip8_t *chip, uint16_t x, uint16_t y, const uint8_t *sprite, uint32_t num, bool wide)
+{
+    uint64_t collision = 0;
+    uint64_t changed_rows = 0;
+    uint64_t changed_left = 0;
+    uint64_t changed_right = 0;
+    uint32_t shift = x % CHIP8_WIDTH_SCREEN;
+
+    for(uint32_t ly = 0; ly < num; ly++)
+    {
+        /// Same as low resolution with a 128-bit rotation spread over the two words of the row
+        uint64_t left = wide ? ((uint64_t)sprite[2 * ly] << 56) | ((uint64_t)sprite[2 * ly + 1] << 48) : (uint64_t)sprite[ly] << 56;
+        uint64_t right = 0;
+        chip_rotr128(&left, &right, shift);
+
+        uint32_t index = (ly + y) % CHIP8_HEIGHT_SCREEN;
+        uint64_t *row = chip->screen.rows[index];
+
+        collision |= (row[0] & left) | (row[1] & right);
+        row[0] ^= left;
+        row[1] ^= right;
+
+        changed_rows |= (uint64_t)((left | right) != 0) << index;
+        changed_left |= left;
+        changed_right |= right;
+    }
+
+    if( (changed_left | changed_right) != 0 )
+    {
+        chip_screen_commit(chip, changed_rows, changed_left, changed_right);
+    }
+
+    return collision != 0;
+}
+
+static void chip_screen_clean(chip8_t *chip)
+{
+    uint32_t height = chip_screen_height(chip);
+    uint64_t changed_rows = 0;
+    uint64_t lit_left = 0;
+    uint64_t lit_right = 0;
+
+    for(uint32_t y = 0; y < height; y++)
+    {
+        changed_rows |= (uint64_t)((chip->screen.rows[y][0] | chip->screen.rows[y][1]) != 0) << y;
+        lit_left |= chip->screen.rows[y][0];
+        lit_right |= chip->screen.rows[y][1];
+    }
+
+    /// Clearing an empty screen is not a change
+    if( (lit_left | lit_right) != 0 )
+    {
+        chip_screen_commit(chip, changed_rows, lit_left, lit_right);
+    }
+
+    memset((void *)chip->screen.rows, 0, height * sizeof(chip->screen.rows[0]));
+}
+
+static void chip_screen_scroll_down(chip8_t *chip, uint32_t lines)
+{
+    uint32_t height = chip_screen_height(chip);
+    uint64_t changed_rows = 0;
+    uint64_t changed_left = 0;
+    uint64_t changed_right = 0;
+
+    /// Whole rows move down, bottom up so every source row is read before it is overwritten
+    for(uint32_t y = height; y-- > 0;)
+    {
+        uint64_t *row = chip->screen.rows[y];
+        uint64_t left = (y >= lines) ? chip->screen.rows[y - lines][0] : 0;
+        uint64_t right = (y >= lines) ? chip->screen.rows[y - lines][1] : 0;
+
+        changed_rows |= (uint64_t)(((row[0] ^ left) | (row[1] ^ right)) != 0) << y;
+        changed_left |= row[0] ^ left;
+        changed_right |= row[1] ^ right;
+        row[0] = left;
+        row[1] = right;
+    }
+
+    if( (changed_left | changed_right) != 0 )
+    {
+        chip_screen_commit(chip, changed_rows, changed_left, changed_right);
+    }
+}
+
+static void chip_screen_scroll_columns(chip8_t *chip, bool left)
+{
+    const uint32_t shift = CHIP8_SCREEN_SCROLL_PIXELS;
+    uint32_t height = chip_screen_height(chip);
+    uint64_t changed_rows = 0;
+    uint64_t changed_left = 0;
+    uint64_t changed_right = 0;
+
+    for(uint32_t y = 0; y < height; y++)
+    {
+        uint64_t *row = chip->screen.rows[y];
+        uint64_t word0 = row[0];
+        uint64_t word1 = row[1];
+
+        /// A funnel shift across the two words in high resolution, pixels pushed past the edge are lost
+        if( chip->screen.hires == false )
+        {
+            word0 = left ? (word0 << shift) : (word0 >> shift);
+        }
+        else if( left )
+        {
+            word0 = (word0 << shift) | (word1 >> (CHIP8_SCREEN_WORD_PIXELS - shift));
+            word1 <<= shift;
+        }
+        else
+        {
+            word1 = (word1 >> shift) | (word0 << (CHIP8_SCREEN_WORD_PIXELS - shift));
+            word0 >>= shift;
+        }
+
+        changed_rows |= (uint64_t)(((row[0] ^ word0) | (row[1] ^ word1)) != 0) << y;
+        changed_left |= row[0] ^ word0;
+        changed_right |= row[1] ^ word1;
+        row[0] = word0;
+        row[1] = word1;
+    }
+
+    if( (changed_left | changed_right) != 0 )
+    {
+        chip_screen_commit(chip, changed_rows, changed_left, changed_right);
+    }
+}
+
+static void chip_screen_set_hires(chip8_t *chip, bool hires)
+{
+    if( chip->screen.hires == hires )
+    {
+        return;
+    }
+
+    /// The two resolutions do not share a pixel layout, switching starts from a clear screen
+    memset((void *)chip->screen.rows, 0, sizeof(chip->screen.rows));
+    chip->screen.hires = hires;
+    chip_screen_invalidate(chip);
+}
+
+static void chip_screen_commit(chip8_t *chip, uint64_t changed_rows, uint64_t changed_left, uint64_t changed_right)
+{
+    chip->screen.dirtyRows |= changed_rows;
+    chip->screen.dirtyColumns[0] |= changed_left;
+    chip->screen.dirtyColumns[1] |= changed_right;
+    chip->screen.generation++;
+}
+
+static inline uint32_t chip_screen_width(const chip8_t *chip)
+{
+    return chip->screen.hires ? CHIP8_WIDTH_SCREEN : CHIP8_LORES_WIDTH_SCREEN;
+}
+
+static inline uint32_t chip_screen_height(const chip8_t *chip)
+{
+    return chip->screen.hires ? CHIP8_HEIGHT_SCREEN : CHIP8_LORES_HEIGHT_SCREEN;
+}
+
+static chip8_error_t chip_memory_write(chip8_t *chip, uint16_t index, uint8_t data)
+{
+    if(index >= CHIP8_MEMORY_SIZE)
+    {
+        return CHIP8_ERROR_INVALID_INDEX;
+    }
+
+    chip->memory[index] = data;
+
+    /// Self-modifying code, decode the touched instruction again on its next fetch
+    if( index >= CHIP8_PROGRAM_START_ADDR )
+    {
+        chip->decoded[(index - CHIP8_PROGRAM_START_ADDR) >> 1].op = CHIP8_OP_DECODE;
+    }
+
+    if( chip->jit != NULL )
+    {
+        chip_jit_invalidate(chip, index);
+    }
+
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_memory_read(chip8_t *chip, uint16_t index, uint8_t *data)
+{
+    if(index >= CHIP8_MEMORY_SIZE)
+    {
+        return CHIP8_ERROR_INVALID_INDEX;
+    }
+
+    (*data) = chip->memory[index];
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_stack_push(chip8_t *chip, uint16_t data)
+{
+    if( chip->registers.SP >= CHIP8_STACK_DEPTH_TOTAL )
+    {
+        return CHIP8_ERROR_STACK_FULL;
+    }
+
+    chip->stack[chip->registers.SP] = data;
+    chip->registers.SP++;
+
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_stack_pop(chip8_t *chip, uint16_t *pdata)
+{
+    if( chip->registers.SP <= 0 )
+    {
+        return CHIP8_ERROR_STACK_EMPTY;
+    }
+
+    chip->registers.SP--;
+    *(pdata) = chip->stack[chip->registers.SP];
+
+    return CHIP8_ERROR_NO;
+}
+
+static void chip_decode(uint16_t opcode, chip8_decoded_t *ins)
+{
+    ins->opcode = opcode;
+    ins->nnn = opcode & 0x0FFF;
+    ins->x = (opcode & 0x0F00) >> 8;
+    ins->y = (opcode & 0x00F0) >> 4;
+    ins->op = CHIP8_OP_INVALID;
+
+    switch( (opcode & 0xF000) >> 12 )
+    {
+        case 0x0:
+            switch(opcode)
+            {
+                case 0x00E0: ins->op = CHIP8_OP_CLS; break;
+                case 0x00EE: ins->op = CHIP8_OP_RET; break;
+                case 0x00FB: ins->op = CHIP8_OP_SCR; break;
+                case 0x00FC: ins->op = CHIP8_OP_SCL; break;
+                case 0x00FD: ins->op = CHIP8_OP_EXIT; break;
+                case 0x00FE: ins->op = CHIP8_OP_LOW; break;
+                case 0x00FF: ins->op = CHIP8_OP_HIGH; break;
+                default:
+                    if( (opcode & 0xFFF0) == 0x00C0 )
+                    {
+                        ins->op = CHIP8_OP_SCD;
+                    }
+                    break;
+            }
+            break;
+
+        case 0x1: ins->op = CHIP8_OP_JP; break;
+        case 0x2: ins->op = CHIP8_OP_CALL; break;
+        case 0x3: ins->op = CHIP8_OP_SE_IMM; break;
+        case 0x4: ins->op = CHIP8_OP_SNE_IMM; break;
+        case 0x5: ins->op = CHIP8_OP_SE_REG; break;
+        case 0x6: ins->op = CHIP8_OP_LD_IMM; break;
+        case 0x7: ins->op = CHIP8_OP_ADD_IMM; break;
+
+        case 0x8:
+            switch(opcode & 0x000F)
+            {
+                case 0x0: ins->op = CHIP8_OP_LD_REG; break;
+                case 0x1: ins->op = CHIP8_OP_OR; break;
+                case 0x2: ins->op = CHIP8_OP_AND; break;
+                case 0x3: ins->op = CHIP8_OP_XOR; break;
+                case 0x4: ins->op = CHIP8_OP_ADD_REG; break;
+                case 0x5: ins->op = CHIP8_OP_SUB; break;
+                case 0x6: ins->op = CHIP8_OP_SHR; break;
+                case 0x7: ins->op = CHIP8_OP_SUBN; break;
+                case 0xE: ins->op = CHIP8_OP_SHL; break;
+                default: break;
+            }
+            break;
+
+        case 0x9: ins->op = CHIP8_OP_SNE_REG; break;
+        case 0xA: ins->op = CHIP8_OP_LD_I; break;
+        case 0xB: ins->op = CHIP8_OP_JP_V0; break;
+        case 0xC: ins->op = CHIP8_OP_RND; break;
+        case 0xD: ins->op = ((opcode & 0x000F) == 0) ? CHIP8_OP_DRW16 : CHIP8_OP_DRW; break;
+
+        case 0xE:
+            switch(opcode & 0x00FF)
+            {
+                case 0x9E: ins->op = CHIP8_OP_SKP; break;
+                case 0xA1: ins->op = CHIP8_OP_SKNP; break;
+                default: break;
+            }
+            break;
+
+        case 0xF:
+            switch(opcode & 0x00FF)
+            {
+                case 0x07: ins->op = CHIP8_OP_LD_VX_DT; break;
+                case 0x0A: ins->op = CHIP8_OP_LD_VX_K; break;
+                case 0x15: ins->op = CHIP8_OP_LD_DT_VX; break;
+                case 0x18: ins->op = CHIP8_OP_LD_ST_VX; break;
+                case 0x1E: ins->op = CHIP8_OP_ADD_I; break;
+                case 0x29: ins->op = CHIP8_OP_LD_F; break;
+                case 0x30: ins->op = CHIP8_OP_LD_HF; break;
+                case 0x33: ins->op = CHIP8_OP_LD_B; break;
+                case 0x55: ins->op = CHIP8_OP_LD_MEM_REGS; break;
+                case 0x65: ins->op = CHIP8_OP_LD_REGS_MEM; break;
+                case 0x75: ins->op = CHIP8_OP_LD_FLAGS_REGS; break;
+                case 0x85: ins->op = CHIP8_OP_LD_REGS_FLAGS; break;
+                default: break;
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void chip_decode_cache_build(chip8_t *chip)
+{
+    for(uint32_t itr = 0; itr < CHIP8_DECODE_CACHE_ENTRIES; itr++)
+    {
+        uint16_t addr = CHIP8_PROGRAM_START_ADDR + itr * 2;
+        chip_decode(chip_get_opcode(chip, addr), &chip->decoded[itr]);
+    }
+}
+
+static inline const chip8_decoded_t *chip_fetch(chip8_t *chip, uint16_t pc, chip8_decoded_t *scratch)
+{
+    uint16_t offset = (uint16_t)(pc - CHIP8_PROGRAM_START_ADDR);
+
+    if( (offset & 1) == 0 && offset < CHIP8_MEMORY_SIZE - CHIP8_PROGRAM_START_ADDR )
+    {
+        return &chip->decoded[offset >> 1];
+    }
+
+    /// Odd or out of program region addresses are decoded on the fly
+    chip_decode(chip_get_opcode(chip, pc), scratch);
+    return scratch;
+}
+
+/////////////////////////////////////////////////
+/// Instruction handlers
+/////////////////////////////////////////////////
+
+static chip8_error_t chip_op_decode(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Entry was invalidated by a memory write, decode it again and run it
+    chip8_decoded_t *entry = &chip->decoded[ins - chip->decoded];
+    uint16_t addr = CHIP8_PROGRAM_START_ADDR + (uint16_t)(entry - chip->decoded) * 2;
+
+    chip_decode(chip_get_opcode(chip, addr), entry);
+    return chip_handlers[entry->op](chip, entry);
+}
+
+static chip8_error_t chip_op_invalid(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    (void)chip;
+    (void)ins;
+    return CHIP8_ERROR_INVALID_OPCODE;
+}
+
+static chip8_error_t chip_op_cls(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Clear screen.
+    (void)ins;
+    chip_screen_clean(chip);
+    chip->events |= CHIP8_EVENT_SCREEN_CHANGED;
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_op_ret(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Return from subroutine.
+    (void)ins;
+    return chip_stack_pop(chip, &chip->registers.PC);
+}
+
+static chip8_error_t chip_op_scd(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Scroll the screen down N rows.
+    chip_screen_scroll_down(chip, ins->nnn & 0x000F);
+    chip->events |= CHIP8_EVENT_SCREEN_CHANGED;
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_op_scr(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Scroll the screen right 4 pixels.
+    (void)ins;
+    chip_screen_scroll_columns(chip, false);
+    chip->events |= CHIP8_EVENT_SCREEN_CHANGED;
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_op_scl(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Scroll the screen left 4 pixels.
+    (void)ins;
+    chip_screen_scroll_columns(chip, true);
+    chip->events |= CHIP8_EVENT_SCREEN_CHANGED;
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_op_exit(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Exit the interpreter, PC stays on this instruction.
+    (void)ins;
+    chip->registers.PC -= 2;
+    return CHIP8_ERROR_EXIT;
+}
+
+static chip8_error_t chip_op_low(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Switch to the 64x32 resolution.
+    (void)ins;
+    chip_screen_set_hires(chip, false);
+    chip->events |= CHIP8_EVENT_SCREEN_CHANGED;
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_op_high(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Switch to the 128x64 resolution.
+    (void)ins;
+    chip_screen_set_hires(chip, true);
+    chip->events |= CHIP8_EVENT_SCREEN_CHANGED;
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_op_jp(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Jump to address NNN.
+    chip->registers.PC = ins->nnn;
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_op_call(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Call subroutine at NNN.
+    chip8_error_t err = chip_stack_push(chip, chip->registers.PC);
+    chip->registers.PC = ins->nnn;
+    return err;
+}
+
+static chip8_error_t chip_op_se_imm(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Skip next instruction if Vx = NN.
+    if( chip->registers.V[ins->x] == (ins->nnn & 0x00FF) )
+    {
+        chip->registers.PC += 2;
+    }
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_op_sne_imm(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Skip next instruction if Vx != NN.
+    if( chip->registers.V[ins->x] != (ins->nnn & 0x00FF) )
+    {
+        chip->registers.PC += 2;
+    }
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_op_se_reg(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Skip next instruction if Vx = Vy.
+    if( chip->registers.V[ins->x] == chip->registers.V[ins->y] )
+    {
+        chip->registers.PC += 2;
+    }
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_op_ld_imm(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Set Vx = NN.
+    chip->registers.V[ins->x] = ins->nnn & 0x00FF;
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_op_add_imm(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Set Vx = Vx + NN.
+    chip->registers.V[ins->x] += ins->nnn & 0x00FF;
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_op_ld_reg(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Set Vx = Vy.
+    chip->registers.V[ins->x] = chip->registers.V[ins->y];
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_op_or(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Set Vx = Vx OR Vy.
+    chip->registers.V[ins->x] |= chip->registers.V[ins->y];
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_op_and(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Set Vx = Vx AND Vy.
+    chip->registers.V[ins->x] &= chip->registers.V[ins->y];
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_op_xor(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Set Vx = Vx XOR Vy.
+    chip->registers.V[ins->x] ^= chip->registers.V[ins->y];
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_op_add_reg(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Set Vx = Vx + Vy, set VF = carry.
+    uint16_t sum = chip->registers.V[ins->x] + chip->registers.V[ins->y];
+    chip->registers.V[ins->x] = (uint8_t)sum;
+    chip->registers.V[0xF] = (sum > 0xFF) ? 1 : 0;
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_op_sub(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Set Vx = Vx - Vy, set VF = NOT borrow.
+    uint8_t flag = (chip->registers.V[ins->x] >= chip->registers.V[ins->y]) ? 1 : 0;
+    chip->registers.V[ins->x] -= chip->registers.V[ins->y];
+    chip->registers.V[0xF] = flag;
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_op_shr(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Set Vx = Vx SHR 1.
+    uint8_t flag = chip->registers.V[ins->x] & 0x01;
+    chip->registers.V[ins->x] >>= 1;
+    chip->registers.V[0xF] = flag;
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_op_subn(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Set Vx = Vy - Vx, set VF = NOT borrow.
+    uint8_t flag = (chip->registers.V[ins->y] >= chip->registers.V[ins->x]) ? 1 : 0;
+    chip->registers.V[ins->x] = chip->registers.V[ins->y] - chip->registers.V[ins->x];
+    chip->registers.V[0xF] = flag;
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_op_shl(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Set Vx = Vx SHL 1.
+    uint8_t flag = (chip->registers.V[ins->x] & 0x80) >> 7;
+    chip->registers.V[ins->x] <<= 1;
+    chip->registers.V[0xF] = flag;
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_op_sne_reg(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Skip next instruction if Vx != Vy.
+    if( chip->registers.V[ins->x] != chip->registers.V[ins->y] )
+    {
+        chip->registers.PC += 2;
+    }
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_op_ld_i(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Set I = NNN
+    chip->registers.I = ins->nnn;
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_op_jp_v0(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Jump to location NNN + V0.
+    chip->registers.PC = ins->nnn + chip->registers.V[0];
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_op_rnd(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Set Vx = random byte AND NN.
+    chip->registers.V[ins->x] = chip_random_byte(chip) & (ins->nnn & 0x00FF);
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_op_drw(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Display n-byte sprite starting at memory location I at (Vx, Vy), set VF = collision.
+    if( (uint32_t)chip->registers.I + (ins->nnn & 0x000F) > CHIP8_MEMORY_SIZE )
+    {
+        return CHIP8_ERROR_INVALID_INDEX;
+    }
+
+    uint8_t *sprite = &chip->memory[chip->registers.I];
+    chip->registers.V[0xF] = chip_draw_sprite(chip, chip->registers.V[ins->x], chip->registers.V[ins->y], sprite, ins->nnn & 0x000F, false);
+    chip->events |= CHIP8_EVENT_SCREEN_CHANGED;
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_op_drw16(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Display the 16x16 sprite starting at memory location I at (Vx, Vy), set VF = collision.
+    if( (uint32_t)chip->registers.I + 32 > CHIP8_MEMORY_SIZE )
+    {
+        return CHIP8_ERROR_INVALID_INDEX;
+    }
+
+    uint8_t *sprite = &chip->memory[chip->registers.I];
+    chip->registers.V[0xF] = chip_draw_sprite(chip, chip->registers.V[ins->x], chip->registers.V[ins->y], sprite, 16, true);
+    chip->events |= CHIP8_EVENT_SCREEN_CHANGED;
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_op_skp(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Skip next instruction if key with the value of Vx is pressed.
+    if( (chip->keys >> (chip->registers.V[ins->x] & 0xF)) & 1 )
+    {
+        chip->registers.PC += 2;
+    }
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_op_sknp(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Skip next instruction if key with the value of Vx is not pressed.
+    if( ((chip->keys >> (chip->registers.V[ins->x] & 0xF)) & 1) == 0 )
+    {
+        chip->registers.PC += 2;
+    }
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_op_ld_vx_dt(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Set Vx = delay timer value.
+    chip->registers.V[ins->x] = chip->registers.delayTimer;
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_op_ld_vx_k(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Wait for a key press, store the value of the key in Vx.
+    /// The VM parks here, CHIP8_SetKeyId stores the key and resumes it
+    chip->keyWait = true;
+    chip->keyWaitReg = ins->x;
+    chip->keyWaitPressed = 0;
+    chip->events |= CHIP8_EVENT_KEY_WAIT;
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_op_ld_dt_vx(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Set delay timer = Vx.
+    chip->registers.delayTimer = chip->registers.V[ins->x];
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_op_ld_st_vx(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Set sound timer = Vx.
+    if( chip->registers.soundTimer == 0 && chip->registers.V[ins->x] > 0 )
+    {
+        chip->events |= CHIP8_EVENT_SOUND_STARTED;
+    }
+    chip->registers.soundTimer = chip->registers.V[ins->x];
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_op_add_i(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Set I = I + Vx.
+    chip->registers.I = chip->registers.I + chip->registers.V[ins->x];
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_op_ld_f(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Set I = location of sprite for digit Vx
+    chip->registers.I = CHIP8_FONT_ADDR + chip->registers.V[ins->x] * CHIP8_FONT_GLYPH_SIZE;
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_op_ld_hf(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Set I = location of the 8x10 sprite for digit Vx
+    chip->registers.I = CHIP8_BIG_FONT_ADDR + chip->registers.V[ins->x] * CHIP8_BIG_FONT_GLYPH_SIZE;
+    return CHIP8_ERROR_NO;
+}
+
+static chip8_error_t chip_op_ld_b(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Store BCD representation of Vx in memory locations I, I+1, and I+2.
+    uint8_t value = chip->registers.V[ins->x];
+    chip_memory_write(chip, chip->registers.I, value / 100);
+    chip_memory_write(chip, chip->registers.I + 1, value / 10 % 10);
+    return chip_memory_write(chip, chip->registers.I + 2, value % 10);
+}
+
+static chip8_error_t chip_op_ld_mem_regs(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Store registers V0 through Vx in memory starting at location I.
+    chip8_error_t err = CHIP8_ERROR_NO;
+    for(uint32_t itr = 0; itr <= ins->x && err == CHIP8_ERROR_NO; itr++)
+    {
+        err = chip_memory_write(chip, chip->registers.I + itr, chip->registers.V[itr]);
+    }
+    return err;
+}
 
-                case 0x2:   /// Set Vx = Vx AND Vy.
-                    x = (opcode & 0x0F00) >> 8;
-                    y = (opcode & 0x00F0) >> 4;
-                    chip->registers.V[x] &= chip->registers.V[y];
-                    break;
+static chip8_error_t chip_op_ld_regs_mem(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Read registers V0 through Vx from memory starting at location I.
+    chip8_error_t err = CHIP8_ERROR_NO;
+    for(uint32_t itr = 0; itr <= ins->x && err == CHIP8_ERROR_NO; itr++)
+    {
+        err = chip_memory_read(chip, chip->registers.I + itr, &chip->registers.V[itr]);
+    }
+    return err;
+}
 
-                case 0x3:   /// Set Vx = Vx XOR Vy.
-                    x = (opcode & 0x0F00) >> 8;
-                    y = (opcode & 0x00F0) >> 4;
-                    chip->registers.V[x] ^= chip->registers.V[y];
-                    break;
+static chip8_error_t chip_op_ld_flags_regs(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Store registers V0 through Vx in the user flags.
+    memcpy(chip->flags, chip->registers.V, ins->x + 1u);
+    return CHIP8_ERROR_NO;
+}
 
-                case 0x4:   /// Set Vx = Vx + Vy, set VF = carry.
-                    x = (opcode & 0x0F00) >> 8;
-                    y = (opcode & 0x00F0) >> 4;
-                    temp_code = chip->registers.V[x] + chip->registers.V[y];
-                    if(temp_code > 0xFF)
-                    {
-                        chip->registers.V[0xF] = 1;
-                    }
-                    else
-                    {
-                        chip->registers.V[0xF] = 0;
-                    }
-                    chip->registers.V[x] = temp_code;
-                    break;
+static chip8_error_t chip_op_ld_regs_flags(chip8_t *chip, const chip8_decoded_t *ins)
+{
+    /// Read registers V0 through Vx from the user flags.
+    memcpy(chip->registers.V, chip->flags, ins->x + 1u);
+    return CHIP8_ERROR_NO;
+}
 
-                case 0x5:   /// Set Vx = Vx - Vy, set VF = NOT borrow.
-                    x = (opcode & 0x0F00) >> 8;
-                    y = (opcode & 0x00F0) >> 4;
-                    if(chip->registers.V[x] > chip->registers.V[y])
-                    {
-                        chip->registers.V[0xF] = 1;
-                    }
-                    else
-                    {
-                        chip->registers.V[0xF] = 0;
-                    }
-                    chip->registers.V[x] -= chip->registers.V[y];
-                    break;
+/////////////////////////////////////////////////
+/// Dispatch engines
+/////////////////////////////////////////////////
 
-                case 0x6:   /// Set Vx = Vx SHR 1.
-                    x = (opcode & 0x0F00) >> 8;
-                    chip->registers.V[0xF] = chip->registers.V[x] & 0x1;
-                    chip->registers.V[x] /= 2;
-                    break;
+static inline const chip8_decoded_t *chip_fetch_next(chip8_t *chip, uint16_t *pc, chip8_decoded_t *scratch)
+{
+    (*pc) = chip->registers.PC;
+    chip->registers.PC = (*pc) + 2;
+    chip->events = CHIP8_EVENT_NONE;
 
-                case 0x7:   /// Set Vx = Vy - Vx, set VF = NOT borrow.
-                    x = (opcode & 0x0F00) >> 8;
-                    y = (opcode & 0x00F0) >> 4;
-                    if(chip->registers.V[y] > chip->registers.V[x])
-                    {
-                        chip->registers.V[0xF] = 1;
-                    }
-                    else
-                    {
-                        chip->registers.V[0xF] = 0;
-                    }
-                    chip->registers.V[x] = chip->registers.V[y] - chip->registers.V[x];
-                    break;
+    return chip_fetch(chip, *pc, scratch);
+}
 
-                case 0xE:   /// Set Vx = Vx SHL 1.
-                    x = (opcode & 0x0F00) >> 8;
-                    chip->registers.V[0xF] = chip->registers.V[x] & 0x80;
-                    chip->registers.V[x] *= 2;
+static inline bool chip_retire(chip8_t *chip, chip8_error_t err, uint32_t event_mask, uint32_t *raised)
+{
+    if( err != CHIP8_ERROR_NO )
+    {
+        chip->fault = err;
+        chip->events |= CHIP8_EVENT_FAULT;
+    }
 
-                default:
-                    err = CHIP8_ERROR_INVALID_OPCODE;
-                    break;
-            }
+    if( chip->events != CHIP8_EVENT_NONE )
+    {
+        (*raised) |= chip->events;
+        return (chip->events & (event_mask | CHIP8_EVENT_KEY_WAIT)) != 0;
+    }
+
+    return false;
+}
+
+static uint32_t chip_engine_switch(chip8_t *chip, uint32_t cycles, uint32_t event_mask, uint32_t *raised)
+{
+    uint32_t executed = 0;
+    chip8_decoded_t scratch;
+    chip8_error_t err = CHIP8_ERROR_NO;
+    uint16_t pc;
+
+    while( executed < cycles )
+    {
+        const chip8_decoded_t *ins = chip_fetch_next(chip, &pc, &scratch);
+
+        switch( ins->op )
+        {
+#define CHIP8_SWITCH_CASE(id, name) case CHIP8_OP_##id: CHIP8_STATS_EXECUTE(chip, ins->opcode, err = chip_op_##name(chip, ins)); break;
+            CHIP8_OP_LIST(CHIP8_SWITCH_CASE)
+#undef CHIP8_SWITCH_CASE
+            default: err = CHIP8_ERROR_INVALID_OPCODE; break;
+        }
+
+        CHIP8_TRACE_INSTRUCTION(chip, pc, ins->opcode);
+        executed++;
+
+        if( chip_retire(chip, err, event_mask, raised) )
+        {
+            break;
+        }
+    }
+
+    return executed;
+}
+
+static inline bool chip_op_is_pure(uint8_t op)
+{
+    /// Instructions that read nothing but registers, the delay timer and the keys and only write V, I and PC
+    switch( op )
+    {
+        case CHIP8_OP_JP:
+        case CHIP8_OP_SE_IMM:
+        case CHIP8_OP_SNE_IMM:
+        case CHIP8_OP_SE_REG:
+        case CHIP8_OP_SNE_REG:
+        case CHIP8_OP_LD_IMM:
+        case CHIP8_OP_ADD_IMM:
+        case CHIP8_OP_LD_REG:
+        case CHIP8_OP_OR:
+        case CHIP8_OP_AND:
+        case CHIP8_OP_XOR:
+        case CHIP8_OP_ADD_REG:
+        case CHIP8_OP_SUB:
+        case CHIP8_OP_SHR:
+        case CHIP8_OP_SUBN:
+        case CHIP8_OP_SHL:
+        case CHIP8_OP_LD_I:
+        case CHIP8_OP_JP_V0:
+        case CHIP8_OP_SKP:
+        case CHIP8_OP_SKNP:
+        case CHIP8_OP_LD_VX_DT:
+        case CHIP8_OP_ADD_I:
+        case CHIP8_OP_LD_F:
+            return true;
 
-        case 0x9:  /// Skip next instruction if Vx != Vy.
-            x = (opcode & 0x0F00) >> 8;
-            y = (opcode & 0x00F0) >> 4;
-            if(chip->registers.V[x] != chip->registers.V[y])
+        default:
+            return false;
+    }
+}
+
+static uint32_t chip_idle_probe(chip8_t *chip, uint32_t cycles, uint32_t *raised)
+{
+    /// Timers and keys are constant during a run. A loop of pure instructions that comes back to its
+    /// head with the same V and I will repeat that iteration until the run ends, so whole iterations
+    /// are accounted without executing them and the engine runs what is left of the last one.
+    chip8_decoded_t scratch;
+    chip8_registers_t head = chip->registers;
+    uint32_t executed = 0;
+    uint32_t length = 0;
+    uint16_t pc;
+
+    while( executed < CHIP8_IDLE_PROBE_CYCLES )
+    {
+        pc = chip->registers.PC;
+        const chip8_decoded_t *ins = chip_fetch(chip, pc, &scratch);
+        if( !chip_op_is_pure(ins->op) )
+        {
+            break;
+        }
+
+        chip->registers.PC = pc + 2;
+        chip_handlers[ins->op](chip, ins);
+        CHIP8_TRACE_INSTRUCTION(chip, pc, ins->opcode);
+        executed++;
+        length++;
+
+        if( chip->registers.PC == head.PC )
+        {
+            if( memcmp(chip->registers.V, head.V, sizeof(head.V)) == 0 && chip->registers.I == head.I )
             {
-                chip->registers.PC += 2;
+                uint32_t remaining = cycles - executed;
+                uint32_t skipped = remaining - remaining % length;
+
+                chip->scheduler.idleCycles += skipped;
+                (*raised) |= CHIP8_EVENT_IDLE;
+                return executed + skipped;
             }
-            break;
 
-        case 0xA:   /// Set I = NNN
-            chip->registers.I = opcode & 0x0FFF;
+            /// The first pass usually settles the registers (FX07 picks up the timer), try one more
+            head = chip->registers;
+            length = 0;
+        }
+        else if( ins->op == CHIP8_OP_JP && chip->registers.PC < pc )
+        {
+            /// Entered ahead of the loop, its backward jump gives the head
+            head = chip->registers;
+            length = 0;
+        }
+    }
+
+    return executed;
+}
+
+static uint32_t chip_run_slice(chip8_t *chip, uint32_t cycles, uint32_t event_mask, uint32_t *events)
+{
+    uint32_t executed = 0;
+    uint32_t probed = 0;
+    uint32_t raised = 0;
+
+    /// A parked VM returns straight away instead of spinning on FX0A
+    if( chip->keyWait )
+    {
+        if( events != NULL )
+        {
+            (*events) = CHIP8_EVENT_KEY_WAIT;
+        }
+        return 0;
+    }
+
+    /// A spin loop settles in a few iterations, the rest of the run is accounted without executing it
+    if( cycles >= CHIP8_IDLE_MIN_BUDGET && !CHIP8_TRACE_ACTIVE(chip) && !CHIP8_STATS_ACTIVE(chip) )
+    {
+        probed = chip_idle_probe(chip, cycles, &raised);
+        cycles -= probed;
+    }
+
+    switch( chip->engine )
+    {
+#if CHIP8_HAS_COMPUTED_GOTO
+        case CHIP8_ENGINE_GOTO:
+            executed = chip_engine_goto(chip, cycles, event_mask, &raised);
             break;
+#endif
 
-        case 0xB:   /// Jump to location NNN + V0.
-            chip->registers.PC = (opcode & 0x0FFF) + chip->registers.V[0];
+#if CHIP8_HAS_MUSTTAIL
+        case CHIP8_ENGINE_TAILCALL:
+            executed = chip_engine_tailcall(chip, cycles, event_mask, &raised);
             break;
+#endif
 
-        case 0xC:   /// Set Vx = random byte AND NN.
-            x = (opcode & 0x0F00) >> 8;
-            kk = opcode & 0x00FF;
-            srand(clock());
-            chip->registers.V[x] = (rand() % 0xFF) & kk;
+#if CHIP8_HAS_JIT
+        case CHIP8_ENGINE_JIT:
+            executed = chip_engine_jit(chip, cycles, event_mask, &raised);
             break;
+#endif
 
-        case 0xD:   /// Display n-byte sprite starting at memory location I at (Vx, Vy), set VF = collision.
-            x = (opcode & 0x0F00) >> 8;
-            y = (opcode & 0x00F0) >> 4;
-            n = opcode & 0x000F;
-            sprite = &chip->memory[chip->registers.I];
-            chip->registers.V[0xF] = chip_draw_sprite(chip, chip->registers.V[x], chip->registers.V[y], sprite, n);
+        default:
+            executed = chip_engine_switch(chip, cycles, event_mask, &raised);
             break;
+    }
 
-        case 0xE:
-        {
-            temp_code = opcode & 0x00FF;
-            switch(temp_code)
-            {
-                case 0x9E: /// Skip next instruction if key with the value of Vx is pressed.
-                    ///TODO: Implement keyboard logic
-                    break;
+    executed += probed;
+    chip->scheduler.cycles += executed;
 
-                case 0xA1: /// Skip next instruction if key with the value of Vx is not pressed.
-                    ///TODO: Implement keyboard logic
-                    break;
+    if( events != NULL )
+    {
+        (*events) = raised;
+    }
 
-                default:
-                    err = CHIP8_ERROR_INVALID_OPCODE;
-                    break;
-            }
+    return executed;
+}
+
+static uint32_t chip_run_profiled(chip8_t *chip, uint32_t cycles, uint32_t event_mask, uint32_t *events)
+{
+    chip8_profile_t *profile = chip->profile;
+    uint32_t executed = 0;
+    uint32_t raised = 0;
+
+    while( executed < cycles )
+    {
+        /// Sampled before the slice, PC is the instruction about to run
+        if( profile->countdown == 0 )
+        {
+            chip_profile_sample(chip);
         }
 
-        case 0xF:
+        uint32_t slice = cycles - executed;
+        if( slice > profile->countdown )
         {
-            temp_code = opcode & 0x00FF;
-            switch(temp_code)
-            {
-                case 0x07:  /// Set Vx = delay timer value.
-                    x = (opcode & 0x0F00) >> 8;
-                    chip->registers.V[x] = chip->registers.delayTimer;
-                    break;
+            slice = profile->countdown;
+        }
 
-                case 0x0A:  /// Wait for a key press, store the value of the key in Vx.
-                    ///TODO: Implement keyboard logic
-                    break;
+        uint32_t slice_events = CHIP8_EVENT_NONE;
+        uint32_t done = chip_run_slice(chip, slice, event_mask, &slice_events);
 
-                case 0x15:  /// Set delay timer = Vx.
-                    x = (opcode & 0x0F00) >> 8;
-                    chip->registers.delayTimer = chip->registers.V[x];
-                    break;
+        executed += done;
+        profile->countdown -= done;
+        raised |= slice_events;
 
-                case 0x18:  /// Set sound timer = Vx.
-                    x = (opcode & 0x0F00) >> 8;
-                    chip->registers.soundTimer = chip->registers.V[x];
-                    break;
+        if( done < slice || (slice_events & (event_mask | CHIP8_EVENT_KEY_WAIT)) != 0 )
+        {
+            break;
+        }
+    }
 
-                case 0x1E:  /// Set I = I + Vx.
-                    x = (opcode & 0x0F00) >> 8;
-                    chip->registers.I = chip->registers.I + chip->registers.V[x];
-                    break;
+    if( events != NULL )
+    {
+        (*events) = raised;
+    }
 
-                case  0x29: /// Set I = location of sprite for digit Vx
-                    x = (opcode & 0x0F00) >> 8;
-                    chip->registers.I = chip->registers.V[x] * 5;
-                    break;
+    return executed;
+}
 
-                case 0x33:  /// Store BCD representation of Vx in memory locations I, I+1, and I+2.
-                    x = (opcode & 0x0F00) >> 8;
-                    hundreds = chip->registers.V[x] / 100;
-                    tens = chip->registers.V[x] / 10 % 10;
-                    units = chip->registers.V[x] % 10;
-                    chip_memory_write(chip, chip->registers.I, hundreds);
-                    chip_memory_write(chip, chip->registers.I+1, hundreds);
-                    chip_memory_write(chip, chip->registers.I+2, hundreds);
-                    break;
+#if CHIP8_HAS_COMPUTED_GOTO
+static uint32_t chip_engine_goto(chip8_t *chip, uint32_t cycles, uint32_t event_mask, uint32_t *raised)
+{
+    static void *const labels[CHIP8_OP_TOTAL] =
+    {
+#define CHIP8_GOTO_LABEL(id, name) [CHIP8_OP_##id] = &&op_##name,
+        CHIP8_OP_LIST(CHIP8_GOTO_LABEL)
+#undef CHIP8_GOTO_LABEL
+    };
+
+    uint32_t executed = 0;
+    chip8_decoded_t scratch;
+    const chip8_decoded_t *ins;
+    chip8_error_t err;
+    uint16_t pc;
+
+    if( cycles == 0 )
+    {
+        return 0;
+    }
 
-                case 0x55:  /// Store registers V0 through Vx in memory starting at location I.
-                    x = (opcode & 0x0F00) >> 8;
-                    for(uint32_t itr = 0; itr < x; itr++)
-                    {
-                        chip_memory_write(chip, chip->registers.I+itr, chip->registers.V[itr]);
-                    }
-                    break;
+    ins = chip_fetch_next(chip, &pc, &scratch);
+    goto *labels[ins->op];
+
+    /// Every handler ends with its own copy of the dispatch so each indirect jump is predicted separately
+#define CHIP8_GOTO_HANDLER(id, name)                                \
+    op_##name:                                                      \
+        CHIP8_STATS_EXECUTE(chip, ins->opcode, err = chip_op_##name(chip, ins)); \
+        CHIP8_TRACE_INSTRUCTION(chip, pc, ins->opcode);             \
+        executed++;                                                 \
+        if( chip_retire(chip, err, event_mask, raised) || executed == cycles ) \
+        {                                                           \
+            return executed;                                        \
+        }                                                           \
+        ins = chip_fetch_next(chip, &pc, &scratch);                 \
+        goto *labels[ins->op];
+
+    CHIP8_OP_LIST(CHIP8_GOTO_HANDLER)
+#undef CHIP8_GOTO_HANDLER
+}
+#endif
 
-                case 0x65:  /// Read registers V0 through Vx from memory starting at location I.
-                    x = (opcode & 0x0F00) >> 8;
-                    for(uint32_t itr = 0; itr < x; itr++)
-                    {
-                        chip_memory_read(chip, chip->registers.I+itr, &chip->registers.V[itr]);
-                    }
-                    break;
+#if CHIP8_HAS_MUSTTAIL
+typedef struct CHIP8_TAIL_CONTEXT_STRUCT
+{
+    chip8_decoded_t scratch;
+    uint32_t        eventMask;
+    uint32_t        *raised;
+    uint16_t        pc;
 
-                default:
-                    err = CHIP8_ERROR_INVALID_OPCODE;
-                    break;
+} chip8_tail_context_t;
+
+typedef uint32_t (*chip8_tail_handler_t)(chip8_t *chip, const chip8_decoded_t *ins, uint32_t remaining, chip8_tail_context_t *ctx);
+
+#define CHIP8_TAIL_PROTOTYPE(id, name) \
+    static uint32_t chip_tail_##name(chip8_t *chip, const chip8_decoded_t *ins, uint32_t remaining, chip8_tail_context_t *ctx);
+CHIP8_OP_LIST(CHIP8_TAIL_PROTOTYPE)
+#undef CHIP8_TAIL_PROTOTYPE
+
+static const chip8_tail_handler_t chip_tail_handlers[CHIP8_OP_TOTAL] =
+{
+#define CHIP8_TAIL_ENTRY(id, name) [CHIP8_OP_##id] = chip_tail_##name,
+    CHIP8_OP_LIST(CHIP8_TAIL_ENTRY)
+#undef CHIP8_TAIL_ENTRY
+};
+
+/// Each handler tail calls the next one, the remaining budget is returned when the chain stops
+#define CHIP8_TAIL_HANDLER(id, name)                                                            \
+    static uint32_t chip_tail_##name(chip8_t *chip, const chip8_decoded_t *ins, uint32_t remaining, chip8_tail_context_t *ctx) \
+    {                                                                                           \
+        chip8_error_t err;                                                                      \
+        CHIP8_STATS_EXECUTE(chip, ins->opcode, err = chip_op_##name(chip, ins));                \
+        CHIP8_TRACE_INSTRUCTION(chip, ctx->pc, ins->opcode);                                    \
+        remaining--;                                                                            \
+        if( chip_retire(chip, err, ctx->eventMask, ctx->raised) || remaining == 0 )             \
+        {                                                                                       \
+            return remaining;                                                                   \
+        }                                                                                       \
+        ins = chip_fetch_next(chip, &ctx->pc, &ctx->scratch);                                   \
+        CHIP8_MUSTTAIL return chip_tail_handlers[ins->op](chip, ins, remaining, ctx); \
+    }
+CHIP8_OP_LIST(CHIP8_TAIL_HANDLER)
+#undef CHIP8_TAIL_HANDLER
+
+static uint32_t chip_engine_tailcall(chip8_t *chip, uint32_t cycles, uint32_t event_mask, uint32_t *raised)
+{
+    chip8_tail_context_t ctx;
+    const chip8_decoded_t *ins;
+
+    if( cycles == 0 )
+    {
+        return 0;
+    }
+
+    ctx.eventMask = event_mask;
+    ctx.raised = raised;
+
+    ins = chip_fetch_next(chip, &ctx.pc, &ctx.scratch);
+    return cycles - chip_tail_handlers[ins->op](chip, ins, cycles, &ctx);
+}
+#endif
+
+#if CHIP8_HAS_JIT
+static uint32_t chip_engine_jit(chip8_t *chip, uint32_t cycles, uint32_t event_mask, uint32_t *raised)
+{
+    uint32_t executed = 0;
+
+    while( executed < cycles )
+    {
+        /// Translated blocks are not traced or counted, interpret while a session is running
+        if( !CHIP8_TRACE_ACTIVE(chip) && !CHIP8_STATS_ACTIVE(chip) )
+        {
+            executed += chip_jit_execute(chip, cycles - executed);
+            if( executed >= cycles )
+            {
+                break;
             }
         }
 
-        default:
-            err = CHIP8_ERROR_INVALID_OPCODE;
+        /// Untranslatable instruction or a block larger than the remaining budget
+        executed += chip_engine_switch(chip, 1, event_mask, raised);
+        if( (chip->events & (event_mask | CHIP8_EVENT_KEY_WAIT)) != 0 )
+        {
             break;
+        }
+    }
+
+    return executed;
+}
+#endif
+
+static chip8_error_t chip_scheduler_tick(chip8_t *chip)
+{
+    chip8_scheduler_t *sched = &chip->scheduler;
+    chip8_error_t err = CHIP8_ERROR_NO;
+    uint32_t events = CHIP8_EVENT_NONE;
+    uint64_t start_cycles = sched->cycles;
+    uint64_t now = chip_get_time_us();
+
+    if( sched->ips == CHIP8_IPS_UNBOUNDED )
+    {
+        /// Run batches until the host time slice for this tick is used up, an idle VM gives the rest back
+        uint64_t deadline = now + sched->sliceUs;
+
+        do
+        {
+            CHIP8_RunUntil(chip, CHIP8_UNBOUNDED_BATCH, CHIP8_EVENT_FAULT, &events);
+            now = chip_get_time_us();
+        } while( (events & (CHIP8_EVENT_FAULT | CHIP8_EVENT_KEY_WAIT | CHIP8_EVENT_IDLE)) == 0 && now < deadline );
+    }
+    else
+    {
+        /// Spread ips over the ticks, carrying the remainder so a second is exact
+        uint32_t total = sched->ips + sched->ipsRemainder;
+        uint32_t budget = total / CHIP8_TIMER_FREQUENCY_HZ;
+        sched->ipsRemainder = total % CHIP8_TIMER_FREQUENCY_HZ;
+
+        CHIP8_RunUntil(chip, budget, CHIP8_EVENT_FAULT, &events);
+        now = chip_get_time_us();
+    }
+
+    if( (events & CHIP8_EVENT_FAULT) != 0 )
+    {
+        err = chip->fault;
+    }
+    else if( chip->keyWait )
+    {
+        err = CHIP8_ERROR_WAITING_FOR_KEY;
+    }
+
+    chip_timers_tick(chip);
+    sched->ticks++;
+
+    if( chip->movie != NULL )
+    {
+        chip_movie_tick(chip);
+    }
+
+    /// Update the achieved IPS once per wall clock second
+    sched->windowCycles += sched->cycles - start_cycles;
+    if( sched->windowStartUs == 0 )
+    {
+        sched->windowStartUs = now;
+    }
+    else if( now - sched->windowStartUs >= CHIP8_US_PER_SECOND )
+    {
+        sched->achievedIps = (uint32_t)(sched->windowCycles * CHIP8_US_PER_SECOND / (now - sched->windowStartUs));
+        sched->windowStartUs = now;
+        sched->windowCycles = 0;
     }
 
     return err;
 }
 
+static void chip_timers_tick(chip8_t *chip)
+{
+    if( chip->registers.delayTimer > 0 )
+    {
+        chip->registers.delayTimer--;
+    }
+
+    if( chip->registers.soundTimer > 0 )
+    {
+        chip->registers.soundTimer--;
+    }
+}
+
+/// Same effect as ticks scheduler ticks of a parked VM
+static void chip_wait_ticks(chip8_t *chip, uint32_t ticks)
+{
+    chip8_scheduler_t *sched = &chip->scheduler;
+
+    chip->registers.delayTimer = (chip->registers.delayTimer > ticks) ? (uint8_t)(chip->registers.delayTimer - ticks) : 0;
+    chip->registers.soundTimer = (chip->registers.soundTimer > ticks) ? (uint8_t)(chip->registers.soundTimer - ticks) : 0;
+
+    if( sched->ips != CHIP8_IPS_UNBOUNDED )
+    {
+        sched->ipsRemainder = (uint32_t)((sched->ipsRemainder + (uint64_t)sched->ips * ticks) % CHIP8_TIMER_FREQUENCY_HZ);
+    }
+    sched->ticks += ticks;
+}
+
+static uint64_t chip_get_time_us(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+
+    return (uint64_t)ts.tv_sec * CHIP8_US_PER_SECOND + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static uint8_t chip_keymap_lookup(const chip8_keymap_t *keymap, uint32_t key)
+{
+    if( keymap == NULL )
+    {
+        return CHIP8_KEYMAP_UNMAPPED;
+    }
+
+    if( key < CHIP8_KEYMAP_HOST_KEYS )
+    {
+        return keymap->reverse[key];
+    }
+
+    /// Codes past the table are rare (scancodes, gamepads), search the map
+    for(uint32_t itr = 0; itr < CHIP8_KEY_ID_TOTAL; itr++)
+    {
+        if( keymap->map[itr] == key )
+        {
+            return (uint8_t)itr;
+        }
+    }
+
+    return CHIP8_KEYMAP_UNMAPPED;
+}
+
+static void chip_input_drain(chip8_t *chip)
+{
+    chip8_input_t *input = &chip->input;
+    uint32_t tail = atomic_load_explicit(&input->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&input->head, memory_order_acquire);
+
+    if( head == tail )
+    {
+        return;
+    }
+
+    uint64_t now = chip_get_time_us();
+    uint16_t changed = 0;
+    for(; tail != head; tail++)
+    {
+        const chip8_key_event_t *event = &input->ring[tail & (CHIP8_INPUT_QUEUE_SIZE - 1)];
+
+        /// A second transition of the same key waits for the next run, so a tap is held for at least one run
+        if( (changed >> event->id) & 1 )
+        {
+            break;
+        }
+        changed |= (uint16_t)(1u << event->id);
+
+        CHIP8_SetKeyId(chip, (chip8_key_id_t)event->id, event->state);
+        input->latencyUs = (uint32_t)(now - event->timestampUs);
+    }
+
+    atomic_store_explicit(&input->tail, tail, memory_order_release);
+}
+
+static inline uint64_t chip_rotr64(uint64_t value, uint32_t shift)
+{
+    return (value >> shift) | (value << ((64 - shift) & 63));
+}
+
+static inline void chip_rotr128(uint64_t *left, uint64_t *right, uint32_t shift)
+{
+    /// Whole word swap first, then a funnel shift across the two words
+    if( shift >= 64 )
+    {
+        uint64_t word = *left;
+        *left = *right;
+        *right = word;
+        shift -= 64;
+    }
+
+    if( shift != 0 )
+    {
+        uint64_t word = *left;
+        *left = (word >> shift) | (*right << (64 - shift));
+        *right = (*right >> shift) | (word << (64 - shift));
+    }
+}
+
+static inline uint8_t chip_random_byte(chip8_t *chip)
+{
+    /// xorshift64*, the top byte of the product is uniform over 0..255
+    uint64_t x = chip->rng;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    chip->rng = x;
+
+    return (uint8_t)((x * 0x2545F4914F6CDD1DULL) >> 56);
+}
+
 static uint16_t chip_get_opcode(chip8_t *chip, uint16_t index)
 {
     uint8_t byte[2] = {0};
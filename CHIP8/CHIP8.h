@@ -7,6 +7,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdatomic.h>
 
 /////////////////////////////////////////////////
 /// Defines
@@ -16,10 +17,34 @@
 #define CHIP8_STACK_DEPTH_TOTAL 16
 #define CHIP8_MEMORY_SIZE 4096
 
-#define CHIP8_WIDTH_SCREEN  64
-#define CHIP8_HEIGHT_SCREEN 32
+#define CHIP8_WIDTH_SCREEN  128     /// SCHIP high resolution, the size of the framebuffer
+#define CHIP8_HEIGHT_SCREEN 64
+#define CHIP8_LORES_WIDTH_SCREEN    64  /// CHIP-8 resolution, the top left corner of the framebuffer
+#define CHIP8_LORES_HEIGHT_SCREEN   32
+#define CHIP8_SCREEN_ROW_WORDS      (CHIP8_WIDTH_SCREEN / 64)   /// 64-bit words per packed row
+#define CHIP8_FLAG_REGISTERS_TOTAL  16  /// SCHIP user flags kept by FX75 and restored by FX85
 
 #define CHIP8_PROGRAM_START_ADDR 0x200
+#define CHIP8_FONT_ADDR             0x000       /// 16 glyphs of 4x5 pixels used by FX29
+#define CHIP8_FONT_GLYPH_SIZE       5
+#define CHIP8_FONT_SIZE             (16 * CHIP8_FONT_GLYPH_SIZE)
+#define CHIP8_BIG_FONT_ADDR         (CHIP8_FONT_ADDR + CHIP8_FONT_SIZE)     /// 16 SCHIP glyphs of 8x10 pixels
+#define CHIP8_BIG_FONT_GLYPH_SIZE   10
+#define CHIP8_BIG_FONT_SIZE         (16 * CHIP8_BIG_FONT_GLYPH_SIZE)
+#define CHIP8_DECODE_CACHE_ENTRIES  ((CHIP8_MEMORY_SIZE - CHIP8_PROGRAM_START_ADDR) / 2)
+
+#define CHIP8_TIMER_FREQUENCY_HZ    60          /// Delay and sound timers rate
+#define CHIP8_DEFAULT_IPS           700         /// Default instructions per second
+#define CHIP8_IPS_UNBOUNDED         0           /// Run as many instructions as the host allows
+#define CHIP8_UNBOUNDED_SLICE_US    8000        /// Host time per tick given to an unbounded VM
+#define CHIP8_MAX_TICKS_PER_UPDATE  4           /// Ticks a single update may catch up after a host stall
+
+#define CHIP8_DEFAULT_SEED          0x43484950385F524EULL  /// CXNN seed used when none is configured
+#define CHIP8_SAMPLE_STEP           0x9E3779B9u /// Golden ratio step of the samplers, a ROM loop cannot alias with their sample points
+
+#define CHIP8_KEYMAP_HOST_KEYS      512         /// Host key codes below this are translated through a table
+#define CHIP8_KEYMAP_UNMAPPED       0xFF
+#define CHIP8_INPUT_QUEUE_SIZE      64          /// Pending key events, must be a power of two
 
 /////////////////////////////////////////////////
 /// Typedef enumerations
@@ -36,9 +61,36 @@ typedef enum CHIP8_ERROR_TYPE
     CHIP8_ERROR_SCREEN_INVALID_COORDINATES,
     CHIP8_ERROR_DATA_OVERSIZE,
     CHIP8_ERROR_INVALID_OPCODE,
+    CHIP8_ERROR_NOT_SUPPORTED,
+    CHIP8_ERROR_INVALID_STATE,
+    CHIP8_ERROR_DESYNC,
+    CHIP8_ERROR_WAITING_FOR_KEY,    /// Not a fault, the VM is parked in FX0A until a key is pressed and released
+    CHIP8_ERROR_EXIT,               /// 00FD ended the program, PC stays on it so every further run stops there again
 
 } chip8_error_t;
 
+typedef enum CHIP8_EVENT_TYPE
+{
+    CHIP8_EVENT_NONE            = 0,
+    CHIP8_EVENT_SCREEN_CHANGED  = (1 << 0),     /// A clear, draw, scroll or resolution switch modified the screen
+    CHIP8_EVENT_SOUND_STARTED   = (1 << 1),     /// FX18 started the sound timer
+    CHIP8_EVENT_KEY_WAIT        = (1 << 2),     /// FX0A parked the VM, always ends a run
+    CHIP8_EVENT_FAULT           = (1 << 3),     /// Instruction returned an error
+    CHIP8_EVENT_IDLE            = (1 << 4),     /// The run was fast-forwarded through a loop only a timer tick or a key can leave
+
+    CHIP8_EVENT_ALL             = 0x1F
+} chip8_event_t;
+
+typedef enum CHIP8_ENGINE_TYPE
+{
+    CHIP8_ENGINE_SWITCH = 0,    /// Portable switch over the decoded instruction
+    CHIP8_ENGINE_GOTO,          /// Threaded code with computed goto (GCC/Clang)
+    CHIP8_ENGINE_TAILCALL,      /// Threaded code with guaranteed tail calls (musttail)
+    CHIP8_ENGINE_JIT,           /// x86-64 basic block translation, interpreter fallback
+
+    CHIP8_ENGINE_TOTAL
+} chip8_engine_t;
+
 typedef enum CHIP8_KEYBOARD_INDEX_TYPE
 {
     CHIP8_KEY_ID_0 = 0,
@@ -67,7 +119,7 @@ typedef enum CHIP8_KEYBOARD_INDEX_TYPE
 
 typedef uint8_t chip8_mem_t[CHIP8_MEMORY_SIZE];
 typedef uint16_t chip8_stack_t[CHIP8_STACK_DEPTH_TOTAL];
-typedef bool chip8_keyboard_t[CHIP8_KEY_ID_TOTAL];
+typedef uint16_t chip8_keyboard_t;     /// Bit n is set while key n is pressed
 
 /////////////////////////////////////////////////
 /// Typedef structures
@@ -84,24 +136,127 @@ typedef struct CHIP8_REGISTERS_STRUCT
 
 } chip8_registers_t;
 
+typedef struct CHIP8_SCHEDULER_STRUCT
+{
+    uint32_t    ips;            /// Instructions per second or CHIP8_IPS_UNBOUNDED
+    uint32_t    sliceUs;        /// Host time per tick used in unbounded mode
+    uint32_t    ipsRemainder;   /// Instructions carried over between ticks (in 1/60 units)
+    uint64_t    timeAccum;      /// Host time not yet consumed by a tick (microseconds * 60)
+    uint64_t    cycles;         /// Total executed instructions
+    uint64_t    ticks;          /// Total executed 60 Hz ticks
+    uint64_t    windowStartUs;  /// Wall clock start of the IPS measurement window
+    uint64_t    windowCycles;   /// Instructions executed inside the window
+    uint32_t    achievedIps;    /// Instructions per wall clock second of the last window
+    uint64_t    idleCycles;     /// Instructions of cycles that were fast-forwarded instead of executed
+
+} chip8_scheduler_t;
+
+/// Packed 128 pixel rows of two 64-bit words, word 0 is the left half and the most significant bit of a word
+/// is its leftmost pixel. In low resolution only word 0 of the first 32 rows is used, the rest stays clear.
 typedef struct CHIP8_SCREEN_STRUCT
 {
-    bool buffer[CHIP8_HEIGHT_SCREEN][CHIP8_WIDTH_SCREEN];
+    uint64_t rows[CHIP8_HEIGHT_SCREEN][CHIP8_SCREEN_ROW_WORDS];
+    uint64_t dirtyRows;     /// Rows changed since CHIP8_ClearDirty, bit n is row n
+    uint64_t dirtyColumns[CHIP8_SCREEN_ROW_WORDS];  /// Union of the changed pixels of the dirty rows, same layout as a row
+    uint32_t generation;    /// Incremented by every draw, clear, scroll or resolution switch that changed a pixel
+    bool     hires;         /// 128x64 after 00FF, 64x32 after 00FE and at reset
 } chip8_screen_t;
 
+/// Read-only view of the live framebuffer, valid until the VM is deinitialized
+typedef struct CHIP8_FRAMEBUFFER_STRUCT
+{
+    const uint64_t  *rows;      /// Packed rows of 64-bit words in host byte order, the most significant bit is the leftmost pixel
+    uint16_t        width;      /// Pixels per row of the active resolution, 64 or 128
+    uint16_t        height;     /// Rows of the active resolution, 32 or 64
+    uint16_t        stride;     /// Bytes from one row to the next
+
+} chip8_framebuffer_t;
+
+/// Pixel rectangle in screen coordinates
+typedef struct CHIP8_RECT_STRUCT
+{
+    uint16_t x;
+    uint16_t y;
+    uint16_t width;
+    uint16_t height;
+} chip8_rect_t;
+
 typedef struct CHIP8_KEYMAP_STRUCT
 {
-    uint32_t map[CHIP8_KEY_ID_TOTAL];
+    uint32_t map[CHIP8_KEY_ID_TOTAL];               /// Host key code of every CHIP-8 key
+    uint8_t  reverse[CHIP8_KEYMAP_HOST_KEYS];       /// CHIP-8 key of every host key code or CHIP8_KEYMAP_UNMAPPED
 } chip8_keymap_t;
 
+typedef struct CHIP8_KEY_EVENT_STRUCT
+{
+    uint64_t    timestampUs;    /// Host time of the push
+    uint8_t     id;             /// chip8_key_id_t
+    bool        state;
+
+} chip8_key_event_t;
+
+/// Single producer (the input thread) single consumer (the VM) queue of key transitions
+typedef struct CHIP8_INPUT_STRUCT
+{
+    chip8_key_event_t   ring[CHIP8_INPUT_QUEUE_SIZE];
+    _Atomic uint32_t    head;       /// Next slot written by the producer
+    _Atomic uint32_t    tail;       /// Next slot drained by the VM
+    _Atomic uint32_t    dropped;    /// Events lost because the queue was full
+    uint32_t            latencyUs;  /// Push to delivery time of the last drained event
+
+} chip8_input_t;
+
+/// Optional settings applied by CHIP8_InitWithConfig, zero fields select the defaults
+typedef struct CHIP8_CONFIG_STRUCT
+{
+    const uint8_t   *font;      /// CHIP8_FONT_SIZE bytes replacing the built-in font or NULL
+    const uint8_t   *bigFont;   /// CHIP8_BIG_FONT_SIZE bytes replacing the built-in big font or NULL
+    uint64_t        seed;       /// CXNN random seed, 0 selects CHIP8_DEFAULT_SEED
+
+} chip8_config_t;
+
+struct CHIP8_TRACE_STRUCT;
+struct CHIP8_STATS_STRUCT;
+struct CHIP8_PROFILE_STRUCT;
+struct CHIP8_JIT_STRUCT;
+struct CHIP8_MOVIE_STRUCT;
+
+/// Pre-decoded instruction, one per even address of the program region, 8 bytes so the cache stays small
+typedef struct CHIP8_DECODED_STRUCT
+{
+    uint16_t        opcode;
+    uint16_t        nnn;        /// Low 12 bits, NN and N are taken from it
+    uint8_t         x;
+    uint8_t         y;
+    uint8_t         op;         /// Handler index used by the dispatch engines and the handler table
+
+} chip8_decoded_t;
+
 typedef struct CHIP8_STRUCT
 {
     chip8_mem_t         memory;
     chip8_registers_t   registers;
     chip8_stack_t       stack;
+    uint8_t             flags[CHIP8_FLAG_REGISTERS_TOTAL];  /// SCHIP user flags
     chip8_screen_t      screen;
-    chip8_keyboard_t    key;
+    chip8_keyboard_t    keys;
+    chip8_input_t       input;
     chip8_keymap_t      *keymap;
+    chip8_scheduler_t   scheduler;
+    uint32_t            events;     /// Events raised by the last executed instruction
+    chip8_error_t       fault;      /// Error of the last faulting instruction
+    bool                keyWait;        /// Parked in FX0A, no instruction runs until a key is pressed and released
+    uint8_t             keyWaitReg;     /// Register FX0A stores the key in
+    uint16_t            keyWaitPressed; /// Keys pressed during the wait, releasing one of them resumes
+    chip8_engine_t      engine;     /// Dispatch engine used by the run loops
+    uint64_t            rng;        /// xorshift64* state used by CXNN, never zero
+    struct CHIP8_TRACE_STRUCT *trace;   /// Active trace session, only used with CHIP8_TRACE
+    struct CHIP8_STATS_STRUCT *stats;   /// Active statistics session, only used with CHIP8_STATS
+    struct CHIP8_PROFILE_STRUCT *profile; /// Active profiling session or NULL
+    struct CHIP8_JIT_STRUCT   *jit;     /// Code cache, allocated when the JIT engine is selected
+    struct CHIP8_MOVIE_STRUCT *movie;   /// Active input recording or NULL
+    chip8_decoded_t     decoded[CHIP8_DECODE_CACHE_ENTRIES];
+
 
 } chip8_t;
 
@@ -110,12 +265,48 @@ typedef struct CHIP8_STRUCT
 /////////////////////////////////////////////////
 
 chip8_error_t CHIP8_Init(chip8_t *chip, chip8_keymap_t *keymap, uint8_t *program_buff, uint32_t size);
+chip8_error_t CHIP8_InitWithConfig(chip8_t *chip, const chip8_config_t *config, chip8_keymap_t *keymap, uint8_t *program_buff, uint32_t size);
+void CHIP8_Deinit(chip8_t *chip);
+/// Executes one instruction, returns its fault or CHIP8_ERROR_WAITING_FOR_KEY while the VM is parked in FX0A
 chip8_error_t CHIP8_Run(chip8_t *chip);
+uint32_t CHIP8_RunCycles(chip8_t *chip, uint32_t cycles);
+uint32_t CHIP8_RunUntil(chip8_t *chip, uint32_t cycles, uint32_t event_mask, uint32_t *events);
+chip8_error_t CHIP8_GetFault(chip8_t *chip);
+
+chip8_error_t CHIP8_SetEngine(chip8_t *chip, chip8_engine_t engine);
+void CHIP8_SetSeed(chip8_t *chip, uint64_t seed);
+bool CHIP8_IsEngineSupported(chip8_engine_t engine);
+const char *CHIP8_GetEngineName(chip8_engine_t engine);
+
+/// CHIP8_IPS_UNBOUNDED is rejected with CHIP8_ERROR_NOT_SUPPORTED while a movie is recorded
+chip8_error_t CHIP8_SetSpeed(chip8_t *chip, uint32_t ips);
+chip8_error_t CHIP8_Update(chip8_t *chip, uint32_t elapsed_us);
+chip8_error_t CHIP8_RunFrame(chip8_t *chip);
+/// Runs frames ticks like CHIP8_RunFrame, the ticks a parked VM spends waiting for a key are skipped in O(1)
+chip8_error_t CHIP8_RunFrames(chip8_t *chip, uint32_t frames);
+bool CHIP8_IsWaitingForKey(chip8_t *chip);
+uint32_t CHIP8_GetAchievedIps(chip8_t *chip);
 
 bool CHIP8_DrawSprite(chip8_t *chip, uint16_t x, uint16_t y, uint8_t *sprite, uint32_t num);
 bool CHIP8_IsPixelSet(chip8_t *chip, uint16_t x, uint16_t y);
+void CHIP8_GetFramebuffer(chip8_t *chip, chip8_framebuffer_t *framebuffer);
+uint64_t CHIP8_ScreenHash(chip8_t *chip);
+uint32_t CHIP8_GetScreenGeneration(chip8_t *chip);
+bool CHIP8_GetDirtyRegion(chip8_t *chip, uint64_t *rows, chip8_rect_t *rect);
+void CHIP8_ClearDirty(chip8_t *chip);
+
+/// Fills keymap->reverse from keymap->map, CHIP8_Init does it for the keymap it is given
+void CHIP8_KeymapBuild(chip8_keymap_t *keymap);
 
+/// key is a host key code translated through the keymap given to CHIP8_Init, the VM sees it immediately
 chip8_error_t CHIP8_SetKey(chip8_t *chip, uint32_t key, bool state);
+chip8_error_t CHIP8_SetKeyId(chip8_t *chip, chip8_key_id_t id, bool state);
+/// Queues a transition from the input thread, the VM applies it between instructions at the start of
+/// its next CHIP8_RunUntil (also called by CHIP8_Run, CHIP8_RunFrame and CHIP8_Update). Each run applies
+/// at most one transition per key, a press and release queued together are seen for a whole run (a frame
+/// under CHIP8_RunFrame). Safe to call from one thread while another one runs the VM.
+chip8_error_t CHIP8_PushKeyEvent(chip8_t *chip, uint32_t key, bool state);
+uint16_t CHIP8_GetKeys(chip8_t *chip);
 
 uint8_t CHIP8_GetDelayTimer(chip8_t *chip);
 uint8_t CHIP8_GetSoundTimer(chip8_t *chip);
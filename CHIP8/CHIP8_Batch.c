@@ -0,0 +1,281 @@
+/////////////////////////////////////////////////
+/// Includes
+/////////////////////////////////////////////////
+
+#define _POSIX_C_SOURCE 200809L     /// sysconf
+
+#include "CHIP8_Batch.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/////////////////////////////////////////////////
+/// Prototype static functions
+/////////////////////////////////////////////////
+
+static void *batch_worker_thread(void *arg);
+static void batch_work(chip8_batch_t *batch, uint32_t self);
+static void batch_run_instance(chip8_batch_t *batch, uint32_t index);
+static uint32_t batch_host_cores(void);
+
+/////////////////////////////////////////////////
+/// Public functions
+/////////////////////////////////////////////////
+
+chip8_error_t CHIP8_BatchCreate(chip8_batch_t **pbatch, uint32_t instances, uint32_t threads)
+{
+    chip8_batch_t *batch = NULL;
+
+    if( pbatch == NULL || instances == 0 )
+    {
+        return CHIP8_ERROR_INIT;
+    }
+
+    if( threads == CHIP8_BATCH_AUTO_THREADS )
+    {
+        threads = batch_host_cores();
+    }
+    if( threads > instances )
+    {
+        threads = instances;
+    }
+
+    batch = (chip8_batch_t *)calloc(1, sizeof(chip8_batch_t));
+    if( batch == NULL )
+    {
+        return CHIP8_ERROR_INIT;
+    }
+
+    batch->count = instances;
+    batch->threads = threads;
+    batch->instances = (chip8_t *)calloc(instances, sizeof(chip8_t));
+    batch->status = (chip8_error_t *)calloc(instances, sizeof(chip8_error_t));
+    batch->queues = (chip8_batch_queue_t *)aligned_alloc(CHIP8_BATCH_CACHE_LINE, threads * sizeof(chip8_batch_queue_t));
+    batch->workers = (chip8_batch_worker_t *)calloc(threads, sizeof(chip8_batch_worker_t));
+
+    if( batch->instances == NULL || batch->status == NULL || batch->queues == NULL || batch->workers == NULL )
+    {
+        free(batch->instances);
+        free(batch->status);
+        free(batch->queues);
+        free(batch->workers);
+        free(batch);
+        return CHIP8_ERROR_INIT;
+    }
+
+    pthread_mutex_init(&batch->lock, NULL);
+    pthread_cond_init(&batch->start, NULL);
+    pthread_cond_init(&batch->done, NULL);
+
+    for(uint32_t itr = 0; itr < threads; itr++)
+    {
+        atomic_init(&batch->queues[itr].next, 0);
+        batch->queues[itr].end = 0;
+    }
+
+    /// Worker 0 is the thread calling CHIP8_BatchRunFrames
+    for(uint32_t itr = 1; itr < threads; itr++)
+    {
+        batch->workers[itr].batch = batch;
+        batch->workers[itr].index = itr;
+
+        if( pthread_create(&batch->workers[itr].thread, NULL, batch_worker_thread, &batch->workers[itr]) != 0 )
+        {
+            /// Run with the threads that could be started
+            batch->threads = itr;
+            break;
+        }
+    }
+
+    (*pbatch) = batch;
+    return CHIP8_ERROR_NO;
+}
+
+void CHIP8_BatchDestroy(chip8_batch_t *batch)
+{
+    if( batch == NULL )
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&batch->lock);
+    batch->stop = true;
+    pthread_cond_broadcast(&batch->start);
+    pthread_mutex_unlock(&batch->lock);
+
+    for(uint32_t itr = 1; itr < batch->threads; itr++)
+    {
+        pthread_join(batch->workers[itr].thread, NULL);
+    }
+
+    for(uint32_t itr = 0; itr < batch->count; itr++)
+    {
+        CHIP8_Deinit(&batch->instances[itr]);
+    }
+
+    pthread_cond_destroy(&batch->done);
+    pthread_cond_destroy(&batch->start);
+    pthread_mutex_destroy(&batch->lock);
+
+    free(batch->instances);
+    free(batch->status);
+    free(batch->queues);
+    free(batch->workers);
+    free(batch);
+}
+
+chip8_error_t CHIP8_BatchInitInstance(chip8_batch_t *batch, uint32_t index, const chip8_config_t *config, chip8_keymap_t *keymap, uint8_t *program_buff, uint32_t size)
+{
+    if( batch == NULL || index >= batch->count )
+    {
+        return CHIP8_ERROR_INVALID_INDEX;
+    }
+
+    /// Release what a previous program may still hold before the structure is cleared
+    CHIP8_Deinit(&batch->instances[index]);
+    batch->status[index] = CHIP8_InitWithConfig(&batch->instances[index], config, keymap, program_buff, size);
+
+    return batch->status[index];
+}
+
+chip8_t *CHIP8_BatchGetInstance(chip8_batch_t *batch, uint32_t index)
+{
+    return (index < batch->count) ? &batch->instances[index] : NULL;
+}
+
+chip8_error_t CHIP8_BatchGetStatus(chip8_batch_t *batch, uint32_t index)
+{
+    if( index >= batch->count )
+    {
+        return CHIP8_ERROR_INVALID_INDEX;
+    }
+
+    if( batch->status[index] == CHIP8_ERROR_NO && CHIP8_IsWaitingForKey(&batch->instances[index]) )
+    {
+        return CHIP8_ERROR_WAITING_FOR_KEY;
+    }
+
+    return batch->status[index];
+}
+
+chip8_error_t CHIP8_BatchRunFrames(chip8_batch_t *batch, uint32_t frames)
+{
+    if( batch == NULL )
+    {
+        return CHIP8_ERROR_INIT;
+    }
+
+    /// Equal contiguous ranges per worker, stealing evens out ROMs of different cost
+    uint32_t per_thread = batch->count / batch->threads;
+    uint32_t extra = batch->count % batch->threads;
+    uint32_t begin = 0;
+
+    for(uint32_t itr = 0; itr < batch->threads; itr++)
+    {
+        uint32_t length = per_thread + ((itr < extra) ? 1 : 0);
+        atomic_store_explicit(&batch->queues[itr].next, begin, memory_order_relaxed);
+        batch->queues[itr].end = begin + length;
+        begin += length;
+    }
+
+    /// Publishing the round under the lock also publishes the ranges above
+    pthread_mutex_lock(&batch->lock);
+    batch->frames = frames;
+    batch->busy = batch->threads - 1;
+    batch->round++;
+    pthread_cond_broadcast(&batch->start);
+    pthread_mutex_unlock(&batch->lock);
+
+    batch_work(batch, 0);
+
+    pthread_mutex_lock(&batch->lock);
+    while( batch->busy > 0 )
+    {
+        pthread_cond_wait(&batch->done, &batch->lock);
+    }
+    pthread_mutex_unlock(&batch->lock);
+
+    return CHIP8_ERROR_NO;
+}
+
+/////////////////////////////////////////////////
+/// Static functions
+/////////////////////////////////////////////////
+
+static void *batch_worker_thread(void *arg)
+{
+    chip8_batch_worker_t *worker = (chip8_batch_worker_t *)arg;
+    chip8_batch_t *batch = worker->batch;
+    uint64_t seen = 0;
+
+    pthread_mutex_lock(&batch->lock);
+    for(;;)
+    {
+        while( batch->round == seen && batch->stop == false )
+        {
+            pthread_cond_wait(&batch->start, &batch->lock);
+        }
+
+        if( batch->stop )
+        {
+            break;
+        }
+
+        seen = batch->round;
+        pthread_mutex_unlock(&batch->lock);
+
+        batch_work(batch, worker->index);
+
+        pthread_mutex_lock(&batch->lock);
+        if( --batch->busy == 0 )
+        {
+            pthread_cond_signal(&batch->done);
+        }
+    }
+    pthread_mutex_unlock(&batch->lock);
+
+    return NULL;
+}
+
+static void batch_work(chip8_batch_t *batch, uint32_t self)
+{
+    /// Drain the own range first, then steal from the others in ring order
+    for(uint32_t offset = 0; offset < batch->threads; offset++)
+    {
+        chip8_batch_queue_t *queue = &batch->queues[(self + offset) % batch->threads];
+
+        for(;;)
+        {
+            uint32_t index = atomic_fetch_add_explicit(&queue->next, 1, memory_order_relaxed);
+            if( index >= queue->end )
+            {
+                break;
+            }
+
+            batch_run_instance(batch, index);
+        }
+    }
+}
+
+static void batch_run_instance(chip8_batch_t *batch, uint32_t index)
+{
+    chip8_t *chip = &batch->instances[index];
+
+    if( batch->status[index] != CHIP8_ERROR_NO )
+    {
+        return;
+    }
+
+    /// An instance parked in FX0A costs O(1) per round
+    chip8_error_t err = CHIP8_RunFrames(chip, batch->frames);
+    if( err != CHIP8_ERROR_NO && err != CHIP8_ERROR_WAITING_FOR_KEY )
+    {
+        batch->status[index] = err;
+    }
+}
+
+static uint32_t batch_host_cores(void)
+{
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return (cores > 0) ? (uint32_t)cores : 1;
+}
@@ -0,0 +1,75 @@
+#ifndef CHIP8_CHIP8_BATCH_H
+#define CHIP8_CHIP8_BATCH_H
+
+/////////////////////////////////////////////////
+/// Includes
+/////////////////////////////////////////////////
+
+#include "CHIP8.h"
+#include <stdatomic.h>
+#include <pthread.h>
+
+/////////////////////////////////////////////////
+/// Defines
+/////////////////////////////////////////////////
+
+#define CHIP8_BATCH_AUTO_THREADS    0       /// One thread per online host core
+#define CHIP8_BATCH_CACHE_LINE      64
+
+/////////////////////////////////////////////////
+/// Typedef structures
+/////////////////////////////////////////////////
+
+/// Range of instances owned by one worker, other workers steal from it once their own range is empty
+typedef struct CHIP8_BATCH_QUEUE_STRUCT
+{
+    _Alignas(CHIP8_BATCH_CACHE_LINE) _Atomic uint32_t next;    /// Next instance to claim
+    uint32_t    end;                                            /// One past the last instance of the range
+
+} chip8_batch_queue_t;
+
+struct CHIP8_BATCH_STRUCT;
+
+typedef struct CHIP8_BATCH_WORKER_STRUCT
+{
+    struct CHIP8_BATCH_STRUCT   *batch;
+    uint32_t                    index;
+    pthread_t                   thread;
+
+} chip8_batch_worker_t;
+
+typedef struct CHIP8_BATCH_STRUCT
+{
+    chip8_t                 *instances;
+    chip8_error_t           *status;    /// First fault of each instance, a faulted instance is no longer stepped
+    uint32_t                count;
+    uint32_t                threads;    /// Worker threads including the calling thread
+    chip8_batch_queue_t     *queues;    /// One per thread
+    chip8_batch_worker_t    *workers;   /// threads - 1 pool threads, the caller works as worker 0
+
+    pthread_mutex_t         lock;
+    pthread_cond_t          start;      /// Signalled when a new round is published
+    pthread_cond_t          done;       /// Signalled when the last pool thread finished the round
+    uint64_t                round;
+    uint32_t                frames;     /// Frames to run in the current round
+    uint32_t                busy;       /// Pool threads still working on the current round
+    bool                    stop;
+
+} chip8_batch_t;
+
+/////////////////////////////////////////////////
+/// Public Prototype Functions
+/////////////////////////////////////////////////
+
+chip8_error_t CHIP8_BatchCreate(chip8_batch_t **pbatch, uint32_t instances, uint32_t threads);
+void CHIP8_BatchDestroy(chip8_batch_t *batch);
+
+chip8_error_t CHIP8_BatchInitInstance(chip8_batch_t *batch, uint32_t index, const chip8_config_t *config, chip8_keymap_t *keymap, uint8_t *program_buff, uint32_t size);
+chip8_t *CHIP8_BatchGetInstance(chip8_batch_t *batch, uint32_t index);
+/// First fault of the instance, CHIP8_ERROR_WAITING_FOR_KEY while it is parked in FX0A
+chip8_error_t CHIP8_BatchGetStatus(chip8_batch_t *batch, uint32_t index);
+
+/// Runs frames 60 Hz frames (CHIP8_RunFrames) on every instance and blocks until all are done
+chip8_error_t CHIP8_BatchRunFrames(chip8_batch_t *batch, uint32_t frames);
+
+#endif //CHIP8_CHIP8_BATCH_H
@@ -0,0 +1,955 @@
+/////////////////////////////////////////////////
+/// Includes
+/////////////////////////////////////////////////
+
+#define _DEFAULT_SOURCE     /// MAP_ANONYMOUS
+
+#include "CHIP8_Jit.h"
+
+#if CHIP8_HAS_JIT
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/////////////////////////////////////////////////
+/// Defines
+/////////////////////////////////////////////////
+
+#define JIT_BLOCK_RESERVE       4096    /// Free cache bytes required before translating a block
+#define JIT_REG_POOL_SIZE       10      /// Host registers available for V registers
+#define JIT_NO_REG              0xFF
+
+_Static_assert(CHIP8_FONT_ADDR == 0, "FX29 translation assumes the font starts at address 0");
+
+/// x86-64 register numbers
+#define RAX     0
+#define RCX     1
+#define RDX     2
+#define RBX     3
+#define RBP     5
+#define RSI     6
+#define RDI     7
+#define R8      8
+#define R9      9
+#define R10     10
+#define R11     11
+#define R12     12
+#define R13     13
+#define R14     14
+#define R15     15
+
+/// Register roles inside translated code
+#define JIT_REG_CHIP    RBX     /// chip8_t pointer
+#define JIT_REG_I       R14     /// I register
+#define JIT_REG_BUDGET  R15     /// Remaining instruction budget
+
+#define OFFSET_V(x)     (offsetof(chip8_t, registers) + offsetof(chip8_registers_t, V) + (x))
+#define OFFSET_I        (offsetof(chip8_t, registers) + offsetof(chip8_registers_t, I))
+#define OFFSET_PC       (offsetof(chip8_t, registers) + offsetof(chip8_registers_t, PC))
+#define OFFSET_SP       (offsetof(chip8_t, registers) + offsetof(chip8_registers_t, SP))
+#define OFFSET_DT       (offsetof(chip8_t, registers) + offsetof(chip8_registers_t, delayTimer))
+#define OFFSET_STACK    (offsetof(chip8_t, stack))
+
+/////////////////////////////////////////////////
+/// Typedef enumerations
+/////////////////////////////////////////////////
+
+typedef enum CHIP8_JIT_BLOCK_STATE_TYPE
+{
+    JIT_BLOCK_UNKNOWN = 0,      /// Not translated yet
+    JIT_BLOCK_COMPILED,         /// table[] points at native code
+    JIT_BLOCK_UNSUPPORTED,      /// First instruction must be interpreted
+
+} chip8_jit_block_state_t;
+
+typedef enum CHIP8_JIT_TERMINATOR_TYPE
+{
+    JIT_END_FALLTHROUGH = 0,    /// Block ended before an unsupported instruction
+    JIT_END_JUMP,               /// 1NNN
+    JIT_END_CALL,               /// 2NNN
+    JIT_END_RET,                /// 00EE
+    JIT_END_SKIP,               /// 3XNN, 4XNN, 5XY0, 9XY0
+    JIT_END_JUMP_V0,            /// BNNN
+
+} chip8_jit_terminator_t;
+
+/////////////////////////////////////////////////
+/// Typedef structures
+/////////////////////////////////////////////////
+
+typedef uint32_t (*chip8_jit_entry_t)(chip8_t *chip, const uint8_t *code, uint32_t budget);
+
+typedef struct CHIP8_JIT_STRUCT
+{
+    uint8_t             *code;                          /// mmap'd code cache, never writable and executable at once
+    uint32_t            codeUsed;
+    uint32_t            pageSize;
+    uint32_t            codeStart;                      /// First byte after the entry and exit stubs
+    const uint8_t       *exitStub;
+    chip8_jit_entry_t   entry;
+    const uint8_t       *table[CHIP8_MEMORY_SIZE];      /// Native code per address, exitStub if none
+    uint16_t            blockEnd[CHIP8_MEMORY_SIZE];    /// First address after the block starting here
+    uint8_t             state[CHIP8_MEMORY_SIZE];       /// chip8_jit_block_state_t
+    bool                covered[CHIP8_MEMORY_SIZE];     /// Address belongs to at least one block
+
+} chip8_jit_t;
+
+typedef struct CHIP8_JIT_EMITTER_STRUCT
+{
+    uint8_t     *buf;
+    uint32_t    pos;
+
+} chip8_jit_emitter_t;
+
+typedef struct CHIP8_JIT_BLOCK_STRUCT
+{
+    uint16_t                start;
+    uint16_t                length;         /// Instructions including the terminator
+    chip8_jit_terminator_t  end;
+    uint16_t                endOpcode;
+    uint16_t                endAddr;        /// Address of the terminator
+    uint8_t                 host[CHIP8_DATA_REGISTERS_TOTAL];   /// Host register per V register
+    uint16_t                dirty;          /// V registers written by the block
+    bool                    readsI;
+    bool                    writesI;
+
+} chip8_jit_block_t;
+
+/////////////////////////////////////////////////
+/// Static variables
+/////////////////////////////////////////////////
+
+static const uint8_t jit_reg_pool[JIT_REG_POOL_SIZE] = { RBP, R12, R13, RSI, RDI, R8, R9, R10, R11, RDX };
+
+/////////////////////////////////////////////////
+/// Prototype static functions
+/////////////////////////////////////////////////
+
+static void jit_reset(chip8_jit_t *jit);
+static bool jit_code_protect(chip8_jit_t *jit, uint32_t start, uint32_t end, bool writable);
+static chip8_error_t jit_translate(chip8_t *chip, uint16_t start);
+static bool jit_scan(chip8_t *chip, chip8_jit_block_t *block);
+static bool jit_op_registers(uint16_t opcode, uint16_t *used, uint16_t *written, bool *reads_i, bool *writes_i, chip8_jit_terminator_t *end);
+static void jit_emit_block(chip8_t *chip, chip8_jit_emitter_t *e, const chip8_jit_block_t *block);
+static void jit_emit_op(chip8_jit_emitter_t *e, const chip8_jit_block_t *block, uint16_t opcode);
+static void jit_emit_store_state(chip8_jit_emitter_t *e, const chip8_jit_block_t *block);
+static void jit_emit_exit_to(chip8_jit_t *jit, chip8_jit_emitter_t *e, uint16_t target);
+static void jit_emit_exit_dynamic(chip8_jit_t *jit, chip8_jit_emitter_t *e);
+static void jit_emit_bail(chip8_jit_t *jit, chip8_jit_emitter_t *e, uint16_t addr, bool refund);
+
+static inline void emit_u8(chip8_jit_emitter_t *e, uint8_t value);
+static inline void emit_u16(chip8_jit_emitter_t *e, uint16_t value);
+static inline void emit_u32(chip8_jit_emitter_t *e, uint32_t value);
+static inline void emit_u64(chip8_jit_emitter_t *e, uint64_t value);
+static inline void emit_rex(chip8_jit_emitter_t *e, bool w, uint8_t reg, uint8_t rm, bool byte_regs);
+static void emit_rr8(chip8_jit_emitter_t *e, uint8_t op, uint8_t dst, uint8_t src);
+static void emit_ri8(chip8_jit_emitter_t *e, uint8_t ext, uint8_t dst, uint8_t imm);
+static void emit_load8(chip8_jit_emitter_t *e, uint8_t reg, uint32_t disp);
+static void emit_store8(chip8_jit_emitter_t *e, uint8_t reg, uint32_t disp);
+static void emit_jmp_abs(chip8_jit_emitter_t *e, const uint8_t *target);
+static uint32_t emit_jcc_rel32(chip8_jit_emitter_t *e, uint8_t cc);
+static void emit_patch_rel32(chip8_jit_emitter_t *e, uint32_t at);
+
+/////////////////////////////////////////////////
+/// Internal functions
+/////////////////////////////////////////////////
+
+chip8_error_t chip_jit_create(chip8_t *chip)
+{
+    chip8_jit_t *jit = NULL;
+    chip8_jit_emitter_t e;
+
+    if( chip->jit != NULL )
+    {
+        return CHIP8_ERROR_NO;
+    }
+
+    jit = (chip8_jit_t *)calloc(1, sizeof(chip8_jit_t));
+    if( jit == NULL )
+    {
+        return CHIP8_ERROR_INIT;
+    }
+
+    /// Only address space, pages are opened for writing around each translation and executable otherwise
+    void *code = mmap(NULL, CHIP8_JIT_CODE_CACHE_SIZE, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if( code == MAP_FAILED )
+    {
+        free(jit);
+        return CHIP8_ERROR_NOT_SUPPORTED;
+    }
+
+    jit->code = (uint8_t *)code;
+    jit->pageSize = (uint32_t)sysconf(_SC_PAGESIZE);
+
+    if( jit_code_protect(jit, 0, JIT_BLOCK_RESERVE, true) == false )
+    {
+        munmap(code, CHIP8_JIT_CODE_CACHE_SIZE);
+        free(jit);
+        return CHIP8_ERROR_NOT_SUPPORTED;
+    }
+
+    e.buf = jit->code;
+    e.pos = 0;
+
+    /// uint32_t entry(chip8_t *chip, const uint8_t *code, uint32_t budget)
+    jit->entry = (chip8_jit_entry_t)(void *)jit->code;
+    emit_u8(&e, 0x53);                                  /// push rbx
+    emit_u8(&e, 0x55);                                  /// push rbp
+    emit_u8(&e, 0x41); emit_u8(&e, 0x54);               /// push r12
+    emit_u8(&e, 0x41); emit_u8(&e, 0x55);               /// push r13
+    emit_u8(&e, 0x41); emit_u8(&e, 0x56);               /// push r14
+    emit_u8(&e, 0x41); emit_u8(&e, 0x57);               /// push r15
+    emit_u8(&e, 0x48); emit_u8(&e, 0x89); emit_u8(&e, 0xFB);    /// mov rbx, rdi
+    emit_u8(&e, 0x41); emit_u8(&e, 0x89); emit_u8(&e, 0xD7);    /// mov r15d, edx
+    emit_u8(&e, 0xFF); emit_u8(&e, 0xE6);               /// jmp rsi
+
+    /// Exit stub, returns the remaining budget
+    jit->exitStub = &jit->code[e.pos];
+    emit_u8(&e, 0x44); emit_u8(&e, 0x89); emit_u8(&e, 0xF8);    /// mov eax, r15d
+    emit_u8(&e, 0x41); emit_u8(&e, 0x5F);               /// pop r15
+    emit_u8(&e, 0x41); emit_u8(&e, 0x5E);               /// pop r14
+    emit_u8(&e, 0x41); emit_u8(&e, 0x5D);               /// pop r13
+    emit_u8(&e, 0x41); emit_u8(&e, 0x5C);               /// pop r12
+    emit_u8(&e, 0x5D);                                  /// pop rbp
+    emit_u8(&e, 0x5B);                                  /// pop rbx
+    emit_u8(&e, 0xC3);                                  /// ret
+
+    jit->codeStart = e.pos;
+    jit_reset(jit);
+
+    if( jit_code_protect(jit, 0, JIT_BLOCK_RESERVE, false) == false )
+    {
+        munmap(code, CHIP8_JIT_CODE_CACHE_SIZE);
+        free(jit);
+        return CHIP8_ERROR_NOT_SUPPORTED;
+    }
+
+    chip->jit = jit;
+    return CHIP8_ERROR_NO;
+}
+
+void chip_jit_destroy(chip8_t *chip)
+{
+    chip8_jit_t *jit = chip->jit;
+    if( jit == NULL )
+    {
+        return;
+    }
+
+    munmap(jit->code, CHIP8_JIT_CODE_CACHE_SIZE);
+    free(jit);
+    chip->jit = NULL;
+}
+
+uint32_t chip_jit_execute(chip8_t *chip, uint32_t cycles)
+{
+    chip8_jit_t *jit = chip->jit;
+    uint16_t pc = chip->registers.PC;
+
+    if( (pc & 1) != 0 || pc < CHIP8_PROGRAM_START_ADDR || pc >= CHIP8_MEMORY_SIZE )
+    {
+        return 0;
+    }
+
+    if( jit->state[pc] == JIT_BLOCK_UNKNOWN )
+    {
+        jit_translate(chip, pc);
+    }
+
+    if( jit->state[pc] != JIT_BLOCK_COMPILED )
+    {
+        return 0;
+    }
+
+    /// Linked blocks keep running natively until one does not fit the budget or leaves translated code
+    return cycles - jit->entry(chip, jit->table[pc], cycles);
+}
+
+void chip_jit_invalidate(chip8_t *chip, uint16_t addr)
+{
+    chip8_jit_t *jit = chip->jit;
+
+    if( addr >= CHIP8_MEMORY_SIZE )
+    {
+        return;
+    }
+
+    /// The patched instruction may have become translatable
+    if( jit->state[addr & ~1u] == JIT_BLOCK_UNSUPPORTED )
+    {
+        jit->state[addr & ~1u] = JIT_BLOCK_UNKNOWN;
+    }
+
+    if( jit->covered[addr] == false )
+    {
+        return;
+    }
+
+    /// Drop every block whose range contains addr, the code itself is reclaimed on the next flush
+    uint32_t first = (addr >= CHIP8_JIT_MAX_BLOCK_LENGTH * 2) ? (uint32_t)(addr - CHIP8_JIT_MAX_BLOCK_LENGTH * 2) : 0;
+    for(uint32_t start = first & ~1u; start <= addr; start += 2)
+    {
+        if( jit->state[start] == JIT_BLOCK_COMPILED && jit->blockEnd[start] > addr )
+        {
+            jit->state[start] = JIT_BLOCK_UNKNOWN;
+            jit->table[start] = jit->exitStub;
+        }
+    }
+}
+
+/////////////////////////////////////////////////
+/// Static functions
+/////////////////////////////////////////////////
+
+static void jit_reset(chip8_jit_t *jit)
+{
+    jit->codeUsed = jit->codeStart;
+
+    for(uint32_t itr = 0; itr < CHIP8_MEMORY_SIZE; itr++)
+    {
+        jit->table[itr] = jit->exitStub;
+    }
+
+    memset(jit->state, JIT_BLOCK_UNKNOWN, sizeof(jit->state));
+    memset(jit->covered, 0, sizeof(jit->covered));
+    memset(jit->blockEnd, 0, sizeof(jit->blockEnd));
+}
+
+static bool jit_code_protect(chip8_jit_t *jit, uint32_t start, uint32_t end, bool writable)
+{
+    uint32_t first = start & ~(jit->pageSize - 1);
+    uint32_t last = (end + jit->pageSize - 1) & ~(jit->pageSize - 1);
+
+    if( last > CHIP8_JIT_CODE_CACHE_SIZE )
+    {
+        last = CHIP8_JIT_CODE_CACHE_SIZE;
+    }
+
+    return mprotect(&jit->code[first], last - first, writable ? (PROT_READ | PROT_WRITE) : (PROT_READ | PROT_EXEC)) == 0;
+}
+
+static chip8_error_t jit_translate(chip8_t *chip, uint16_t start)
+{
+    chip8_jit_t *jit = chip->jit;
+    chip8_jit_block_t block;
+    chip8_jit_emitter_t e;
+
+    memset(&block, 0, sizeof(block));
+    block.start = start;
+
+    if( jit_scan(chip, &block) == false )
+    {
+        jit->state[start] = JIT_BLOCK_UNSUPPORTED;
+        return CHIP8_ERROR_NOT_SUPPORTED;
+    }
+
+    /// Flush the whole cache when it is full, blocks are cheap to translate again
+    if( jit->codeUsed + JIT_BLOCK_RESERVE > CHIP8_JIT_CODE_CACHE_SIZE )
+    {
+        jit_reset(jit);
+    }
+
+    /// A block never exceeds JIT_BLOCK_RESERVE bytes, only those pages leave the executable state
+    uint32_t window_end = jit->codeUsed + JIT_BLOCK_RESERVE;
+    if( jit_code_protect(jit, jit->codeUsed, window_end, true) == false )
+    {
+        jit->state[start] = JIT_BLOCK_UNSUPPORTED;
+        return CHIP8_ERROR_NOT_SUPPORTED;
+    }
+
+    e.buf = jit->code;
+    e.pos = jit->codeUsed;
+    jit_emit_block(chip, &e, &block);
+
+    if( jit_code_protect(jit, jit->codeUsed, window_end, false) == false )
+    {
+        /// The pages stay writable and cannot run, forget everything translated so far
+        jit_reset(jit);
+        jit->state[start] = JIT_BLOCK_UNSUPPORTED;
+        return CHIP8_ERROR_NOT_SUPPORTED;
+    }
+
+    jit->table[start] = &jit->code[jit->codeUsed];
+    jit->state[start] = JIT_BLOCK_COMPILED;
+    jit->blockEnd[start] = start + block.length * 2;
+    jit->codeUsed = e.pos;
+
+    for(uint32_t addr = start; addr < jit->blockEnd[start]; addr++)
+    {
+        jit->covered[addr] = true;
+    }
+
+    return CHIP8_ERROR_NO;
+}
+
+static bool jit_scan(chip8_t *chip, chip8_jit_block_t *block)
+{
+    uint16_t used = 0;
+    uint32_t pool_used = 0;
+
+    memset(block->host, JIT_NO_REG, sizeof(block->host));
+    block->end = JIT_END_FALLTHROUGH;
+
+    for(uint32_t addr = block->start; addr + 1 < CHIP8_MEMORY_SIZE; addr += 2)
+    {
+        uint16_t opcode = (uint16_t)(chip->memory[addr] << 8 | chip->memory[addr + 1]);
+        uint16_t op_used = 0, op_written = 0;
+        bool reads_i = false, writes_i = false;
+        chip8_jit_terminator_t end = JIT_END_FALLTHROUGH;
+        uint32_t needed = 0;
+
+        if( jit_op_registers(opcode, &op_used, &op_written, &reads_i, &writes_i, &end) == false )
+        {
+            break;
+        }
+
+        for(uint32_t reg = 0; reg < CHIP8_DATA_REGISTERS_TOTAL; reg++)
+        {
+            if( (op_used & ~used) & (1u << reg) )
+            {
+                needed++;
+            }
+        }
+
+        /// Stop before an instruction that would need more host registers than available
+        if( pool_used + needed > JIT_REG_POOL_SIZE )
+        {
+            break;
+        }
+
+        for(uint32_t reg = 0; reg < CHIP8_DATA_REGISTERS_TOTAL; reg++)
+        {
+            if( (op_used & ~used) & (1u << reg) )
+            {
+                block->host[reg] = jit_reg_pool[pool_used++];
+            }
+        }
+
+        used |= op_used;
+        block->dirty |= op_written;
+        block->readsI |= (reads_i && block->writesI == false);
+        block->writesI |= writes_i;
+        block->length++;
+
+        if( end != JIT_END_FALLTHROUGH )
+        {
+            block->end = end;
+            block->endOpcode = opcode;
+            block->endAddr = (uint16_t)addr;
+            break;
+        }
+
+        if( block->length == CHIP8_JIT_MAX_BLOCK_LENGTH )
+        {
+            break;
+        }
+    }
+
+    return block->length > 0;
+}
+
+static bool jit_op_registers(uint16_t opcode, uint16_t *used, uint16_t *written, bool *reads_i, bool *writes_i, chip8_jit_terminator_t *end)
+{
+    uint16_t x = 1u << ((opcode & 0x0F00) >> 8);
+    uint16_t y = 1u << ((opcode & 0x00F0) >> 4);
+    uint16_t vf = 1u << 0xF;
+
+    switch( opcode >> 12 )
+    {
+        case 0x0:
+            if( opcode != 0x00EE )
+            {
+                return false;
+            }
+            *end = JIT_END_RET;
+            return true;
+
+        case 0x1:
+            *end = JIT_END_JUMP;
+            return true;
+
+        case 0x2:
+            *end = JIT_END_CALL;
+            return true;
+
+        case 0x3:
+        case 0x4:
+            *used = x;
+            *end = JIT_END_SKIP;
+            return true;
+
+        case 0x5:
+        case 0x9:
+            *used = x | y;
+            *end = JIT_END_SKIP;
+            return true;
+
+        case 0x6:
+        case 0x7:
+            *used = x;
+            *written = x;
+            return true;
+
+        case 0x8:
+            switch( opcode & 0x000F )
+            {
+                case 0x0:
+                case 0x1:
+                case 0x2:
+                case 0x3:
+                    *used = x | y;
+                    *written = x;
+                    return true;
+
+                case 0x4:
+                case 0x5:
+                case 0x7:
+                    *used = x | y | vf;
+                    *written = x | vf;
+                    return true;
+
+                case 0x6:
+                case 0xE:
+                    *used = x | vf;
+                    *written = x | vf;
+                    return true;
+
+                default:
+                    return false;
+            }
+
+        case 0xA:
+            *writes_i = true;
+            return true;
+
+        case 0xB:
+            *used = 1u << 0;
+            *end = JIT_END_JUMP_V0;
+            return true;
+
+        case 0xF:
+            switch( opcode & 0x00FF )
+            {
+                case 0x07:
+                    *used = x;
+                    *written = x;
+                    return true;
+
+                case 0x15:
+                    *used = x;
+                    return true;
+
+                case 0x1E:
+                    *used = x;
+                    *reads_i = true;
+                    *writes_i = true;
+                    return true;
+
+                case 0x29:
+                    *used = x;
+                    *writes_i = true;
+                    return true;
+
+                default:
+                    return false;
+            }
+
+        default:
+            return false;
+    }
+}
+
+static void jit_emit_block(chip8_t *chip, chip8_jit_emitter_t *e, const chip8_jit_block_t *block)
+{
+    chip8_jit_t *jit = chip->jit;
+    uint32_t no_budget = 0;
+
+    /// Run only when the whole block fits the remaining budget
+    emit_u8(e, 0x41); emit_u8(e, 0x81); emit_u8(e, 0xFF); emit_u32(e, block->length);  /// cmp r15d, len
+    no_budget = emit_jcc_rel32(e, 0x82);                                                /// jb no_budget
+    emit_u8(e, 0x41); emit_u8(e, 0x81); emit_u8(e, 0xEF); emit_u32(e, block->length);  /// sub r15d, len
+
+    for(uint32_t reg = 0; reg < CHIP8_DATA_REGISTERS_TOTAL; reg++)
+    {
+        if( block->host[reg] != JIT_NO_REG )
+        {
+            emit_load8(e, block->host[reg], OFFSET_V(reg));
+        }
+    }
+
+    if( block->readsI )
+    {
+        emit_u8(e, 0x44); emit_u8(e, 0x0F); emit_u8(e, 0xB7); emit_u8(e, 0xB3);        /// movzx r14d, word [rbx+I]
+        emit_u32(e, OFFSET_I);
+    }
+
+    uint16_t body = (block->end == JIT_END_FALLTHROUGH) ? block->length : block->length - 1;
+    for(uint32_t itr = 0; itr < body; itr++)
+    {
+        uint16_t addr = block->start + itr * 2;
+        jit_emit_op(e, block, (uint16_t)(chip->memory[addr] << 8 | chip->memory[addr + 1]));
+    }
+
+    jit_emit_store_state(e, block);
+
+    uint16_t op = block->endOpcode;
+    uint16_t next = block->endAddr + 2;
+    switch( block->end )
+    {
+        case JIT_END_FALLTHROUGH:
+            jit_emit_exit_to(jit, e, block->start + block->length * 2);
+            break;
+
+        case JIT_END_JUMP:
+            jit_emit_exit_to(jit, e, op & 0x0FFF);
+            break;
+
+        case JIT_END_CALL:
+        {
+            emit_u8(e, 0x0F); emit_u8(e, 0xB6); emit_u8(e, 0x83); emit_u32(e, OFFSET_SP);  /// movzx eax, byte [rbx+SP]
+            emit_u8(e, 0x83); emit_u8(e, 0xF8); emit_u8(e, CHIP8_STACK_DEPTH_TOTAL);       /// cmp eax, depth
+            uint32_t full = emit_jcc_rel32(e, 0x83);                                        /// jae full
+            emit_u8(e, 0x66); emit_u8(e, 0xC7); emit_u8(e, 0x84); emit_u8(e, 0x43);        /// mov word [rbx+rax*2+stack], next
+            emit_u32(e, OFFSET_STACK); emit_u16(e, next);
+            emit_u8(e, 0xFF); emit_u8(e, 0xC0);                                             /// inc eax
+            emit_u8(e, 0x88); emit_u8(e, 0x83); emit_u32(e, OFFSET_SP);                     /// mov byte [rbx+SP], al
+            jit_emit_exit_to(jit, e, op & 0x0FFF);
+            emit_patch_rel32(e, full);
+            jit_emit_bail(jit, e, block->endAddr, true);
+            break;
+        }
+
+        case JIT_END_RET:
+        {
+            emit_u8(e, 0x0F); emit_u8(e, 0xB6); emit_u8(e, 0x83); emit_u32(e, OFFSET_SP);  /// movzx eax, byte [rbx+SP]
+            emit_u8(e, 0x85); emit_u8(e, 0xC0);                                             /// test eax, eax
+            uint32_t empty = emit_jcc_rel32(e, 0x84);                                       /// jz empty
+            emit_u8(e, 0xFF); emit_u8(e, 0xC8);                                             /// dec eax
+            emit_u8(e, 0x88); emit_u8(e, 0x83); emit_u32(e, OFFSET_SP);                     /// mov byte [rbx+SP], al
+            emit_u8(e, 0x0F); emit_u8(e, 0xB7); emit_u8(e, 0x8C); emit_u8(e, 0x43);        /// movzx ecx, word [rbx+rax*2+stack]
+            emit_u32(e, OFFSET_STACK);
+            jit_emit_exit_dynamic(jit, e);
+            emit_patch_rel32(e, empty);
+            jit_emit_bail(jit, e, block->endAddr, true);
+            break;
+        }
+
+        case JIT_END_SKIP:
+        {
+            uint8_t x = block->host[(op & 0x0F00) >> 8];
+            uint8_t y = block->host[(op & 0x00F0) >> 4];
+            uint8_t cc = 0;
+
+            switch( op >> 12 )
+            {
+                case 0x3: emit_ri8(e, 7, x, op & 0xFF); cc = 0x84; break;    /// cmp x, nn; skip if equal
+                case 0x4: emit_ri8(e, 7, x, op & 0xFF); cc = 0x85; break;    /// skip if not equal
+                case 0x5: emit_rr8(e, 0x38, x, y); cc = 0x84; break;         /// cmp x, y
+                default:  emit_rr8(e, 0x38, x, y); cc = 0x85; break;
+            }
+
+            uint32_t skip = emit_jcc_rel32(e, cc);
+            jit_emit_exit_to(jit, e, next);
+            emit_patch_rel32(e, skip);
+            jit_emit_exit_to(jit, e, next + 2);
+            break;
+        }
+
+        case JIT_END_JUMP_V0:
+        {
+            uint8_t v0 = block->host[0];
+            emit_rex(e, false, RCX, v0, true);
+            emit_u8(e, 0x0F); emit_u8(e, 0xB6); emit_u8(e, 0xC0 | (RCX << 3) | (v0 & 7));  /// movzx ecx, v0
+            emit_u8(e, 0x81); emit_u8(e, 0xC1); emit_u32(e, op & 0x0FFF);                  /// add ecx, nnn
+            jit_emit_exit_dynamic(jit, e);
+            break;
+        }
+    }
+
+    emit_patch_rel32(e, no_budget);
+    jit_emit_bail(jit, e, block->start, false);
+}
+
+static void jit_emit_op(chip8_jit_emitter_t *e, const chip8_jit_block_t *block, uint16_t opcode)
+{
+    uint8_t x = block->host[(opcode & 0x0F00) >> 8];
+    uint8_t y = block->host[(opcode & 0x00F0) >> 4];
+    uint8_t vf = block->host[0xF];
+    uint8_t nn = opcode & 0x00FF;
+
+    switch( opcode >> 12 )
+    {
+        case 0x6:   /// Vx = NN
+            emit_rex(e, false, 0, x, true);
+            emit_u8(e, 0xB0 | (x & 7));
+            emit_u8(e, nn);
+            break;
+
+        case 0x7:   /// Vx += NN
+            emit_ri8(e, 0, x, nn);
+            break;
+
+        case 0x8:
+            switch( opcode & 0x000F )
+            {
+                case 0x0: emit_rr8(e, 0x88, x, y); break;   /// mov
+                case 0x1: emit_rr8(e, 0x08, x, y); break;   /// or
+                case 0x2: emit_rr8(e, 0x20, x, y); break;   /// and
+                case 0x3: emit_rr8(e, 0x30, x, y); break;   /// xor
+
+                case 0x4:   /// Vx += Vy, VF = carry
+                    emit_rr8(e, 0x00, x, y);
+                    emit_u8(e, 0x0F); emit_u8(e, 0x92); emit_u8(e, 0xC0);       /// setc al
+                    emit_rr8(e, 0x88, vf, RAX);
+                    break;
+
+                case 0x5:   /// Vx -= Vy, VF = NOT borrow
+                    emit_rr8(e, 0x28, x, y);
+                    emit_u8(e, 0x0F); emit_u8(e, 0x93); emit_u8(e, 0xC0);       /// setnc al
+                    emit_rr8(e, 0x88, vf, RAX);
+                    break;
+
+                case 0x6:   /// Vx >>= 1, VF = shifted bit
+                    emit_rex(e, false, 0, x, true);
+                    emit_u8(e, 0xD0); emit_u8(e, 0xE8 | (x & 7));               /// shr x, 1
+                    emit_u8(e, 0x0F); emit_u8(e, 0x92); emit_u8(e, 0xC0);       /// setc al
+                    emit_rr8(e, 0x88, vf, RAX);
+                    break;
+
+                case 0x7:   /// Vx = Vy - Vx, VF = NOT borrow
+                    emit_rr8(e, 0x88, RAX, y);
+                    emit_rr8(e, 0x28, RAX, x);
+                    emit_u8(e, 0x0F); emit_u8(e, 0x93); emit_u8(e, 0xC1);       /// setnc cl
+                    emit_rr8(e, 0x88, x, RAX);
+                    emit_rr8(e, 0x88, vf, RCX);
+                    break;
+
+                case 0xE:   /// Vx <<= 1, VF = shifted bit
+                    emit_rex(e, false, 0, x, true);
+                    emit_u8(e, 0xD0); emit_u8(e, 0xE0 | (x & 7));               /// shl x, 1
+                    emit_u8(e, 0x0F); emit_u8(e, 0x92); emit_u8(e, 0xC0);       /// setc al
+                    emit_rr8(e, 0x88, vf, RAX);
+                    break;
+
+                default:
+                    break;
+            }
+            break;
+
+        case 0xA:   /// I = NNN
+            emit_u8(e, 0x41); emit_u8(e, 0xBE); emit_u32(e, opcode & 0x0FFF);  /// mov r14d, nnn
+            break;
+
+        case 0xF:
+            switch( nn )
+            {
+                case 0x07:  /// Vx = delay timer
+                    emit_load8(e, x, OFFSET_DT);
+                    break;
+
+                case 0x15:  /// delay timer = Vx
+                    emit_store8(e, x, OFFSET_DT);
+                    break;
+
+                case 0x1E:  /// I += Vx
+                    emit_rex(e, false, RAX, x, true);
+                    emit_u8(e, 0x0F); emit_u8(e, 0xB6); emit_u8(e, 0xC0 | (x & 7));     /// movzx eax, x
+                    emit_u8(e, 0x41); emit_u8(e, 0x01); emit_u8(e, 0xC6);               /// add r14d, eax
+                    break;
+
+                case 0x29:  /// I = Vx * 5, the font starts at address 0
+                    emit_rex(e, false, JIT_REG_I, x, true);
+                    emit_u8(e, 0x0F); emit_u8(e, 0xB6); emit_u8(e, 0xC0 | ((JIT_REG_I & 7) << 3) | (x & 7));  /// movzx r14d, x
+                    emit_u8(e, 0x45); emit_u8(e, 0x6B); emit_u8(e, 0xF6); emit_u8(e, CHIP8_FONT_GLYPH_SIZE);  /// imul r14d, r14d, 5
+                    break;
+
+                default:
+                    break;
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void jit_emit_store_state(chip8_jit_emitter_t *e, const chip8_jit_block_t *block)
+{
+    for(uint32_t reg = 0; reg < CHIP8_DATA_REGISTERS_TOTAL; reg++)
+    {
+        if( block->dirty & (1u << reg) )
+        {
+            emit_store8(e, block->host[reg], OFFSET_V(reg));
+        }
+    }
+
+    if( block->writesI )
+    {
+        emit_u8(e, 0x66); emit_u8(e, 0x44); emit_u8(e, 0x89); emit_u8(e, 0xB3);        /// mov word [rbx+I], r14w
+        emit_u32(e, OFFSET_I);
+    }
+}
+
+static void jit_emit_exit_to(chip8_jit_t *jit, chip8_jit_emitter_t *e, uint16_t target)
+{
+    /// PC is always stored so an untranslated target simply returns to the host loop
+    emit_u8(e, 0x66); emit_u8(e, 0xC7); emit_u8(e, 0x83); emit_u32(e, OFFSET_PC); emit_u16(e, target);   /// mov word [rbx+PC], target
+
+    if( target >= CHIP8_MEMORY_SIZE )
+    {
+        emit_jmp_abs(e, jit->exitStub);
+        return;
+    }
+
+    emit_u8(e, 0x48); emit_u8(e, 0xB8); emit_u64(e, (uint64_t)(uintptr_t)&jit->table[target]);     /// mov rax, &table[target]
+    emit_u8(e, 0xFF); emit_u8(e, 0x20);                                                             /// jmp [rax]
+}
+
+static void jit_emit_exit_dynamic(chip8_jit_t *jit, chip8_jit_emitter_t *e)
+{
+    /// Target address in ecx
+    emit_u8(e, 0x66); emit_u8(e, 0x89); emit_u8(e, 0x8B); emit_u32(e, OFFSET_PC);                   /// mov word [rbx+PC], cx
+    emit_u8(e, 0x81); emit_u8(e, 0xF9); emit_u32(e, CHIP8_MEMORY_SIZE);                             /// cmp ecx, size
+    uint32_t outside = emit_jcc_rel32(e, 0x83);                                                     /// jae outside
+    emit_u8(e, 0x48); emit_u8(e, 0xB8); emit_u64(e, (uint64_t)(uintptr_t)&jit->table[0]);           /// mov rax, table
+    emit_u8(e, 0xFF); emit_u8(e, 0x24); emit_u8(e, 0xC8);                                           /// jmp [rax+rcx*8]
+    emit_patch_rel32(e, outside);
+    emit_jmp_abs(e, jit->exitStub);
+}
+
+static void jit_emit_bail(chip8_jit_t *jit, chip8_jit_emitter_t *e, uint16_t addr, bool refund)
+{
+    /// Leave with PC at addr so the interpreter runs that instruction, refund its budget if it was charged
+    if( refund )
+    {
+        emit_u8(e, 0x41); emit_u8(e, 0x83); emit_u8(e, 0xC7); emit_u8(e, 0x01);   /// add r15d, 1
+    }
+    emit_u8(e, 0x66); emit_u8(e, 0xC7); emit_u8(e, 0x83); emit_u32(e, OFFSET_PC); emit_u16(e, addr);
+    emit_jmp_abs(e, jit->exitStub);
+}
+
+/////////////////////////////////////////////////
+/// x86-64 encoders
+/////////////////////////////////////////////////
+
+static inline void emit_u8(chip8_jit_emitter_t *e, uint8_t value)
+{
+    e->buf[e->pos++] = value;
+}
+
+static inline void emit_u16(chip8_jit_emitter_t *e, uint16_t value)
+{
+    memcpy(&e->buf[e->pos], &value, sizeof(value));
+    e->pos += sizeof(value);
+}
+
+static inline void emit_u32(chip8_jit_emitter_t *e, uint32_t value)
+{
+    memcpy(&e->buf[e->pos], &value, sizeof(value));
+    e->pos += sizeof(value);
+}
+
+static inline void emit_u64(chip8_jit_emitter_t *e, uint64_t value)
+{
+    memcpy(&e->buf[e->pos], &value, sizeof(value));
+    e->pos += sizeof(value);
+}
+
+static inline void emit_rex(chip8_jit_emitter_t *e, bool w, uint8_t reg, uint8_t rm, bool byte_regs)
+{
+    /// Byte access to spl/bpl/sil/dil needs a REX prefix even without extension bits
+    bool force = byte_regs && ((reg >= 4 && reg < 8) || (rm >= 4 && rm < 8));
+    if( w || reg >= 8 || rm >= 8 || force )
+    {
+        emit_u8(e, 0x40 | (w ? 0x08 : 0) | ((reg >> 3) << 2) | (rm >> 3));
+    }
+}
+
+static void emit_rr8(chip8_jit_emitter_t *e, uint8_t op, uint8_t dst, uint8_t src)
+{
+    /// op r/m8, r8 with both operands in registers
+    emit_rex(e, false, src, dst, true);
+    emit_u8(e, op);
+    emit_u8(e, 0xC0 | ((src & 7) << 3) | (dst & 7));
+}
+
+static void emit_ri8(chip8_jit_emitter_t *e, uint8_t ext, uint8_t dst, uint8_t imm)
+{
+    /// Group 1 r/m8, imm8 (ext 0 = add, 7 = cmp)
+    emit_rex(e, false, 0, dst, true);
+    emit_u8(e, 0x80);
+    emit_u8(e, 0xC0 | (ext << 3) | (dst & 7));
+    emit_u8(e, imm);
+}
+
+static void emit_load8(chip8_jit_emitter_t *e, uint8_t reg, uint32_t disp)
+{
+    emit_rex(e, false, reg, JIT_REG_CHIP, true);
+    emit_u8(e, 0x8A);
+    emit_u8(e, 0x80 | ((reg & 7) << 3) | JIT_REG_CHIP);
+    emit_u32(e, disp);
+}
+
+static void emit_store8(chip8_jit_emitter_t *e, uint8_t reg, uint32_t disp)
+{
+    emit_rex(e, false, reg, JIT_REG_CHIP, true);
+    emit_u8(e, 0x88);
+    emit_u8(e, 0x80 | ((reg & 7) << 3) | JIT_REG_CHIP);
+    emit_u32(e, disp);
+}
+
+static void emit_jmp_abs(chip8_jit_emitter_t *e, const uint8_t *target)
+{
+    /// The whole cache is one mapping so rel32 always reaches
+    emit_u8(e, 0xE9);
+    emit_u32(e, (uint32_t)(target - &e->buf[e->pos + 4]));
+}
+
+static uint32_t emit_jcc_rel32(chip8_jit_emitter_t *e, uint8_t cc)
+{
+    emit_u8(e, 0x0F);
+    emit_u8(e, cc);
+    emit_u32(e, 0);
+    return e->pos - 4;
+}
+
+static void emit_patch_rel32(chip8_jit_emitter_t *e, uint32_t at)
+{
+    uint32_t rel = e->pos - (at + 4);
+    memcpy(&e->buf[at], &rel, sizeof(rel));
+}
+
+#else
+
+/////////////////////////////////////////////////
+/// Internal functions (JIT not available)
+/////////////////////////////////////////////////
+
+chip8_error_t chip_jit_create(chip8_t *chip)
+{
+    (void)chip;
+    return CHIP8_ERROR_NOT_SUPPORTED;
+}
+
+void chip_jit_destroy(chip8_t *chip)
+{
+    (void)chip;
+}
+
+uint32_t chip_jit_execute(chip8_t *chip, uint32_t cycles)
+{
+    (void)chip;
+    (void)cycles;
+    return 0;
+}
+
+void chip_jit_invalidate(chip8_t *chip, uint16_t addr)
+{
+    (void)chip;
+    (void)addr;
+}
+
+#endif
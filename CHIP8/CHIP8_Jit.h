@@ -0,0 +1,33 @@
+#ifndef CHIP8_CHIP8_JIT_H
+#define CHIP8_CHIP8_JIT_H
+
+/////////////////////////////////////////////////
+/// Includes
+/////////////////////////////////////////////////
+
+#include "CHIP8.h"
+
+/////////////////////////////////////////////////
+/// Defines
+/////////////////////////////////////////////////
+
+#if defined(__x86_64__) && (defined(__unix__) || defined(__APPLE__)) && !defined(CHIP8_NO_JIT)
+#define CHIP8_HAS_JIT               1
+#else
+#define CHIP8_HAS_JIT               0
+#endif
+
+#define CHIP8_JIT_CODE_CACHE_SIZE   (1024 * 1024)   /// Address space reserved per instance, pages only take memory once code is written to them
+#define CHIP8_JIT_MAX_BLOCK_LENGTH  64              /// Instructions per translated block
+
+/////////////////////////////////////////////////
+/// Internal Prototype Functions
+/////////////////////////////////////////////////
+
+/// Used by the core to drive the JIT engine, not part of the public API
+chip8_error_t chip_jit_create(chip8_t *chip);
+void chip_jit_destroy(chip8_t *chip);
+uint32_t chip_jit_execute(chip8_t *chip, uint32_t cycles);
+void chip_jit_invalidate(chip8_t *chip, uint16_t addr);
+
+#endif //CHIP8_CHIP8_JIT_H
@@ -0,0 +1,1179 @@
+/////////////////////////////////////////////////
+/// Includes
+/////////////////////////////////////////////////
+
+#include "CHIP8_Lockstep.h"
+#include "CHIP8_State.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if CHIP8_HAS_LOCKSTEP
+
+/////////////////////////////////////////////////
+/// Defines
+/////////////////////////////////////////////////
+
+#define CHIP8_LS_WIDTH              CHIP8_LOCKSTEP_WIDTH
+#define CHIP8_LS_DIVERGED           0x10000u    /// Lanes no longer share a PC, group->PC holds each lane's next PC
+#define CHIP8_LS_NO_PC              0x10000u    /// Larger than every 16-bit PC
+#define CHIP8_LS_FNV_OFFSET_BASIS   0xCBF29CE484222325ULL
+#define CHIP8_LS_FNV_PRIME          0x100000001B3ULL
+
+/// Wide vectors are never passed by value, so these are macros rather than functions
+#define CHIP8_LS_BLEND(mask, a, b)  (((a) & (mask)) | ((b) & ~(mask)))
+#define CHIP8_LS_WIDEN16(mask8)     ((chip8_ls_u16_t)__builtin_convertvector((chip8_ls_m8_t)(mask8), chip8_ls_m16_t))
+#define CHIP8_LS_WIDEN32(mask8)     ((chip8_ls_u32_t)__builtin_convertvector((chip8_ls_m8_t)(mask8), chip8_ls_m32_t))
+#define CHIP8_LS_WIDEN64(mask8)     ((chip8_ls_u64_t)__builtin_convertvector((chip8_ls_m8_t)(mask8), chip8_ls_m64_t))
+#define CHIP8_LS_NARROW16(mask16)   ((chip8_ls_u8_t)__builtin_convertvector((chip8_ls_m16_t)(mask16), chip8_ls_m8_t))
+#define CHIP8_LS_NARROW32(mask32)   ((chip8_ls_u8_t)__builtin_convertvector((chip8_ls_m32_t)(mask32), chip8_ls_m8_t))
+#define CHIP8_LS_NARROW64(mask64)   ((chip8_ls_u8_t)__builtin_convertvector((chip8_ls_m64_t)(mask64), chip8_ls_m8_t))
+#define CHIP8_LS_NONE(vector)       chip_ls_none(&(vector), sizeof(vector))
+#define CHIP8_LS_FOR_EACH_LANE(mask8, lane) \
+    for(uint32_t lane = 0; lane < CHIP8_LS_WIDTH; lane++) if( (mask8)[lane] != 0 )
+
+/////////////////////////////////////////////////
+/// Typedef variables
+/////////////////////////////////////////////////
+
+/// One element per lane, masks are all ones for a selected lane
+typedef uint8_t     chip8_ls_u8_t   __attribute__((vector_size(CHIP8_LS_WIDTH)));
+typedef int8_t      chip8_ls_m8_t   __attribute__((vector_size(CHIP8_LS_WIDTH)));
+typedef uint16_t    chip8_ls_u16_t  __attribute__((vector_size(CHIP8_LS_WIDTH * 2)));
+typedef int16_t     chip8_ls_m16_t  __attribute__((vector_size(CHIP8_LS_WIDTH * 2)));
+typedef uint32_t    chip8_ls_u32_t  __attribute__((vector_size(CHIP8_LS_WIDTH * 4)));
+typedef int32_t     chip8_ls_m32_t  __attribute__((vector_size(CHIP8_LS_WIDTH * 4)));
+typedef uint64_t    chip8_ls_u64_t  __attribute__((vector_size(CHIP8_LS_WIDTH * 8)));
+typedef int64_t     chip8_ls_m64_t  __attribute__((vector_size(CHIP8_LS_WIDTH * 8)));
+
+/////////////////////////////////////////////////
+/// Typedef structures
+/////////////////////////////////////////////////
+
+/// CHIP8_LOCKSTEP_WIDTH VMs, every field is indexed by lane last
+typedef struct CHIP8_LOCKSTEP_GROUP_STRUCT
+{
+    chip8_ls_u8_t   memory[CHIP8_MEMORY_SIZE];          /// memory[addr][lane]
+    chip8_ls_u64_t  rows[CHIP8_LORES_HEIGHT_SCREEN];    /// Word 0 of the chip8_screen_t rows
+    chip8_ls_u16_t  stack[CHIP8_STACK_DEPTH_TOTAL];
+    chip8_ls_u8_t   V[CHIP8_DATA_REGISTERS_TOTAL];
+    chip8_ls_u16_t  I;
+    chip8_ls_u16_t  PC;
+    chip8_ls_u8_t   SP;
+    chip8_ls_u8_t   delayTimer;
+    chip8_ls_u8_t   soundTimer;
+    chip8_ls_u16_t  keys;           /// Pressed keys, bit n is key n
+    chip8_ls_u16_t  keyWaitPressed; /// Keys pressed while parked in FX0A, releasing one of them resumes
+    chip8_ls_u8_t   keyWaitReg;     /// Register FX0A stores the key in
+    chip8_ls_u8_t   fault;          /// chip8_error_t of the first fault, CHIP8_ERROR_NO while running
+    chip8_ls_u8_t   valid;          /// Lanes backed by a VM, the last group may be partial
+    chip8_ls_u32_t  remaining;      /// Instructions left in the current tick
+    chip8_ls_u64_t  rng;
+    chip8_ls_u64_t  cycles;
+    bool            uniformCode;    /// Memory is identical in every live lane, so one lane's opcode is everyone's
+
+} chip8_ls_group_t;
+
+/// Lanes executing the current instruction, lead is the lowest of them
+typedef struct CHIP8_LS_CONTEXT_STRUCT
+{
+    chip8_ls_group_t    *group;
+    chip8_ls_u8_t       mask8;
+    chip8_ls_u16_t      mask16;
+    chip8_ls_u64_t      mask64;
+    uint32_t            lead;
+    uint32_t            count;      /// Lanes in the mask
+
+} chip8_ls_context_t;
+
+/////////////////////////////////////////////////
+/// Prototype static functions
+/////////////////////////////////////////////////
+
+static void chip_ls_run_group(chip8_lockstep_t *lockstep, chip8_ls_group_t *group, uint32_t budget);
+static bool chip_ls_select(chip8_ls_group_t *group, chip8_ls_context_t *ctx, uint32_t *pc, uint32_t *wait_pc, uint32_t *run);
+static uint32_t chip_ls_execute(chip8_ls_context_t *ctx, uint16_t pc);
+static uint32_t chip_ls_skip(chip8_ls_context_t *ctx, uint16_t pc, const chip8_ls_u8_t *cond);
+static uint32_t chip_ls_jump(chip8_ls_context_t *ctx, const chip8_ls_u16_t *target);
+static uint32_t chip_ls_fault(chip8_ls_context_t *ctx, const chip8_ls_u8_t *lanes, chip8_error_t err, uint16_t next_pc);
+static uint32_t chip_ls_call(chip8_ls_context_t *ctx, uint16_t pc, uint16_t nnn);
+static uint32_t chip_ls_ret(chip8_ls_context_t *ctx, uint16_t pc);
+static uint32_t chip_ls_draw(chip8_ls_context_t *ctx, uint16_t pc, uint8_t x, uint8_t y, uint8_t n);
+static uint32_t chip_ls_store_bcd(chip8_ls_context_t *ctx, uint16_t pc, uint8_t x);
+static uint32_t chip_ls_store_regs(chip8_ls_context_t *ctx, uint16_t pc, uint8_t x);
+static uint32_t chip_ls_load_regs(chip8_ls_context_t *ctx, uint16_t pc, uint8_t x);
+static bool chip_ls_code_matches(chip8_ls_context_t *ctx, uint16_t pc);
+static void chip_ls_note_write(chip8_ls_context_t *ctx, bool uniform);
+static bool chip_ls_uniform8(chip8_ls_context_t *ctx, const chip8_ls_u8_t *value);
+static bool chip_ls_uniform16(chip8_ls_context_t *ctx, const chip8_ls_u16_t *value);
+static inline bool chip_ls_none(const void *vector, uint32_t size);
+static inline uint32_t chip_ls_count(const chip8_ls_u8_t *mask);
+static inline uint32_t chip_ls_first(const chip8_ls_u8_t *mask);
+static inline uint32_t chip_ls_min16(const chip8_ls_u16_t *value);
+static inline uint32_t chip_ls_min32(const chip8_ls_u32_t *value);
+static inline uint16_t chip_ls_opcode(chip8_ls_group_t *group, uint16_t pc, uint32_t lane);
+
+/////////////////////////////////////////////////
+/// Public functions
+/////////////////////////////////////////////////
+
+chip8_error_t CHIP8_LockstepCreate(chip8_lockstep_t **plockstep, uint32_t lanes, const chip8_config_t *config, uint8_t *program_buff, uint32_t size)
+{
+    chip8_lockstep_t *lockstep = NULL;
+    chip8_t *image = NULL;
+
+    if( plockstep == NULL || lanes == 0 )
+    {
+        return CHIP8_ERROR_INIT;
+    }
+
+    if( size > CHIP8_MEMORY_SIZE - CHIP8_PROGRAM_START_ADDR )
+    {
+        return CHIP8_ERROR_DATA_OVERSIZE;
+    }
+
+    /// The core builds the initial memory image so fonts and loading stay in one place
+    image = (chip8_t *)malloc(sizeof(chip8_t));
+    lockstep = (chip8_lockstep_t *)calloc(1, sizeof(chip8_lockstep_t));
+    if( image == NULL || lockstep == NULL || CHIP8_InitWithConfig(image, config, NULL, program_buff, size) != CHIP8_ERROR_NO )
+    {
+        free(image);
+        free(lockstep);
+        return CHIP8_ERROR_INIT;
+    }
+
+    lockstep->lanes = lanes;
+    lockstep->groupCount = (lanes + CHIP8_LS_WIDTH - 1) / CHIP8_LS_WIDTH;
+    lockstep->ips = CHIP8_DEFAULT_IPS;
+    lockstep->groups = (chip8_ls_group_t *)aligned_alloc(_Alignof(chip8_ls_group_t), lockstep->groupCount * sizeof(chip8_ls_group_t));
+    if( lockstep->groups == NULL )
+    {
+        CHIP8_Deinit(image);
+        free(image);
+        free(lockstep);
+        return CHIP8_ERROR_INIT;
+    }
+
+    memset((void *)lockstep->groups, 0, lockstep->groupCount * sizeof(chip8_ls_group_t));
+
+    for(uint32_t itr = 0; itr < lockstep->groupCount; itr++)
+    {
+        chip8_ls_group_t *group = &lockstep->groups[itr];
+
+        for(uint32_t addr = 0; addr < CHIP8_MEMORY_SIZE; addr++)
+        {
+            group->memory[addr] = (chip8_ls_u8_t){ 0 } + image->memory[addr];
+        }
+
+        group->PC = (chip8_ls_u16_t){ 0 } + CHIP8_PROGRAM_START_ADDR;
+        group->uniformCode = true;
+
+        for(uint32_t lane = 0; lane < CHIP8_LS_WIDTH && itr * CHIP8_LS_WIDTH + lane < lanes; lane++)
+        {
+            group->valid[lane] = 0xFF;
+        }
+    }
+
+    for(uint32_t lane = 0; lane < lanes; lane++)
+    {
+        CHIP8_LockstepSetSeed(lockstep, lane, ((config != NULL) ? config->seed : 0) + lane);
+    }
+
+    CHIP8_Deinit(image);
+    free(image);
+
+    (*plockstep) = lockstep;
+    return CHIP8_ERROR_NO;
+}
+
+void CHIP8_LockstepDestroy(chip8_lockstep_t *lockstep)
+{
+    if( lockstep == NULL )
+    {
+        return;
+    }
+
+    free(lockstep->groups);
+    free(lockstep);
+}
+
+void CHIP8_LockstepSetSeed(chip8_lockstep_t *lockstep, uint32_t lane, uint64_t seed)
+{
+    if( lane >= lockstep->lanes )
+    {
+        return;
+    }
+
+    /// Same derivation as a standalone VM, so a lane and CHIP8_SetSeed agree on every CXNN result
+    lockstep->groups[lane / CHIP8_LS_WIDTH].rng[lane % CHIP8_LS_WIDTH] = chip_seed_state(seed);
+}
+
+chip8_error_t CHIP8_LockstepSetKeys(chip8_lockstep_t *lockstep, uint32_t lane, uint16_t keys)
+{
+    if( lockstep == NULL || lane >= lockstep->lanes )
+    {
+        return CHIP8_ERROR_INVALID_INDEX;
+    }
+
+    chip8_ls_group_t *group = &lockstep->groups[lane / CHIP8_LS_WIDTH];
+    lane %= CHIP8_LS_WIDTH;
+
+    uint16_t released = group->keys[lane] & (uint16_t)~keys;
+    uint16_t pressed = keys & (uint16_t)~group->keys[lane];
+    group->keys[lane] = keys;
+
+    /// Same wake rule as the scalar core, releases count before presses of the same call
+    if( group->fault[lane] == CHIP8_ERROR_WAITING_FOR_KEY )
+    {
+        uint16_t wake = released & group->keyWaitPressed[lane];
+
+        if( wake != 0 )
+        {
+            group->V[group->keyWaitReg[lane]][lane] = (uint8_t)__builtin_ctz(wake);
+            group->fault[lane] = CHIP8_ERROR_NO;
+        }
+        else
+        {
+            group->keyWaitPressed[lane] |= pressed;
+        }
+    }
+
+    return CHIP8_ERROR_NO;
+}
+
+uint16_t CHIP8_LockstepGetKeys(chip8_lockstep_t *lockstep, uint32_t lane)
+{
+    if( lockstep == NULL || lane >= lockstep->lanes )
+    {
+        return 0;
+    }
+
+    return lockstep->groups[lane / CHIP8_LS_WIDTH].keys[lane % CHIP8_LS_WIDTH];
+}
+
+chip8_error_t CHIP8_LockstepSetSpeed(chip8_lockstep_t *lockstep, uint32_t ips)
+{
+    if( lockstep == NULL )
+    {
+        return CHIP8_ERROR_INIT;
+    }
+
+    if( ips == CHIP8_IPS_UNBOUNDED )
+    {
+        return CHIP8_ERROR_NOT_SUPPORTED;
+    }
+
+    lockstep->ips = ips;
+    lockstep->ipsRemainder = 0;
+
+    return CHIP8_ERROR_NO;
+}
+
+chip8_error_t CHIP8_LockstepRunFrame(chip8_lockstep_t *lockstep)
+{
+    if( lockstep == NULL )
+    {
+        return CHIP8_ERROR_INIT;
+    }
+
+    /// Spread ips over the ticks exactly like the scalar scheduler
+    uint32_t total = lockstep->ips + lockstep->ipsRemainder;
+    uint32_t budget = total / CHIP8_TIMER_FREQUENCY_HZ;
+    lockstep->ipsRemainder = total % CHIP8_TIMER_FREQUENCY_HZ;
+
+    for(uint32_t itr = 0; itr < lockstep->groupCount; itr++)
+    {
+        chip_ls_run_group(lockstep, &lockstep->groups[itr], budget);
+    }
+
+    lockstep->ticks++;
+    return CHIP8_ERROR_NO;
+}
+
+chip8_error_t CHIP8_LockstepGetStatus(chip8_lockstep_t *lockstep, uint32_t lane)
+{
+    if( lane >= lockstep->lanes )
+    {
+        return CHIP8_ERROR_INVALID_INDEX;
+    }
+
+    return (chip8_error_t)lockstep->groups[lane / CHIP8_LS_WIDTH].fault[lane % CHIP8_LS_WIDTH];
+}
+
+uint64_t CHIP8_LockstepScreenHash(chip8_lockstep_t *lockstep, uint32_t lane)
+{
+    /// Same FNV-1a as CHIP8_ScreenHash
+    uint64_t hash = CHIP8_LS_FNV_OFFSET_BASIS;
+
+    if( lane >= lockstep->lanes )
+    {
+        return 0;
+    }
+
+    chip8_ls_group_t *group = &lockstep->groups[lane / CHIP8_LS_WIDTH];
+    lane %= CHIP8_LS_WIDTH;
+
+    for(uint32_t row = 0; row < CHIP8_LORES_HEIGHT_SCREEN; row++)
+    {
+        for(int32_t shift = 56; shift >= 0; shift -= 8)
+        {
+            hash ^= (group->rows[row][lane] >> shift) & 0xFF;
+            hash *= CHIP8_LS_FNV_PRIME;
+        }
+    }
+
+    return hash;
+}
+
+chip8_error_t CHIP8_LockstepExtract(chip8_lockstep_t *lockstep, uint32_t lane, chip8_t *chip, chip8_keymap_t *keymap)
+{
+    uint8_t program[CHIP8_MEMORY_SIZE - CHIP8_PROGRAM_START_ADDR];
+
+    if( lockstep == NULL || chip == NULL || lane >= lockstep->lanes )
+    {
+        return CHIP8_ERROR_INVALID_INDEX;
+    }
+
+    chip8_ls_group_t *group = &lockstep->groups[lane / CHIP8_LS_WIDTH];
+    lane %= CHIP8_LS_WIDTH;
+
+    /// Loading the lane's program region through the core also builds its decode cache
+    for(uint32_t itr = 0; itr < sizeof(program); itr++)
+    {
+        program[itr] = group->memory[CHIP8_PROGRAM_START_ADDR + itr][lane];
+    }
+
+    chip8_error_t err = CHIP8_Init(chip, keymap, program, sizeof(program));
+    if( err != CHIP8_ERROR_NO )
+    {
+        return err;
+    }
+
+    for(uint32_t addr = 0; addr < CHIP8_PROGRAM_START_ADDR; addr++)
+    {
+        chip->memory[addr] = group->memory[addr][lane];
+    }
+
+    for(uint32_t itr = 0; itr < CHIP8_DATA_REGISTERS_TOTAL; itr++)
+    {
+        chip->registers.V[itr] = group->V[itr][lane];
+    }
+
+    for(uint32_t itr = 0; itr < CHIP8_STACK_DEPTH_TOTAL; itr++)
+    {
+        chip->stack[itr] = group->stack[itr][lane];
+    }
+
+    for(uint32_t row = 0; row < CHIP8_LORES_HEIGHT_SCREEN; row++)
+    {
+        chip->screen.rows[row][0] = group->rows[row][lane];
+    }
+
+    chip->registers.I = group->I[lane];
+    chip->registers.PC = group->PC[lane];
+    chip->registers.SP = group->SP[lane];
+    chip->registers.delayTimer = group->delayTimer[lane];
+    chip->registers.soundTimer = group->soundTimer[lane];
+    chip->fault = (chip8_error_t)group->fault[lane];
+    chip->rng = group->rng[lane];
+    chip->keys = group->keys[lane];
+
+    /// A parked lane continues as a VM waiting in the FX0A just before PC
+    if( chip->fault == CHIP8_ERROR_WAITING_FOR_KEY )
+    {
+        chip->fault = CHIP8_ERROR_NO;
+        chip->keyWait = true;
+        chip->keyWaitReg = group->keyWaitReg[lane];
+        chip->keyWaitPressed = group->keyWaitPressed[lane];
+    }
+
+    chip->scheduler.ips = lockstep->ips;
+    chip->scheduler.ipsRemainder = lockstep->ipsRemainder;
+    chip->scheduler.cycles = group->cycles[lane];
+    chip->scheduler.ticks = lockstep->ticks;
+
+    /// Dirty state is not tracked per lane
+    chip_screen_invalidate(chip);
+
+    return CHIP8_ERROR_NO;
+}
+
+/////////////////////////////////////////////////
+/// Static functions
+/////////////////////////////////////////////////
+
+static void chip_ls_run_group(chip8_lockstep_t *lockstep, chip8_ls_group_t *group, uint32_t budget)
+{
+    chip8_ls_context_t ctx;
+    uint32_t pc;
+    uint32_t wait_pc;
+    uint32_t run;
+
+    /// Lanes that faulted before this tick neither run nor tick their timers, parked lanes only tick
+    chip8_ls_u8_t live = group->valid & (chip8_ls_u8_t)(group->fault == CHIP8_ERROR_NO);
+    chip8_ls_u8_t ticking = live | (group->valid & (chip8_ls_u8_t)(group->fault == CHIP8_ERROR_WAITING_FOR_KEY));
+    group->remaining = CHIP8_LS_WIDEN32(live) & budget;
+    ctx.group = group;
+
+    while( chip_ls_select(group, &ctx, &pc, &wait_pc, &run) )
+    {
+        uint32_t executed = 0;
+        uint32_t next = pc;
+
+        /// The selected lanes stay together until they diverge, run out of budget or reach a waiting lane
+        while( executed < run )
+        {
+            if( executed > 0 && (pc == wait_pc || (group->uniformCode == false && chip_ls_code_matches(&ctx, (uint16_t)pc) == false)) )
+            {
+                break;
+            }
+
+            next = chip_ls_execute(&ctx, (uint16_t)pc);
+            executed++;
+
+            if( next == CHIP8_LS_DIVERGED )
+            {
+                break;
+            }
+
+            pc = next;
+        }
+
+        if( next != CHIP8_LS_DIVERGED )
+        {
+            group->PC = CHIP8_LS_BLEND(ctx.mask16, (chip8_ls_u16_t){ 0 } + (uint16_t)pc, group->PC);
+        }
+
+        group->remaining -= CHIP8_LS_WIDEN32(ctx.mask8) & executed;
+        group->cycles += ctx.mask64 & executed;
+
+        lockstep->steps += executed;
+        lockstep->laneCycles += (uint64_t)executed * ctx.count;
+    }
+
+    group->delayTimer += (chip8_ls_u8_t)(group->delayTimer != 0) & ticking;
+    group->soundTimer += (chip8_ls_u8_t)(group->soundTimer != 0) & ticking;
+}
+
+static bool chip_ls_select(chip8_ls_group_t *group, chip8_ls_context_t *ctx, uint32_t *pc, uint32_t *wait_pc, uint32_t *run)
+{
+    const chip8_ls_u8_t live = (chip8_ls_u8_t)(group->fault == CHIP8_ERROR_NO) & CHIP8_LS_NARROW32(group->remaining != 0);
+
+    if( CHIP8_LS_NONE(live) )
+    {
+        return false;
+    }
+
+    /// Lowest PC first, forward skips then reconverge as soon as the skipped lanes catch up
+    const chip8_ls_u16_t pcs = group->PC | ~CHIP8_LS_WIDEN16(live);
+    const uint32_t lowest = chip_ls_min16(&pcs);
+    const chip8_ls_u8_t at_lowest = live & CHIP8_LS_NARROW16(pcs == (uint16_t)lowest);
+    chip8_ls_u8_t selected = at_lowest;
+
+    ctx->lead = chip_ls_first(&selected);
+
+    /// Lanes whose code was rewritten differently wait for a later pass at the same PC
+    if( group->uniformCode == false && lowest + 1 < CHIP8_MEMORY_SIZE )
+    {
+        selected &= (chip8_ls_u8_t)(group->memory[lowest] == group->memory[lowest][ctx->lead]);
+        selected &= (chip8_ls_u8_t)(group->memory[lowest + 1] == group->memory[lowest + 1][ctx->lead]);
+    }
+    else if( group->uniformCode == false && lowest < CHIP8_MEMORY_SIZE )
+    {
+        selected &= (chip8_ls_u8_t)(group->memory[lowest] == group->memory[lowest][ctx->lead]);
+    }
+
+    const chip8_ls_u16_t others = pcs | CHIP8_LS_WIDEN16(at_lowest);
+    const chip8_ls_u32_t budgets = group->remaining | ~CHIP8_LS_WIDEN32(selected);
+    const uint32_t second = chip_ls_min16(&others);
+
+    ctx->mask8 = selected;
+    ctx->mask16 = CHIP8_LS_WIDEN16(selected);
+    ctx->mask64 = CHIP8_LS_WIDEN64(selected);
+    ctx->count = chip_ls_count(&selected);
+
+    (*pc) = lowest;
+    (*wait_pc) = (second != UINT16_MAX) ? second : CHIP8_LS_NO_PC;
+    (*run) = chip_ls_min32(&budgets);
+
+    return true;
+}
+
+static uint32_t chip_ls_execute(chip8_ls_context_t *ctx, uint16_t pc)
+{
+    chip8_ls_group_t *g = ctx->group;
+    const chip8_ls_u8_t m8 = ctx->mask8;
+    const chip8_ls_u16_t m16 = ctx->mask16;
+    const uint16_t opcode = chip_ls_opcode(g, pc, ctx->lead);
+    const uint16_t next = pc + 2;
+    const uint16_t nnn = opcode & 0x0FFF;
+    const uint8_t nn = opcode & 0x00FF;
+    const uint8_t x = (opcode & 0x0F00) >> 8;
+    const uint8_t y = (opcode & 0x00F0) >> 4;
+    chip8_ls_u8_t cond;
+    chip8_ls_u8_t vx = g->V[x];
+    chip8_ls_u8_t vy = g->V[y];
+
+    switch( opcode >> 12 )
+    {
+        case 0x0:
+            if( opcode == 0x00E0 )
+            {
+                /// Clear screen.
+                for(uint32_t row = 0; row < CHIP8_LORES_HEIGHT_SCREEN; row++)
+                {
+                    g->rows[row] &= ~ctx->mask64;
+                }
+                return next;
+            }
+            else if( opcode == 0x00EE )
+            {
+                return chip_ls_ret(ctx, pc);
+            }
+            break;
+
+        case 0x1:
+            /// Jump to address NNN.
+            return nnn;
+
+        case 0x2:
+            return chip_ls_call(ctx, pc, nnn);
+
+        case 0x3:
+            /// Skip next instruction if Vx = NN.
+            cond = (chip8_ls_u8_t)(vx == nn);
+            return chip_ls_skip(ctx, pc, &cond);
+
+        case 0x4:
+            /// Skip next instruction if Vx != NN.
+            cond = (chip8_ls_u8_t)(vx != nn);
+            return chip_ls_skip(ctx, pc, &cond);
+
+        case 0x5:
+            /// Skip next instruction if Vx = Vy.
+            cond = (chip8_ls_u8_t)(vx == vy);
+            return chip_ls_skip(ctx, pc, &cond);
+
+        case 0x6:
+            /// Set Vx = NN.
+            g->V[x] = CHIP8_LS_BLEND(m8, (chip8_ls_u8_t){ 0 } + nn, vx);
+            return next;
+
+        case 0x7:
+            /// Set Vx = Vx + NN.
+            g->V[x] = vx + (m8 & nn);
+            return next;
+
+        case 0x8:
+        {
+            chip8_ls_u8_t result;
+            chip8_ls_u8_t flag;
+
+            /// VF is written after Vx so it holds the flag when x is F
+            switch( opcode & 0x000F )
+            {
+                case 0x0: g->V[x] = CHIP8_LS_BLEND(m8, vy, vx); return next;
+                case 0x1: g->V[x] = vx | (vy & m8); return next;
+                case 0x2: g->V[x] = vx & (vy | ~m8); return next;
+                case 0x3: g->V[x] = vx ^ (vy & m8); return next;
+                case 0x4: result = vx + vy; flag = (chip8_ls_u8_t)(result < vx); break;
+                case 0x5: result = vx - vy; flag = (chip8_ls_u8_t)(vx >= vy); break;
+                case 0x6: result = vx >> 1; flag = (chip8_ls_u8_t)((vx & 0x01) != 0); break;
+                case 0x7: result = vy - vx; flag = (chip8_ls_u8_t)(vy >= vx); break;
+                case 0xE: result = vx << 1; flag = (chip8_ls_u8_t)((vx & 0x80) != 0); break;
+                default: return chip_ls_fault(ctx, &m8, CHIP8_ERROR_INVALID_OPCODE, next);
+            }
+
+            g->V[x] = CHIP8_LS_BLEND(m8, result, vx);
+            g->V[0xF] = CHIP8_LS_BLEND(m8, flag & 1, g->V[0xF]);
+            return next;
+        }
+
+        case 0x9:
+            /// Skip next instruction if Vx != Vy.
+            cond = (chip8_ls_u8_t)(vx != vy);
+            return chip_ls_skip(ctx, pc, &cond);
+
+        case 0xA:
+            /// Set I = NNN
+            g->I = CHIP8_LS_BLEND(m16, (chip8_ls_u16_t){ 0 } + nnn, g->I);
+            return next;
+
+        case 0xB:
+        {
+            /// Jump to location NNN + V0.
+            chip8_ls_u16_t target = __builtin_convertvector(g->V[0], chip8_ls_u16_t) + nnn;
+            return chip_ls_jump(ctx, &target);
+        }
+
+        case 0xC:
+        {
+            /// Set Vx = random byte AND NN, one xorshift64* stream per lane.
+            chip8_ls_u64_t state = g->rng;
+            state ^= state >> 12;
+            state ^= state << 25;
+            state ^= state >> 27;
+            g->rng = CHIP8_LS_BLEND(ctx->mask64, state, g->rng);
+
+            chip8_ls_u8_t random = __builtin_convertvector((state * 0x2545F4914F6CDD1DULL) >> 56, chip8_ls_u8_t);
+            g->V[x] = CHIP8_LS_BLEND(m8, random & nn, vx);
+            return next;
+        }
+
+        case 0xD:
+            /// DXY0 is a SCHIP 16x16 sprite, lanes only have the low resolution screen
+            if( (opcode & 0x000F) == 0 )
+            {
+                break;
+            }
+            return chip_ls_draw(ctx, pc, x, y, opcode & 0x000F);
+
+        case 0xE:
+        {
+            /// Each lane tests its own key mask with its own Vx
+            chip8_ls_u16_t down = (g->keys >> (__builtin_convertvector(vx, chip8_ls_u16_t) & 0xF)) & 1;
+
+            if( nn == 0x9E )
+            {
+                /// Skip next instruction if key with the value of Vx is pressed.
+                cond = CHIP8_LS_NARROW16(down != 0);
+                return chip_ls_skip(ctx, pc, &cond);
+            }
+            if( nn == 0xA1 )
+            {
+                /// Skip next instruction if key with the value of Vx is not pressed.
+                cond = CHIP8_LS_NARROW16(down == 0);
+                return chip_ls_skip(ctx, pc, &cond);
+            }
+            break;
+        }
+
+        case 0xF:
+            switch( nn )
+            {
+                case 0x07: g->V[x] = CHIP8_LS_BLEND(m8, g->delayTimer, vx); return next;
+                case 0x0A:  /// The lane parks until CHIP8_LockstepSetKeys releases a key pressed meanwhile
+                    g->keyWaitReg = CHIP8_LS_BLEND(m8, (chip8_ls_u8_t){ 0 } + x, g->keyWaitReg);
+                    g->keyWaitPressed &= ~m16;
+                    return chip_ls_fault(ctx, &m8, CHIP8_ERROR_WAITING_FOR_KEY, next);
+                case 0x15: g->delayTimer = CHIP8_LS_BLEND(m8, vx, g->delayTimer); return next;
+                case 0x18: g->soundTimer = CHIP8_LS_BLEND(m8, vx, g->soundTimer); return next;
+                case 0x1E: g->I += __builtin_convertvector(vx, chip8_ls_u16_t) & m16; return next;
+                case 0x29:
+                    g->I = CHIP8_LS_BLEND(m16, __builtin_convertvector(vx, chip8_ls_u16_t) * CHIP8_FONT_GLYPH_SIZE + CHIP8_FONT_ADDR, g->I);
+                    return next;
+                case 0x30:
+                    g->I = CHIP8_LS_BLEND(m16, __builtin_convertvector(vx, chip8_ls_u16_t) * CHIP8_BIG_FONT_GLYPH_SIZE + CHIP8_BIG_FONT_ADDR, g->I);
+                    return next;
+                case 0x33: return chip_ls_store_bcd(ctx, pc, x);
+                case 0x55: return chip_ls_store_regs(ctx, pc, x);
+                case 0x65: return chip_ls_load_regs(ctx, pc, x);
+                default: break;
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    return chip_ls_fault(ctx, &m8, CHIP8_ERROR_INVALID_OPCODE, next);
+}
+
+static uint32_t chip_ls_skip(chip8_ls_context_t *ctx, uint16_t pc, const chip8_ls_u8_t *cond)
+{
+    chip8_ls_u8_t taken = (*cond) & ctx->mask8;
+    chip8_ls_u8_t not_taken = ~(*cond) & ctx->mask8;
+
+    if( CHIP8_LS_NONE(taken) )
+    {
+        return (uint16_t)(pc + 2);
+    }
+
+    if( CHIP8_LS_NONE(not_taken) )
+    {
+        return (uint16_t)(pc + 4);
+    }
+
+    chip8_ls_u16_t next = ((chip8_ls_u16_t){ 0 } + (uint16_t)(pc + 2)) + (CHIP8_LS_WIDEN16(taken) & 2);
+    ctx->group->PC = CHIP8_LS_BLEND(ctx->mask16, next, ctx->group->PC);
+    return CHIP8_LS_DIVERGED;
+}
+
+static uint32_t chip_ls_jump(chip8_ls_context_t *ctx, const chip8_ls_u16_t *target)
+{
+    if( chip_ls_uniform16(ctx, target) )
+    {
+        return (*target)[ctx->lead];
+    }
+
+    ctx->group->PC = CHIP8_LS_BLEND(ctx->mask16, *target, ctx->group->PC);
+    return CHIP8_LS_DIVERGED;
+}
+
+static uint32_t chip_ls_fault(chip8_ls_context_t *ctx, const chip8_ls_u8_t *lanes, chip8_error_t err, uint16_t next_pc)
+{
+    chip8_ls_group_t *group = ctx->group;
+
+    /// The faulting instruction retires and PC moves on as in the scalar engines, then the lane stops
+    group->fault = CHIP8_LS_BLEND(*lanes, (chip8_ls_u8_t){ 0 } + (uint8_t)err, group->fault);
+    group->PC = CHIP8_LS_BLEND(ctx->mask16, (chip8_ls_u16_t){ 0 } + next_pc, group->PC);
+
+    return CHIP8_LS_DIVERGED;
+}
+
+static uint32_t chip_ls_call(chip8_ls_context_t *ctx, uint16_t pc, uint16_t nnn)
+{
+    /// Call subroutine at NNN.
+    chip8_ls_group_t *g = ctx->group;
+    const uint16_t ret = pc + 2;
+
+    if( chip_ls_uniform8(ctx, &g->SP) )
+    {
+        uint8_t sp = g->SP[ctx->lead];
+
+        if( sp >= CHIP8_STACK_DEPTH_TOTAL )
+        {
+            return chip_ls_fault(ctx, &ctx->mask8, CHIP8_ERROR_STACK_FULL, nnn);
+        }
+
+        g->stack[sp] = CHIP8_LS_BLEND(ctx->mask16, (chip8_ls_u16_t){ 0 } + ret, g->stack[sp]);
+        g->SP -= (chip8_ls_u8_t)ctx->mask8;
+        return nnn;
+    }
+
+    chip8_ls_u8_t full = { 0 };
+    CHIP8_LS_FOR_EACH_LANE(ctx->mask8, lane)
+    {
+        uint8_t sp = g->SP[lane];
+
+        if( sp >= CHIP8_STACK_DEPTH_TOTAL )
+        {
+            full[lane] = 0xFF;
+            continue;
+        }
+
+        g->stack[sp][lane] = ret;
+        g->SP[lane] = sp + 1;
+    }
+
+    return CHIP8_LS_NONE(full) ? nnn : chip_ls_fault(ctx, &full, CHIP8_ERROR_STACK_FULL, nnn);
+}
+
+static uint32_t chip_ls_ret(chip8_ls_context_t *ctx, uint16_t pc)
+{
+    /// Return from subroutine.
+    chip8_ls_group_t *g = ctx->group;
+    chip8_ls_u16_t target = g->PC;
+    chip8_ls_u8_t empty = { 0 };
+
+    CHIP8_LS_FOR_EACH_LANE(ctx->mask8, lane)
+    {
+        uint8_t sp = g->SP[lane];
+
+        if( sp == 0 )
+        {
+            empty[lane] = 0xFF;
+            target[lane] = pc + 2;
+            continue;
+        }
+
+        g->SP[lane] = sp - 1;
+        target[lane] = g->stack[sp - 1][lane];
+    }
+
+    if( CHIP8_LS_NONE(empty) == false )
+    {
+        g->fault = CHIP8_LS_BLEND(empty, (chip8_ls_u8_t){ 0 } + (uint8_t)CHIP8_ERROR_STACK_EMPTY, g->fault);
+        g->PC = CHIP8_LS_BLEND(ctx->mask16, target, g->PC);
+        return CHIP8_LS_DIVERGED;
+    }
+
+    return chip_ls_jump(ctx, &target);
+}
+
+static uint32_t chip_ls_draw(chip8_ls_context_t *ctx, uint16_t pc, uint8_t x, uint8_t y, uint8_t n)
+{
+    /// Display n-byte sprite starting at memory location I at (Vx, Vy), set VF = collision.
+    chip8_ls_group_t *g = ctx->group;
+    const uint16_t next = pc + 2;
+    const chip8_ls_u8_t vx = g->V[x];
+    const chip8_ls_u8_t vy = g->V[y];
+
+    if( chip_ls_uniform16(ctx, &g->I) && chip_ls_uniform8(ctx, &vy) )
+    {
+        const uint32_t addr = g->I[ctx->lead];
+        const uint32_t top = vy[ctx->lead];
+
+        if( addr + n > CHIP8_MEMORY_SIZE )
+        {
+            return chip_ls_fault(ctx, &ctx->mask8, CHIP8_ERROR_INVALID_INDEX, next);
+        }
+
+        /// Same rows in every lane, the per lane x becomes a variable rotate
+        const chip8_ls_u64_t shift = __builtin_convertvector(vx, chip8_ls_u64_t) % CHIP8_LORES_WIDTH_SCREEN;
+        chip8_ls_u64_t collision = { 0 };
+
+        for(uint32_t ly = 0; ly < n; ly++)
+        {
+            chip8_ls_u64_t sprite = __builtin_convertvector(g->memory[addr + ly], chip8_ls_u64_t) << 56;
+            chip8_ls_u64_t mask = ((sprite >> shift) | (sprite << ((64 - shift) & 63))) & ctx->mask64;
+            chip8_ls_u64_t *row = &g->rows[(ly + top) % CHIP8_LORES_HEIGHT_SCREEN];
+
+            collision |= (*row) & mask;
+            (*row) ^= mask;
+        }
+
+        g->V[0xF] = CHIP8_LS_BLEND(ctx->mask8, CHIP8_LS_NARROW64(collision != 0) & 1, g->V[0xF]);
+        return next;
+    }
+
+    chip8_ls_u8_t bad = { 0 };
+    CHIP8_LS_FOR_EACH_LANE(ctx->mask8, lane)
+    {
+        const uint32_t addr = g->I[lane];
+        const uint32_t shift = vx[lane] % CHIP8_LORES_WIDTH_SCREEN;
+        uint64_t collision = 0;
+
+        if( addr + n > CHIP8_MEMORY_SIZE )
+        {
+            bad[lane] = 0xFF;
+            continue;
+        }
+
+        for(uint32_t ly = 0; ly < n; ly++)
+        {
+            uint64_t sprite = (uint64_t)g->memory[addr + ly][lane] << 56;
+            uint64_t mask = (sprite >> shift) | (sprite << ((64 - shift) & 63));
+            uint32_t row = (ly + vy[lane]) % CHIP8_LORES_HEIGHT_SCREEN;
+
+            collision |= g->rows[row][lane] & mask;
+            g->rows[row][lane] ^= mask;
+        }
+
+        g->V[0xF][lane] = (collision != 0) ? 1 : 0;
+    }
+
+    return CHIP8_LS_NONE(bad) ? next : chip_ls_fault(ctx, &bad, CHIP8_ERROR_INVALID_INDEX, next);
+}
+
+static uint32_t chip_ls_store_bcd(chip8_ls_context_t *ctx, uint16_t pc, uint8_t x)
+{
+    /// Store BCD representation of Vx in memory locations I, I+1, and I+2.
+    chip8_ls_group_t *g = ctx->group;
+    const uint16_t next = pc + 2;
+    const chip8_ls_u8_t vx = g->V[x];
+
+    if( chip_ls_uniform16(ctx, &g->I) && g->I[ctx->lead] + 2 < CHIP8_MEMORY_SIZE )
+    {
+        const uint32_t addr = g->I[ctx->lead];
+
+        g->memory[addr] = CHIP8_LS_BLEND(ctx->mask8, vx / 100, g->memory[addr]);
+        g->memory[addr + 1] = CHIP8_LS_BLEND(ctx->mask8, vx / 10 % 10, g->memory[addr + 1]);
+        g->memory[addr + 2] = CHIP8_LS_BLEND(ctx->mask8, vx % 10, g->memory[addr + 2]);
+
+        chip_ls_note_write(ctx, chip_ls_uniform8(ctx, &vx));
+        return next;
+    }
+
+    /// Out of range digits are dropped, only the last one faults
+    chip8_ls_u8_t bad = { 0 };
+    CHIP8_LS_FOR_EACH_LANE(ctx->mask8, lane)
+    {
+        const uint8_t digits[3] = { vx[lane] / 100, vx[lane] / 10 % 10, vx[lane] % 10 };
+
+        for(uint32_t itr = 0; itr < 3; itr++)
+        {
+            uint16_t addr = g->I[lane] + itr;
+
+            if( addr < CHIP8_MEMORY_SIZE )
+            {
+                g->memory[addr][lane] = digits[itr];
+            }
+            else if( itr == 2 )
+            {
+                bad[lane] = 0xFF;
+            }
+        }
+    }
+
+    chip_ls_note_write(ctx, false);
+    return CHIP8_LS_NONE(bad) ? next : chip_ls_fault(ctx, &bad, CHIP8_ERROR_INVALID_INDEX, next);
+}
+
+static uint32_t chip_ls_store_regs(chip8_ls_context_t *ctx, uint16_t pc, uint8_t x)
+{
+    /// Store registers V0 through Vx in memory starting at location I.
+    chip8_ls_group_t *g = ctx->group;
+    const uint16_t next = pc + 2;
+
+    if( chip_ls_uniform16(ctx, &g->I) && g->I[ctx->lead] + x < CHIP8_MEMORY_SIZE )
+    {
+        const uint32_t addr = g->I[ctx->lead];
+        bool uniform = true;
+
+        for(uint32_t itr = 0; itr <= x; itr++)
+        {
+            g->memory[addr + itr] = CHIP8_LS_BLEND(ctx->mask8, g->V[itr], g->memory[addr + itr]);
+            uniform = uniform && chip_ls_uniform8(ctx, &g->V[itr]);
+        }
+
+        chip_ls_note_write(ctx, uniform);
+        return next;
+    }
+
+    chip8_ls_u8_t bad = { 0 };
+    CHIP8_LS_FOR_EACH_LANE(ctx->mask8, lane)
+    {
+        for(uint32_t itr = 0; itr <= x; itr++)
+        {
+            uint16_t addr = g->I[lane] + itr;
+
+            if( addr >= CHIP8_MEMORY_SIZE )
+            {
+                bad[lane] = 0xFF;
+                break;
+            }
+
+            g->memory[addr][lane] = g->V[itr][lane];
+        }
+    }
+
+    chip_ls_note_write(ctx, false);
+    return CHIP8_LS_NONE(bad) ? next : chip_ls_fault(ctx, &bad, CHIP8_ERROR_INVALID_INDEX, next);
+}
+
+static uint32_t chip_ls_load_regs(chip8_ls_context_t *ctx, uint16_t pc, uint8_t x)
+{
+    /// Read registers V0 through Vx from memory starting at location I.
+    chip8_ls_group_t *g = ctx->group;
+    const uint16_t next = pc + 2;
+
+    if( chip_ls_uniform16(ctx, &g->I) && g->I[ctx->lead] + x < CHIP8_MEMORY_SIZE )
+    {
+        const uint32_t addr = g->I[ctx->lead];
+
+        for(uint32_t itr = 0; itr <= x; itr++)
+        {
+            g->V[itr] = CHIP8_LS_BLEND(ctx->mask8, g->memory[addr + itr], g->V[itr]);
+        }
+        return next;
+    }
+
+    chip8_ls_u8_t bad = { 0 };
+    CHIP8_LS_FOR_EACH_LANE(ctx->mask8, lane)
+    {
+        for(uint32_t itr = 0; itr <= x; itr++)
+        {
+            uint16_t addr = g->I[lane] + itr;
+
+            if( addr >= CHIP8_MEMORY_SIZE )
+            {
+                bad[lane] = 0xFF;
+                break;
+            }
+
+            g->V[itr][lane] = g->memory[addr][lane];
+        }
+    }
+
+    return CHIP8_LS_NONE(bad) ? next : chip_ls_fault(ctx, &bad, CHIP8_ERROR_INVALID_INDEX, next);
+}
+
+static bool chip_ls_code_matches(chip8_ls_context_t *ctx, uint16_t pc)
+{
+    chip8_ls_group_t *group = ctx->group;
+
+    if( pc >= CHIP8_MEMORY_SIZE )
+    {
+        return true;
+    }
+
+    chip8_ls_u8_t differ = (chip8_ls_u8_t)(group->memory[pc] != group->memory[pc][ctx->lead]);
+    if( pc + 1 < CHIP8_MEMORY_SIZE )
+    {
+        differ |= (chip8_ls_u8_t)(group->memory[pc + 1] != group->memory[pc + 1][ctx->lead]);
+    }
+
+    differ &= ctx->mask8;
+    return CHIP8_LS_NONE(differ);
+}
+
+static void chip_ls_note_write(chip8_ls_context_t *ctx, bool uniform)
+{
+    chip8_ls_group_t *group = ctx->group;
+
+    /// Memory stays identical only if every live lane stored the same bytes at the same place
+    chip8_ls_u8_t missing = group->valid & (chip8_ls_u8_t)(group->fault == CHIP8_ERROR_NO) & ~ctx->mask8;
+
+    if( uniform == false || CHIP8_LS_NONE(missing) == false )
+    {
+        group->uniformCode = false;
+    }
+}
+
+static bool chip_ls_uniform8(chip8_ls_context_t *ctx, const chip8_ls_u8_t *value)
+{
+    chip8_ls_u8_t differ = (chip8_ls_u8_t)((*value) != (*value)[ctx->lead]) & ctx->mask8;
+    return CHIP8_LS_NONE(differ);
+}
+
+static bool chip_ls_uniform16(chip8_ls_context_t *ctx, const chip8_ls_u16_t *value)
+{
+    chip8_ls_u16_t differ = (chip8_ls_u16_t)((*value) != (*value)[ctx->lead]) & ctx->mask16;
+    return CHIP8_LS_NONE(differ);
+}
+
+static inline bool chip_ls_none(const void *vector, uint32_t size)
+{
+    const uint8_t *bytes = (const uint8_t *)vector;
+    uint64_t any = 0;
+
+    for(uint32_t itr = 0; itr < size; itr += sizeof(uint64_t))
+    {
+        uint64_t chunk;
+        memcpy(&chunk, &bytes[itr], sizeof(chunk));
+        any |= chunk;
+    }
+
+    return any == 0;
+}
+
+static inline uint32_t chip_ls_count(const chip8_ls_u8_t *mask)
+{
+    uint32_t count = 0;
+
+    for(uint32_t itr = 0; itr < CHIP8_LS_WIDTH; itr += sizeof(uint64_t))
+    {
+        uint64_t chunk;
+        memcpy(&chunk, &((const uint8_t *)mask)[itr], sizeof(chunk));
+        count += (uint32_t)__builtin_popcountll(chunk);
+    }
+
+    /// Selected lanes are all ones
+    return count / 8;
+}
+
+static inline uint32_t chip_ls_first(const chip8_ls_u8_t *mask)
+{
+    uint32_t lane = 0;
+
+    while( lane < CHIP8_LS_WIDTH && (*mask)[lane] == 0 )
+    {
+        lane++;
+    }
+
+    return lane;
+}
+
+static inline uint32_t chip_ls_min16(const chip8_ls_u16_t *value)
+{
+    uint32_t lowest = UINT16_MAX;
+
+    for(uint32_t lane = 0; lane < CHIP8_LS_WIDTH; lane++)
+    {
+        lowest = ((*value)[lane] < lowest) ? (*value)[lane] : lowest;
+    }
+
+    return lowest;
+}
+
+static inline uint32_t chip_ls_min32(const chip8_ls_u32_t *value)
+{
+    uint32_t lowest = UINT32_MAX;
+
+    for(uint32_t lane = 0; lane < CHIP8_LS_WIDTH; lane++)
+    {
+        lowest = ((*value)[lane] < lowest) ? (*value)[lane] : lowest;
+    }
+
+    return lowest;
+}
+
+static inline uint16_t chip_ls_opcode(chip8_ls_group_t *group, uint16_t pc, uint32_t lane)
+{
+    /// Bytes past the end of memory read as zero like chip_get_opcode
+    uint8_t high = (pc < CHIP8_MEMORY_SIZE) ? group->memory[pc][lane] : 0;
+    uint8_t low = (pc + 1 < CHIP8_MEMORY_SIZE) ? group->memory[pc + 1][lane] : 0;
+
+    return (uint16_t)(high << 8 | low);
+}
+
+#else
+
+/////////////////////////////////////////////////
+/// Public functions (vector extensions not available)
+/////////////////////////////////////////////////
+
+chip8_error_t CHIP8_LockstepCreate(chip8_lockstep_t **plockstep, uint32_t lanes, const chip8_config_t *config, uint8_t *program_buff, uint32_t size)
+{
+    (void)plockstep;
+    (void)lanes;
+    (void)config;
+    (void)program_buff;
+    (void)size;
+    return CHIP8_ERROR_NOT_SUPPORTED;
+}
+
+void CHIP8_LockstepDestroy(chip8_lockstep_t *lockstep)
+{
+    (void)lockstep;
+}
+
+void CHIP8_LockstepSetSeed(chip8_lockstep_t *lockstep, uint32_t lane, uint64_t seed)
+{
+    (void)lockstep;
+    (void)lane;
+    (void)seed;
+}
+
+chip8_error_t CHIP8_LockstepSetKeys(chip8_lockstep_t *lockstep, uint32_t lane, uint16_t keys)
+{
+    (void)lockstep;
+    (void)lane;
+    (void)keys;
+    return CHIP8_ERROR_NOT_SUPPORTED;
+}
+
+uint16_t CHIP8_LockstepGetKeys(chip8_lockstep_t *lockstep, uint32_t lane)
+{
+    (void)lockstep;
+    (void)lane;
+    return 0;
+}
+
+chip8_error_t CHIP8_LockstepSetSpeed(chip8_lockstep_t *lockstep, uint32_t ips)
+{
+    (void)lockstep;
+    (void)ips;
+    return CHIP8_ERROR_NOT_SUPPORTED;
+}
+
+chip8_error_t CHIP8_LockstepRunFrame(chip8_lockstep_t *lockstep)
+{
+    (void)lockstep;
+    return CHIP8_ERROR_NOT_SUPPORTED;
+}
+
+chip8_error_t CHIP8_LockstepGetStatus(chip8_lockstep_t *lockstep, uint32_t lane)
+{
+    (void)lockstep;
+    (void)lane;
+    return CHIP8_ERROR_NOT_SUPPORTED;
+}
+
+uint64_t CHIP8_LockstepScreenHash(chip8_lockstep_t *lockstep, uint32_t lane)
+{
+    (void)lockstep;
+    (void)lane;
+    return 0;
+}
+
+chip8_error_t CHIP8_LockstepExtract(chip8_lockstep_t *lockstep, uint32_t lane, chip8_t *chip, chip8_keymap_t *keymap)
+{
+    (void)lockstep;
+    (void)lane;
+    (void)chip;
+    (void)keymap;
+    return CHIP8_ERROR_NOT_SUPPORTED;
+}
+
+#endif
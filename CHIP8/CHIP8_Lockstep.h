@@ -0,0 +1,93 @@
+#ifndef CHIP8_CHIP8_LOCKSTEP_H
+#define CHIP8_CHIP8_LOCKSTEP_H
+
+/////////////////////////////////////////////////
+/// Includes
+/////////////////////////////////////////////////
+
+#include "CHIP8.h"
+
+/////////////////////////////////////////////////
+/// Defines
+/////////////////////////////////////////////////
+
+/// GCC/Clang vector extensions with __builtin_convertvector
+#if (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 9)) && !defined(CHIP8_NO_LOCKSTEP)
+#define CHIP8_HAS_LOCKSTEP          1
+#else
+#define CHIP8_HAS_LOCKSTEP          0
+#endif
+
+/// Lanes per vector group, one byte register of every lane fills one SIMD register
+#ifndef CHIP8_LOCKSTEP_WIDTH
+#if defined(CHIP8_NO_SIMD)
+#define CHIP8_LOCKSTEP_WIDTH        8
+#elif defined(__AVX512BW__)
+#define CHIP8_LOCKSTEP_WIDTH        64
+#elif defined(__AVX2__)
+#define CHIP8_LOCKSTEP_WIDTH        32
+#else
+#define CHIP8_LOCKSTEP_WIDTH        16
+#endif
+#endif
+
+/////////////////////////////////////////////////
+/// Typedef structures
+/////////////////////////////////////////////////
+
+struct CHIP8_LOCKSTEP_GROUP_STRUCT;
+
+/// Many VMs of one ROM stored lane-major and stepped together.
+/// Lanes that share a PC execute each instruction as one vector operation, diverged lanes are
+/// scheduled in subsets (lowest PC first) and merge again when their PCs meet.
+/// Lanes only have the 64x32 screen, SCHIP instructions other than FX30 fault with CHIP8_ERROR_INVALID_OPCODE.
+typedef struct CHIP8_LOCKSTEP_STRUCT
+{
+    struct CHIP8_LOCKSTEP_GROUP_STRUCT *groups;
+    uint32_t    lanes;
+    uint32_t    groupCount;     /// lanes / CHIP8_LOCKSTEP_WIDTH rounded up
+    uint32_t    ips;            /// Instructions per second of every lane
+    uint32_t    ipsRemainder;   /// Instructions carried over between ticks (in 1/60 units)
+    uint64_t    ticks;          /// Total executed 60 Hz ticks
+    uint64_t    steps;          /// Instructions issued for a lane subset
+    uint64_t    laneCycles;     /// Instructions retired over all lanes, laneCycles / steps is the average occupancy
+
+} chip8_lockstep_t;
+
+/////////////////////////////////////////////////
+/// Public Prototype Functions
+/////////////////////////////////////////////////
+
+/// Every lane starts like CHIP8_InitWithConfig, lane n is seeded with config->seed + n
+chip8_error_t CHIP8_LockstepCreate(chip8_lockstep_t **plockstep, uint32_t lanes, const chip8_config_t *config, uint8_t *program_buff, uint32_t size);
+void CHIP8_LockstepDestroy(chip8_lockstep_t *lockstep);
+
+void CHIP8_LockstepSetSeed(chip8_lockstep_t *lockstep, uint32_t lane, uint64_t seed);
+
+/// Sets the pressed keys of one lane (bit n is key n), read by EX9E/EXA1 from the next instruction on.
+/// A lane parked in FX0A resumes when a key pressed during the wait is released, like CHIP8_SetKeyId;
+/// when one call releases several such keys the lowest one is stored.
+chip8_error_t CHIP8_LockstepSetKeys(chip8_lockstep_t *lockstep, uint32_t lane, uint16_t keys);
+uint16_t CHIP8_LockstepGetKeys(chip8_lockstep_t *lockstep, uint32_t lane);
+
+/// CHIP8_IPS_UNBOUNDED is not supported, lanes run a fixed budget per tick
+chip8_error_t CHIP8_LockstepSetSpeed(chip8_lockstep_t *lockstep, uint32_t ips);
+
+/// Runs one 60 Hz tick (ips/60 instructions and a timer tick) on every lane, a faulted lane is no longer stepped.
+/// FX0A parks a lane (status CHIP8_ERROR_WAITING_FOR_KEY) until CHIP8_LockstepSetKeys wakes it, only its timers run meanwhile.
+chip8_error_t CHIP8_LockstepRunFrame(chip8_lockstep_t *lockstep);
+
+chip8_error_t CHIP8_LockstepGetStatus(chip8_lockstep_t *lockstep, uint32_t lane);
+uint64_t CHIP8_LockstepScreenHash(chip8_lockstep_t *lockstep, uint32_t lane);
+
+/// Copies one lane into a standalone VM that can continue on any engine, the whole screen is reported dirty
+chip8_error_t CHIP8_LockstepExtract(chip8_lockstep_t *lockstep, uint32_t lane, chip8_t *chip, chip8_keymap_t *keymap);
+
+/////////////////////////////////////////////////
+/// Internal Prototype Functions
+/////////////////////////////////////////////////
+
+/// Implemented by the core, the CXNN generator state CHIP8_SetSeed derives from seed
+uint64_t chip_seed_state(uint64_t seed);
+
+#endif //CHIP8_CHIP8_LOCKSTEP_H
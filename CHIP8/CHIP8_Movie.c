@@ -0,0 +1,358 @@
+/////////////////////////////////////////////////
+/// Includes
+/////////////////////////////////////////////////
+
+#include "CHIP8_Movie.h"
+#include <stdlib.h>
+#include <string.h>
+
+/////////////////////////////////////////////////
+/// Prototype static functions
+/////////////////////////////////////////////////
+
+static void movie_write_record(chip8_movie_t *movie, const chip8_movie_record_t *record);
+static void movie_put(uint8_t *data, uint64_t value, uint32_t bytes);
+static uint64_t movie_get(const uint8_t *data, uint32_t bytes);
+static chip8_error_t movie_desync(chip8_movie_result_t *result, uint64_t tick, uint64_t expected, uint64_t actual);
+
+/////////////////////////////////////////////////
+/// Public functions
+/////////////////////////////////////////////////
+
+chip8_error_t CHIP8_MovieRecordStart(chip8_t *chip, const char *path, const uint8_t *program_buff, uint32_t size)
+{
+    uint8_t header[CHIP8_MOVIE_HEADER_SIZE];
+    chip8_movie_t *movie = NULL;
+
+    if( chip == NULL || path == NULL || chip->movie != NULL || size > CHIP8_MEMORY_SIZE - CHIP8_PROGRAM_START_ADDR )
+    {
+        return CHIP8_ERROR_INIT;
+    }
+
+    /// The replay starts from a fresh VM, a session already under way cannot be reproduced
+    if( chip->scheduler.cycles != 0 || chip->scheduler.ticks != 0
+        || (size > 0 && memcmp(&chip->memory[CHIP8_PROGRAM_START_ADDR], program_buff, size) != 0) )
+    {
+        return CHIP8_ERROR_INVALID_STATE;
+    }
+
+    if( chip->scheduler.ips == CHIP8_IPS_UNBOUNDED )
+    {
+        return CHIP8_ERROR_NOT_SUPPORTED;
+    }
+
+    movie = (chip8_movie_t *)calloc(1, sizeof(chip8_movie_t));
+    if( movie == NULL )
+    {
+        return CHIP8_ERROR_INIT;
+    }
+
+    movie->file = fopen(path, "wb");
+    if( movie->file == NULL )
+    {
+        free(movie);
+        return CHIP8_ERROR_INIT;
+    }
+
+    movie->checkpointTicks = CHIP8_MOVIE_CHECKPOINT_TICKS;
+
+    movie_put(&header[0], CHIP8_MOVIE_MAGIC, 4);
+    movie_put(&header[4], CHIP8_MOVIE_VERSION, 2);
+    movie_put(&header[6], 0, 2);
+    movie_put(&header[8], chip->rng, 8);
+    movie_put(&header[16], chip->scheduler.ips, 4);
+    movie_put(&header[20], movie->checkpointTicks, 4);
+    movie_put(&header[24], size, 4);
+
+    /// Custom fonts live here, the replay restores the area instead of trusting a configuration
+    fwrite(header, sizeof(header), 1, movie->file);
+    fwrite(chip->memory, CHIP8_MOVIE_INTERPRETER_SIZE, 1, movie->file);
+    if( size > 0 )
+    {
+        fwrite(program_buff, size, 1, movie->file);
+    }
+
+    chip->movie = movie;
+    return CHIP8_ERROR_NO;
+}
+
+chip8_error_t CHIP8_MovieRecordStop(chip8_t *chip)
+{
+    chip8_movie_t *movie = chip->movie;
+    if( movie == NULL )
+    {
+        return CHIP8_ERROR_INIT;
+    }
+
+    chip_movie_event(chip, CHIP8_MOVIE_RECORD_END, CHIP8_ScreenHash(chip));
+    chip->movie = NULL;
+
+    bool failed = (ferror(movie->file) != 0);
+    failed |= (fclose(movie->file) != 0);
+    free(movie);
+
+    return failed ? CHIP8_ERROR_INIT : CHIP8_ERROR_NO;
+}
+
+chip8_error_t CHIP8_MovieLoad(chip8_movie_playback_t *movie, const char *path)
+{
+    uint8_t header[CHIP8_MOVIE_HEADER_SIZE];
+    uint8_t data[CHIP8_MOVIE_RECORD_SIZE];
+    chip8_error_t err = CHIP8_ERROR_NO;
+
+    if( movie == NULL || path == NULL )
+    {
+        return CHIP8_ERROR_INIT;
+    }
+
+    memset(movie, 0, sizeof(chip8_movie_playback_t));
+
+    FILE *f = fopen(path, "rb");
+    if( f == NULL )
+    {
+        return CHIP8_ERROR_INIT;
+    }
+
+    if( fread(header, sizeof(header), 1, f) != 1 || movie_get(&header[0], 4) != CHIP8_MOVIE_MAGIC
+        || movie_get(&header[4], 2) != CHIP8_MOVIE_VERSION )
+    {
+        fclose(f);
+        return CHIP8_ERROR_INVALID_STATE;
+    }
+
+    movie->rng = movie_get(&header[8], 8);
+    movie->ips = (uint32_t)movie_get(&header[16], 4);
+    movie->checkpointTicks = (uint32_t)movie_get(&header[20], 4);
+    movie->romSize = (uint32_t)movie_get(&header[24], 4);
+
+    if( movie->rng == 0 || movie->ips == CHIP8_IPS_UNBOUNDED || movie->romSize > CHIP8_MEMORY_SIZE - CHIP8_PROGRAM_START_ADDR
+        || fread(movie->interpreter, sizeof(movie->interpreter), 1, f) != 1 )
+    {
+        fclose(f);
+        return CHIP8_ERROR_INVALID_STATE;
+    }
+
+    /// The records fill the rest of the file
+    long start = (long)sizeof(header) + CHIP8_MOVIE_INTERPRETER_SIZE + (long)movie->romSize;
+    fseek(f, 0, SEEK_END);
+    long end = ftell(f);
+    fseek(f, start - (long)movie->romSize, SEEK_SET);
+
+    if( end < start || (end - start) % CHIP8_MOVIE_RECORD_SIZE != 0 )
+    {
+        fclose(f);
+        return CHIP8_ERROR_INVALID_STATE;
+    }
+
+    movie->recordCount = (uint32_t)((end - start) / CHIP8_MOVIE_RECORD_SIZE);
+    movie->rom = (uint8_t *)malloc(movie->romSize + 1);
+    movie->records = (chip8_movie_record_t *)malloc(((size_t)movie->recordCount + 1) * sizeof(chip8_movie_record_t));
+
+    if( movie->rom == NULL || movie->records == NULL
+        || (movie->romSize > 0 && fread(movie->rom, movie->romSize, 1, f) != 1) )
+    {
+        err = CHIP8_ERROR_INIT;
+    }
+
+    for(uint32_t itr = 0; itr < movie->recordCount && err == CHIP8_ERROR_NO; itr++)
+    {
+        chip8_movie_record_t *record = &movie->records[itr];
+
+        if( fread(data, sizeof(data), 1, f) != 1 )
+        {
+            err = CHIP8_ERROR_INIT;
+            break;
+        }
+
+        record->type = data[0];
+        record->tick = movie_get(&data[1], 8);
+        record->cycle = movie_get(&data[9], 8);
+        record->value = movie_get(&data[17], 8);
+
+        if( record->type < CHIP8_MOVIE_RECORD_KEY || record->type > CHIP8_MOVIE_RECORD_END
+            || (itr > 0 && record->tick < movie->records[itr - 1].tick)
+            || (record->type == CHIP8_MOVIE_RECORD_KEY && (record->value & ~(uint64_t)(CHIP8_MOVIE_KEY_PRESSED | 0xF)) != 0)
+            || (record->type == CHIP8_MOVIE_RECORD_SPEED && (record->value == CHIP8_IPS_UNBOUNDED || record->value > UINT32_MAX)) )
+        {
+            err = CHIP8_ERROR_INVALID_STATE;
+        }
+    }
+
+    fclose(f);
+
+    if( err != CHIP8_ERROR_NO )
+    {
+        CHIP8_MovieUnload(movie);
+    }
+
+    return err;
+}
+
+void CHIP8_MovieUnload(chip8_movie_playback_t *movie)
+{
+    if( movie == NULL )
+    {
+        return;
+    }
+
+    free(movie->rom);
+    free(movie->records);
+    memset(movie, 0, sizeof(chip8_movie_playback_t));
+}
+
+chip8_error_t CHIP8_MovieReplay(const chip8_movie_playback_t *movie, chip8_t *chip, chip8_engine_t engine, chip8_movie_result_t *result)
+{
+    chip8_error_t err;
+
+    memset(result, 0, sizeof(chip8_movie_result_t));
+
+    err = CHIP8_InitWithConfig(chip, NULL, NULL, movie->rom, movie->romSize);
+    if( err != CHIP8_ERROR_NO )
+    {
+        return err;
+    }
+
+    /// The recorded VM, not a configuration, is the reference: its fonts and generator state come back as they were
+    memcpy(chip->memory, movie->interpreter, sizeof(movie->interpreter));
+    chip->rng = movie->rng;
+
+    /// The recording engine is not stored, replaying on another engine is a valid cross-check
+    if( engine != CHIP8_ENGINE_TOTAL )
+    {
+        err = CHIP8_SetEngine(chip, engine);
+        if( err != CHIP8_ERROR_NO )
+        {
+            return err;
+        }
+    }
+    CHIP8_SetSpeed(chip, movie->ips);
+
+    for(uint32_t itr = 0; itr < movie->recordCount; itr++)
+    {
+        const chip8_movie_record_t *record = &movie->records[itr];
+
+        /// Run the ticks leading up to the record, faults are part of the recording and replay the same way
+        while( chip->scheduler.ticks < record->tick )
+        {
+            CHIP8_RunFrame(chip);
+        }
+
+        /// A host that runs instructions without ticks recorded the event part way into the tick
+        while( chip->scheduler.cycles < record->cycle )
+        {
+            uint64_t pending = record->cycle - chip->scheduler.cycles;
+            uint32_t events = CHIP8_EVENT_NONE;
+
+            if( CHIP8_RunUntil(chip, (pending > UINT32_MAX) ? UINT32_MAX : (uint32_t)pending, CHIP8_EVENT_FAULT, &events) == 0 )
+            {
+                break;
+            }
+        }
+
+        result->ticks = chip->scheduler.ticks;
+        result->cycles = chip->scheduler.cycles;
+
+        if( chip->scheduler.cycles != record->cycle )
+        {
+            return movie_desync(result, record->tick, record->cycle, chip->scheduler.cycles);
+        }
+
+        switch( record->type )
+        {
+            case CHIP8_MOVIE_RECORD_KEY:
+                CHIP8_SetKeyId(chip, (chip8_key_id_t)(record->value & 0xF), (record->value & CHIP8_MOVIE_KEY_PRESSED) != 0);
+                result->keyEvents++;
+                break;
+
+            case CHIP8_MOVIE_RECORD_SPEED:
+                CHIP8_SetSpeed(chip, (uint32_t)record->value);
+                break;
+
+            case CHIP8_MOVIE_RECORD_CHECKPOINT:
+            case CHIP8_MOVIE_RECORD_END:
+            {
+                uint64_t hash = CHIP8_ScreenHash(chip);
+                if( hash != record->value )
+                {
+                    return movie_desync(result, record->tick, record->value, hash);
+                }
+                result->checkpoints++;
+                break;
+            }
+
+            default:
+                return CHIP8_ERROR_INVALID_STATE;
+        }
+
+        if( record->type == CHIP8_MOVIE_RECORD_END )
+        {
+            break;
+        }
+    }
+
+    return CHIP8_ERROR_NO;
+}
+
+/////////////////////////////////////////////////
+/// Internal functions
+/////////////////////////////////////////////////
+
+void chip_movie_event(chip8_t *chip, chip8_movie_record_type_t type, uint64_t value)
+{
+    chip8_movie_record_t record = { chip->scheduler.ticks, chip->scheduler.cycles, value, (uint8_t)type };
+    movie_write_record(chip->movie, &record);
+}
+
+void chip_movie_tick(chip8_t *chip)
+{
+    if( chip->scheduler.ticks % chip->movie->checkpointTicks == 0 )
+    {
+        chip_movie_event(chip, CHIP8_MOVIE_RECORD_CHECKPOINT, CHIP8_ScreenHash(chip));
+    }
+}
+
+/////////////////////////////////////////////////
+/// Static functions
+/////////////////////////////////////////////////
+
+static void movie_write_record(chip8_movie_t *movie, const chip8_movie_record_t *record)
+{
+    uint8_t data[CHIP8_MOVIE_RECORD_SIZE];
+
+    data[0] = record->type;
+    movie_put(&data[1], record->tick, 8);
+    movie_put(&data[9], record->cycle, 8);
+    movie_put(&data[17], record->value, 8);
+
+    fwrite(data, sizeof(data), 1, movie->file);
+    movie->records++;
+}
+
+static void movie_put(uint8_t *data, uint64_t value, uint32_t bytes)
+{
+    for(uint32_t itr = 0; itr < bytes; itr++)
+    {
+        data[itr] = (uint8_t)(value >> (8 * itr));
+    }
+}
+
+static uint64_t movie_get(const uint8_t *data, uint32_t bytes)
+{
+    uint64_t value = 0;
+
+    for(uint32_t itr = 0; itr < bytes; itr++)
+    {
+        value |= (uint64_t)data[itr] << (8 * itr);
+    }
+
+    return value;
+}
+
+static chip8_error_t movie_desync(chip8_movie_result_t *result, uint64_t tick, uint64_t expected, uint64_t actual)
+{
+    result->desyncTick = tick;
+    result->expected = expected;
+    result->actual = actual;
+
+    return CHIP8_ERROR_DESYNC;
+}
@@ -0,0 +1,120 @@
+#ifndef CHIP8_CHIP8_MOVIE_H
+#define CHIP8_CHIP8_MOVIE_H
+
+/////////////////////////////////////////////////
+/// Includes
+/////////////////////////////////////////////////
+
+#include "CHIP8.h"
+#include <stdio.h>
+
+/////////////////////////////////////////////////
+/// Defines
+/////////////////////////////////////////////////
+
+#define CHIP8_MOVIE_MAGIC               0x564D3843  /// "C8MV"
+#define CHIP8_MOVIE_VERSION             2
+#define CHIP8_MOVIE_HEADER_SIZE         28          /// Bytes before the interpreter area
+#define CHIP8_MOVIE_INTERPRETER_SIZE    CHIP8_PROGRAM_START_ADDR    /// Memory below the program, fonts included
+#define CHIP8_MOVIE_RECORD_SIZE         25          /// Serialized size of one record
+#define CHIP8_MOVIE_CHECKPOINT_TICKS    60          /// A screen hash checkpoint every emulated second
+#define CHIP8_MOVIE_KEY_PRESSED         0x100       /// Set in the value of a key record when the key went down
+
+/// Movie file, every integer little endian:
+///     u32 magic, u16 version, u16 flags (0), u64 CXNN generator state, u32 ips, u32 checkpoint interval in ticks,
+///     u32 ROM size
+///     interpreter area (memory below CHIP8_PROGRAM_START_ADDR), ROM image
+///     records of u8 type, u64 tick, u64 cycle, u64 value, ordered by tick
+/// A record applies once the VM has run tick ticks and cycle instructions. Hosts driving the VM with
+/// CHIP8_RunUntil record between instructions of a tick, replay runs the instructions up to the record then.
+
+/////////////////////////////////////////////////
+/// Typedef enumerations
+/////////////////////////////////////////////////
+
+typedef enum CHIP8_MOVIE_RECORD_TYPE
+{
+    CHIP8_MOVIE_RECORD_KEY = 1,     /// value is the key id, with CHIP8_MOVIE_KEY_PRESSED when it went down
+    CHIP8_MOVIE_RECORD_SPEED,       /// value is the new instructions per second
+    CHIP8_MOVIE_RECORD_CHECKPOINT,  /// value is CHIP8_ScreenHash
+    CHIP8_MOVIE_RECORD_END,         /// value is CHIP8_ScreenHash at the end of the session
+
+} chip8_movie_record_type_t;
+
+/////////////////////////////////////////////////
+/// Typedef structures
+/////////////////////////////////////////////////
+
+typedef struct CHIP8_MOVIE_RECORD_STRUCT
+{
+    uint64_t    tick;
+    uint64_t    cycle;
+    uint64_t    value;
+    uint8_t     type;
+
+} chip8_movie_record_t;
+
+/// Active recording, attached to the VM like a trace session
+typedef struct CHIP8_MOVIE_STRUCT
+{
+    FILE        *file;
+    uint32_t    checkpointTicks;
+    uint64_t    records;
+
+} chip8_movie_t;
+
+/// A movie loaded for replay
+typedef struct CHIP8_MOVIE_PLAYBACK_STRUCT
+{
+    uint64_t                rng;
+    uint32_t                ips;
+    uint32_t                checkpointTicks;
+    uint8_t                 interpreter[CHIP8_MOVIE_INTERPRETER_SIZE];
+    uint8_t                 *rom;
+    uint32_t                romSize;
+    chip8_movie_record_t    *records;
+    uint32_t                recordCount;
+
+} chip8_movie_playback_t;
+
+typedef struct CHIP8_MOVIE_RESULT_STRUCT
+{
+    uint64_t    ticks;          /// Ticks replayed
+    uint64_t    cycles;         /// Instructions replayed
+    uint32_t    keyEvents;      /// Key transitions applied
+    uint32_t    checkpoints;    /// Checkpoints that matched
+    uint64_t    desyncTick;     /// Tick of the first mismatch, only valid with CHIP8_ERROR_DESYNC
+    uint64_t    expected;       /// Recorded hash or cycle count of the mismatch
+    uint64_t    actual;         /// Replayed hash or cycle count of the mismatch
+
+} chip8_movie_result_t;
+
+/////////////////////////////////////////////////
+/// Public Prototype Functions
+/////////////////////////////////////////////////
+
+/// Starts recording a VM straight after CHIP8_InitWithConfig, program must be the one it was initialized with.
+/// The fonts and the random generator state are taken from the VM itself. Key transitions (CHIP8_SetKey/CHIP8_SetKeyId) and speed changes are recorded until
+/// CHIP8_MovieRecordStop, the VM must not be reset, rewound or loaded from a snapshot meanwhile.
+/// An unbounded speed depends on host time and is rejected with CHIP8_ERROR_NOT_SUPPORTED, here and by
+/// CHIP8_SetSpeed during the recording.
+chip8_error_t CHIP8_MovieRecordStart(chip8_t *chip, const char *path, const uint8_t *program_buff, uint32_t size);
+chip8_error_t CHIP8_MovieRecordStop(chip8_t *chip);
+
+chip8_error_t CHIP8_MovieLoad(chip8_movie_playback_t *movie, const char *path);
+void CHIP8_MovieUnload(chip8_movie_playback_t *movie);
+
+/// Initializes chip from the movie and runs the whole session back to back without throttling, CHIP8_ENGINE_TOTAL
+/// keeps the default engine. Returns CHIP8_ERROR_DESYNC at the first cycle count or screen hash that differs
+/// from the recording. chip is left initialized at the point the replay stopped.
+chip8_error_t CHIP8_MovieReplay(const chip8_movie_playback_t *movie, chip8_t *chip, chip8_engine_t engine, chip8_movie_result_t *result);
+
+/////////////////////////////////////////////////
+/// Internal Prototype Functions
+/////////////////////////////////////////////////
+
+/// Called by the core while chip->movie is set
+void chip_movie_event(chip8_t *chip, chip8_movie_record_type_t type, uint64_t value);
+void chip_movie_tick(chip8_t *chip);
+
+#endif //CHIP8_CHIP8_MOVIE_H
@@ -0,0 +1,262 @@
+/////////////////////////////////////////////////
+/// Includes
+/////////////////////////////////////////////////
+
+#include "CHIP8_Profile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/////////////////////////////////////////////////
+/// Defines
+/////////////////////////////////////////////////
+
+#define CHIP8_PROFILE_ADDR_MASK         (CHIP8_MEMORY_SIZE - 1)
+#define CHIP8_PROFILE_STACKS_LIMIT      (CHIP8_PROFILE_STACKS - CHIP8_PROFILE_STACKS / 4)   /// Keeps the probe sequences short
+#define CHIP8_PROFILE_FNV_OFFSET_BASIS  0x811C9DC5u
+#define CHIP8_PROFILE_FNV_PRIME         0x01000193u
+
+/////////////////////////////////////////////////
+/// Prototype static functions
+/////////////////////////////////////////////////
+
+static void profile_arm(chip8_profile_t *profile);
+static uint16_t profile_callee(const chip8_t *chip, uint16_t return_addr);
+static void profile_add_stack(chip8_profile_t *profile, const uint16_t *frames, uint32_t depth);
+static void profile_write_frame(FILE *f, uint16_t addr, uint32_t depth);
+
+/////////////////////////////////////////////////
+/// Public functions
+/////////////////////////////////////////////////
+
+chip8_error_t CHIP8_ProfileStart(chip8_t *chip, uint32_t period)
+{
+    if( chip == NULL || chip->profile != NULL || period == 0 )
+    {
+        return CHIP8_ERROR_INIT;
+    }
+
+    chip8_profile_t *profile = (chip8_profile_t *)calloc(1, sizeof(chip8_profile_t));
+    if( profile == NULL )
+    {
+        return CHIP8_ERROR_INIT;
+    }
+
+    /// countdown starts at 0, the first instruction is sampled so the exact mode misses none
+    profile->period = period;
+    chip->profile = profile;
+
+    return CHIP8_ERROR_NO;
+}
+
+chip8_error_t CHIP8_ProfileStop(chip8_t *chip)
+{
+    if( chip->profile == NULL )
+    {
+        return CHIP8_ERROR_INIT;
+    }
+
+    free(chip->profile);
+    chip->profile = NULL;
+
+    return CHIP8_ERROR_NO;
+}
+
+chip8_error_t CHIP8_GetProfile(chip8_t *chip, chip8_profile_t *profile)
+{
+    if( chip->profile == NULL || profile == NULL )
+    {
+        return CHIP8_ERROR_INIT;
+    }
+
+    memcpy(profile, chip->profile, sizeof(chip8_profile_t));
+
+    return CHIP8_ERROR_NO;
+}
+
+chip8_error_t CHIP8_ProfileWriteFolded(const chip8_profile_t *profile, const char *path)
+{
+    if( profile == NULL || path == NULL )
+    {
+        return CHIP8_ERROR_INIT;
+    }
+
+    FILE *f = fopen(path, "w");
+    if( f == NULL )
+    {
+        return CHIP8_ERROR_INIT;
+    }
+
+    for(uint32_t itr = 0; itr < CHIP8_PROFILE_STACKS; itr++)
+    {
+        const chip8_profile_stack_t *stack = &profile->stacks[itr];
+        if( stack->depth == 0 )
+        {
+            continue;
+        }
+
+        for(uint32_t frame = 0; frame < stack->depth; frame++)
+        {
+            profile_write_frame(f, stack->frames[frame], frame);
+        }
+        fprintf(f, " %llu\n", (unsigned long long)stack->samples);
+    }
+
+    bool failed = (ferror(f) != 0);
+    failed |= (fclose(f) != 0);
+
+    return failed ? CHIP8_ERROR_INIT : CHIP8_ERROR_NO;
+}
+
+chip8_error_t CHIP8_ProfileWriteCsv(const chip8_profile_t *profile, const chip8_t *chip, const char *path)
+{
+    if( profile == NULL || path == NULL )
+    {
+        return CHIP8_ERROR_INIT;
+    }
+
+    FILE *f = fopen(path, "w");
+    if( f == NULL )
+    {
+        return CHIP8_ERROR_INIT;
+    }
+
+    fprintf(f, "kind,address,opcode,samples,inclusive,exclusive\n");
+
+    for(uint32_t addr = 0; addr < CHIP8_MEMORY_SIZE; addr++)
+    {
+        if( profile->pc[addr] == 0 )
+        {
+            continue;
+        }
+
+        fprintf(f, "pc,%03X,", addr);
+        if( chip != NULL )
+        {
+            fprintf(f, "%02X%02X", chip->memory[addr], chip->memory[(addr + 1) & CHIP8_PROFILE_ADDR_MASK]);
+        }
+        fprintf(f, ",%llu,,\n", (unsigned long long)profile->pc[addr]);
+    }
+
+    for(uint32_t addr = 0; addr < CHIP8_MEMORY_SIZE; addr++)
+    {
+        const chip8_profile_function_t *function = &profile->functions[addr];
+        if( function->inclusive != 0 )
+        {
+            fprintf(f, "function,%03X,,,%llu,%llu\n", addr, (unsigned long long)function->inclusive,
+                    (unsigned long long)function->exclusive);
+        }
+    }
+
+    bool failed = (ferror(f) != 0);
+    failed |= (fclose(f) != 0);
+
+    return failed ? CHIP8_ERROR_INIT : CHIP8_ERROR_NO;
+}
+
+/////////////////////////////////////////////////
+/// Internal functions
+/////////////////////////////////////////////////
+
+void chip_profile_sample(chip8_t *chip)
+{
+    chip8_profile_t *profile = chip->profile;
+    uint16_t frames[CHIP8_PROFILE_MAX_FRAMES];
+    uint32_t depth = 0;
+
+    frames[depth++] = CHIP8_PROGRAM_START_ADDR;
+    for(uint32_t itr = 0; itr < chip->registers.SP && itr < CHIP8_STACK_DEPTH_TOTAL; itr++)
+    {
+        frames[depth++] = profile_callee(chip, chip->stack[itr]);
+    }
+
+    profile->samples++;
+    profile->pc[chip->registers.PC & CHIP8_PROFILE_ADDR_MASK]++;
+    profile->functions[frames[depth - 1]].exclusive++;
+
+    for(uint32_t itr = 0; itr < depth; itr++)
+    {
+        /// A recursive subroutine is counted once per sample
+        bool outer = false;
+        for(uint32_t prev = 0; prev < itr && outer == false; prev++)
+        {
+            outer = (frames[prev] == frames[itr]);
+        }
+
+        if( outer == false )
+        {
+            profile->functions[frames[itr]].inclusive++;
+        }
+    }
+
+    profile_add_stack(profile, frames, depth);
+    profile_arm(profile);
+}
+
+/////////////////////////////////////////////////
+/// Static functions
+/////////////////////////////////////////////////
+
+static void profile_arm(chip8_profile_t *profile)
+{
+    /// Uniform in [period - period / 2, period + period / 2), the mean stays period
+    profile->jitter += CHIP8_SAMPLE_STEP;
+    uint32_t offset = (uint32_t)(((uint64_t)profile->jitter * profile->period) >> 32);
+
+    profile->countdown = profile->period - profile->period / 2 + offset;
+}
+
+static uint16_t profile_callee(const chip8_t *chip, uint16_t return_addr)
+{
+    uint16_t site = (uint16_t)((return_addr - 2) & CHIP8_PROFILE_ADDR_MASK);
+    uint16_t opcode = (uint16_t)((chip->memory[site] << 8) | chip->memory[(site + 1) & CHIP8_PROFILE_ADDR_MASK]);
+
+    return ((opcode & 0xF000) == 0x2000) ? (uint16_t)(opcode & 0x0FFF) : site;
+}
+
+static void profile_add_stack(chip8_profile_t *profile, const uint16_t *frames, uint32_t depth)
+{
+    uint32_t hash = CHIP8_PROFILE_FNV_OFFSET_BASIS;
+    for(uint32_t itr = 0; itr < depth; itr++)
+    {
+        hash = (hash ^ frames[itr]) * CHIP8_PROFILE_FNV_PRIME;
+    }
+
+    for(uint32_t slot = hash & (CHIP8_PROFILE_STACKS - 1);; slot = (slot + 1) & (CHIP8_PROFILE_STACKS - 1))
+    {
+        chip8_profile_stack_t *stack = &profile->stacks[slot];
+
+        if( stack->depth == 0 )
+        {
+            if( profile->stackCount >= CHIP8_PROFILE_STACKS_LIMIT )
+            {
+                profile->droppedStacks++;
+                return;
+            }
+
+            memcpy(stack->frames, frames, depth * sizeof(uint16_t));
+            stack->depth = (uint8_t)depth;
+            stack->samples = 1;
+            profile->stackCount++;
+            return;
+        }
+
+        if( stack->depth == depth && memcmp(stack->frames, frames, depth * sizeof(uint16_t)) == 0 )
+        {
+            stack->samples++;
+            return;
+        }
+    }
+}
+
+static void profile_write_frame(FILE *f, uint16_t addr, uint32_t depth)
+{
+    if( depth == 0 )
+    {
+        fprintf(f, "main");
+    }
+    else
+    {
+        fprintf(f, ";sub_%03X", addr);
+    }
+}
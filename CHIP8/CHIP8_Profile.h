@@ -0,0 +1,82 @@
+#ifndef CHIP8_CHIP8_PROFILE_H
+#define CHIP8_CHIP8_PROFILE_H
+
+/////////////////////////////////////////////////
+/// Includes
+/////////////////////////////////////////////////
+
+#include "CHIP8.h"
+
+/////////////////////////////////////////////////
+/// Defines
+/////////////////////////////////////////////////
+
+#define CHIP8_PROFILE_DEFAULT_PERIOD    1000    /// Mean cycles between two samples
+#define CHIP8_PROFILE_EXACT             1       /// Period that records every executed instruction
+#define CHIP8_PROFILE_MAX_FRAMES        (CHIP8_STACK_DEPTH_TOTAL + 1)   /// The entry point plus one frame per stack slot
+#define CHIP8_PROFILE_STACKS            4096    /// Distinct call stacks kept, must be a power of two
+
+/////////////////////////////////////////////////
+/// Typedef structures
+/////////////////////////////////////////////////
+
+/// Samples attributed to the subroutine starting at an address, the entry point is CHIP8_PROGRAM_START_ADDR
+typedef struct CHIP8_PROFILE_FUNCTION_STRUCT
+{
+    uint64_t    inclusive;  /// Samples taken in the subroutine or anything it called, recursion counts once
+    uint64_t    exclusive;  /// Samples taken in the subroutine itself
+
+} chip8_profile_function_t;
+
+typedef struct CHIP8_PROFILE_STACK_STRUCT
+{
+    uint64_t    samples;
+    uint16_t    frames[CHIP8_PROFILE_MAX_FRAMES];   /// Subroutine addresses, outermost first
+    uint8_t     depth;                              /// Used frames, 0 marks a free slot
+
+} chip8_profile_stack_t;
+
+/// Samples of a profiling session
+typedef struct CHIP8_PROFILE_STRUCT
+{
+    uint64_t                    samples;
+    uint64_t                    droppedStacks;                  /// Samples whose call stack did not fit in the stack table
+    uint64_t                    pc[CHIP8_MEMORY_SIZE];          /// Samples per instruction address
+    chip8_profile_function_t    functions[CHIP8_MEMORY_SIZE];   /// Indexed by subroutine address
+    chip8_profile_stack_t       stacks[CHIP8_PROFILE_STACKS];   /// Open addressing table of the sampled call stacks
+    uint32_t                    stackCount;
+    uint32_t                    period;
+    uint32_t                    countdown;                      /// Cycles left until the next sample
+    uint32_t                    jitter;                         /// Advanced by CHIP8_SAMPLE_STEP per sample
+
+} chip8_profile_t;
+
+/////////////////////////////////////////////////
+/// Public Prototype Functions
+/////////////////////////////////////////////////
+
+/// Samples PC and the call stack every period cycles on average, CHIP8_PROFILE_EXACT records every instruction.
+/// Samples are taken between slices of CHIP8_RunUntil and the loops built on it, so every engine can be profiled.
+/// Call stacks are rebuilt from the return addresses on the stack, a frame is the target of the 2NNN
+/// that pushed it (or the call site when the ROM has overwritten that instruction since).
+chip8_error_t CHIP8_ProfileStart(chip8_t *chip, uint32_t period);
+chip8_error_t CHIP8_ProfileStop(chip8_t *chip);
+
+/// Copies the samples of the running session into profile
+chip8_error_t CHIP8_GetProfile(chip8_t *chip, chip8_profile_t *profile);
+
+/// One "main;sub_2A4;sub_310 samples" line per call stack, the folded format read by flame graph tools
+chip8_error_t CHIP8_ProfileWriteFolded(const chip8_profile_t *profile, const char *path);
+
+/// One row per sampled address and one per sampled subroutine: kind,address,opcode,samples,inclusive,exclusive.
+/// Opcodes are read from the memory of chip, which may be NULL to leave them out.
+chip8_error_t CHIP8_ProfileWriteCsv(const chip8_profile_t *profile, const chip8_t *chip, const char *path);
+
+/////////////////////////////////////////////////
+/// Internal Prototype Functions
+/////////////////////////////////////////////////
+
+/// Used by the run loop when countdown reaches 0, records one sample and rearms countdown
+void chip_profile_sample(chip8_t *chip);
+
+#endif //CHIP8_CHIP8_PROFILE_H
@@ -0,0 +1,187 @@
+/////////////////////////////////////////////////
+/// Includes
+/////////////////////////////////////////////////
+
+#include "CHIP8_Render.h"
+#include <string.h>
+
+#if CHIP8_RENDER_SSE2
+#include <emmintrin.h>
+#endif
+
+/////////////////////////////////////////////////
+/// Public functions
+/////////////////////////////////////////////////
+
+void CHIP8_Render1bpp(chip8_t *chip, uint8_t *bits)
+{
+    chip8_framebuffer_t fb;
+    CHIP8_GetFramebuffer(chip, &fb);
+
+    /// Rows are stored most significant bit first, so big endian bytes keep the pixel order
+    for(uint32_t y = 0; y < fb.height; y++)
+    {
+        for(uint32_t word = 0; word < fb.width / CHIP8_RENDER_WORD_PIXELS; word++)
+        {
+            const uint64_t row = chip->screen.rows[y][word];
+            uint8_t *out = &bits[(y * fb.width + word * CHIP8_RENDER_WORD_PIXELS) / 8];
+
+            /// Written out so the compiler merges it into a single byte swapped store
+            out[0] = (uint8_t)(row >> 56);
+            out[1] = (uint8_t)(row >> 48);
+            out[2] = (uint8_t)(row >> 40);
+            out[3] = (uint8_t)(row >> 32);
+            out[4] = (uint8_t)(row >> 24);
+            out[5] = (uint8_t)(row >> 16);
+            out[6] = (uint8_t)(row >> 8);
+            out[7] = (uint8_t)row;
+        }
+    }
+}
+
+#if CHIP8_RENDER_SSE2
+
+void CHIP8_Render8bpp(chip8_t *chip, uint8_t *pixels, uint8_t on_color, uint8_t off_color)
+{
+    const __m128i bits = _mm_set_epi8(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, (char)0x80,
+                                      0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, (char)0x80);
+    const __m128i off = _mm_set1_epi8((char)off_color);
+    const __m128i diff = _mm_set1_epi8((char)(on_color ^ off_color));
+
+    chip8_framebuffer_t fb;
+    CHIP8_GetFramebuffer(chip, &fb);
+
+    for(uint32_t y = 0; y < fb.height; y++)
+    {
+        for(uint32_t word = 0; word < fb.width / CHIP8_RENDER_WORD_PIXELS; word++)
+        {
+            const uint64_t row = chip->screen.rows[y][word];
+            uint8_t *out = &pixels[y * fb.width + word * CHIP8_RENDER_WORD_PIXELS];
+
+            /// Sixteen pixels per step, each source byte is broadcast over eight lanes and tested against its bit
+            for(uint32_t x = 0; x < CHIP8_RENDER_WORD_PIXELS; x += 16)
+            {
+                uint64_t left = (row >> (CHIP8_RENDER_WORD_PIXELS - 8 - x)) & 0xFF;
+                uint64_t right = (row >> (CHIP8_RENDER_WORD_PIXELS - 16 - x)) & 0xFF;
+                __m128i spread = _mm_set_epi64x((long long)(right * 0x0101010101010101ULL), (long long)(left * 0x0101010101010101ULL));
+                __m128i mask = _mm_cmpeq_epi8(_mm_and_si128(spread, bits), bits);
+
+                _mm_storeu_si128((__m128i *)&out[x], _mm_xor_si128(off, _mm_and_si128(diff, mask)));
+            }
+        }
+    }
+}
+
+void CHIP8_RenderRGBARows(chip8_t *chip, uint32_t *pixels, uint32_t on_color, uint32_t off_color, uint64_t rows)
+{
+    const __m128i high = _mm_set_epi32(0x10, 0x20, 0x40, 0x80);
+    const __m128i low = _mm_set_epi32(0x01, 0x02, 0x04, 0x08);
+    const __m128i off = _mm_set1_epi32((int)off_color);
+    const __m128i diff = _mm_set1_epi32((int)(on_color ^ off_color));
+
+    chip8_framebuffer_t fb;
+    CHIP8_GetFramebuffer(chip, &fb);
+
+    /// The cost does not depend on how many pixels are lit
+    for(uint32_t y = 0; y < fb.height; y++)
+    {
+        if( (rows & (1ULL << y)) == 0 )
+        {
+            continue;
+        }
+
+        for(uint32_t word = 0; word < fb.width / CHIP8_RENDER_WORD_PIXELS; word++)
+        {
+            const uint64_t row = chip->screen.rows[y][word];
+            uint32_t *out = &pixels[y * fb.width + word * CHIP8_RENDER_WORD_PIXELS];
+
+            /// Eight pixels per step, each source byte is broadcast and tested against one bit per lane
+            for(uint32_t x = 0; x < CHIP8_RENDER_WORD_PIXELS; x += 8)
+            {
+                __m128i spread = _mm_set1_epi32((int)((row >> (CHIP8_RENDER_WORD_PIXELS - 8 - x)) & 0xFF));
+                __m128i mask_high = _mm_cmpeq_epi32(_mm_and_si128(spread, high), high);
+                __m128i mask_low = _mm_cmpeq_epi32(_mm_and_si128(spread, low), low);
+
+                _mm_storeu_si128((__m128i *)&out[x], _mm_xor_si128(off, _mm_and_si128(diff, mask_high)));
+                _mm_storeu_si128((__m128i *)&out[x + 4], _mm_xor_si128(off, _mm_and_si128(diff, mask_low)));
+            }
+        }
+    }
+}
+
+#else
+
+void CHIP8_Render8bpp(chip8_t *chip, uint8_t *pixels, uint8_t on_color, uint8_t off_color)
+{
+    uint8_t lut[16][4];
+
+    /// Four output pixels for every nibble value, built once per frame for the requested colors
+    for(uint32_t nibble = 0; nibble < 16; nibble++)
+    {
+        for(uint32_t bit = 0; bit < 4; bit++)
+        {
+            lut[nibble][bit] = (nibble & (0x8 >> bit)) ? on_color : off_color;
+        }
+    }
+
+    chip8_framebuffer_t fb;
+    CHIP8_GetFramebuffer(chip, &fb);
+
+    for(uint32_t y = 0; y < fb.height; y++)
+    {
+        for(uint32_t word = 0; word < fb.width / CHIP8_RENDER_WORD_PIXELS; word++)
+        {
+            const uint64_t row = chip->screen.rows[y][word];
+            uint8_t *out = &pixels[y * fb.width + word * CHIP8_RENDER_WORD_PIXELS];
+
+            for(uint32_t x = 0; x < CHIP8_RENDER_WORD_PIXELS; x += 4)
+            {
+                memcpy(&out[x], lut[(row >> (CHIP8_RENDER_WORD_PIXELS - 4 - x)) & 0xF], sizeof(lut[0]));
+            }
+        }
+    }
+}
+
+void CHIP8_RenderRGBARows(chip8_t *chip, uint32_t *pixels, uint32_t on_color, uint32_t off_color, uint64_t rows)
+{
+    uint32_t lut[16][4];
+
+    /// Four output pixels for every nibble value, built once per frame for the requested colors
+    for(uint32_t nibble = 0; nibble < 16; nibble++)
+    {
+        for(uint32_t bit = 0; bit < 4; bit++)
+        {
+            lut[nibble][bit] = (nibble & (0x8 >> bit)) ? on_color : off_color;
+        }
+    }
+
+    chip8_framebuffer_t fb;
+    CHIP8_GetFramebuffer(chip, &fb);
+
+    /// The cost does not depend on how many pixels are lit
+    for(uint32_t y = 0; y < fb.height; y++)
+    {
+        if( (rows & (1ULL << y)) == 0 )
+        {
+            continue;
+        }
+
+        for(uint32_t word = 0; word < fb.width / CHIP8_RENDER_WORD_PIXELS; word++)
+        {
+            const uint64_t row = chip->screen.rows[y][word];
+            uint32_t *out = &pixels[y * fb.width + word * CHIP8_RENDER_WORD_PIXELS];
+
+            for(uint32_t x = 0; x < CHIP8_RENDER_WORD_PIXELS; x += 4)
+            {
+                memcpy(&out[x], lut[(row >> (CHIP8_RENDER_WORD_PIXELS - 4 - x)) & 0xF], sizeof(lut[0]));
+            }
+        }
+    }
+}
+
+#endif
+
+void CHIP8_RenderRGBA(chip8_t *chip, uint32_t *pixels, uint32_t on_color, uint32_t off_color)
+{
+    CHIP8_RenderRGBARows(chip, pixels, on_color, off_color, UINT64_MAX);
+}
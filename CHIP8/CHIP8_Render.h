@@ -0,0 +1,45 @@
+#ifndef CHIP8_CHIP8_RENDER_H
+#define CHIP8_CHIP8_RENDER_H
+
+/////////////////////////////////////////////////
+/// Includes
+/////////////////////////////////////////////////
+
+#include "CHIP8.h"
+
+/////////////////////////////////////////////////
+/// Defines
+/////////////////////////////////////////////////
+
+#define CHIP8_RENDER_PIXELS         (CHIP8_WIDTH_SCREEN * CHIP8_HEIGHT_SCREEN) /// Largest frame of the 8bpp and RGBA exports, in pixels
+#define CHIP8_RENDER_1BPP_STRIDE    (CHIP8_WIDTH_SCREEN / 8)                  /// Largest row of the 1bpp export, in bytes
+#define CHIP8_RENDER_1BPP_SIZE      (CHIP8_RENDER_1BPP_STRIDE * CHIP8_HEIGHT_SCREEN)
+#define CHIP8_RENDER_WORD_PIXELS    64                                        /// Pixels per packed row word
+
+#if defined(__SSE2__) && !defined(CHIP8_NO_SIMD)
+#define CHIP8_RENDER_SSE2           1
+#else
+#define CHIP8_RENDER_SSE2           0
+#endif
+
+/////////////////////////////////////////////////
+/// Public Prototype Functions
+/////////////////////////////////////////////////
+
+/// Every export writes the active resolution (see CHIP8_GetFramebuffer), rows are width pixels apart.
+/// Buffers sized for the 128x64 screen fit both resolutions.
+
+/// Packs the framebuffer into width / 8 bytes per row, most significant bit first (PBM P4 layout)
+void CHIP8_Render1bpp(chip8_t *chip, uint8_t *bits);
+
+/// Expands the framebuffer into width * height row-major bytes
+void CHIP8_Render8bpp(chip8_t *chip, uint8_t *pixels, uint8_t on_color, uint8_t off_color);
+
+/// Expands the framebuffer into width * height row-major 32-bit pixels.
+/// The colors are copied as they are, so any 32-bit layout (RGBA8, BGRA8, ...) can be produced.
+void CHIP8_RenderRGBA(chip8_t *chip, uint32_t *pixels, uint32_t on_color, uint32_t off_color);
+
+/// Same as CHIP8_RenderRGBA but only rewrites the rows set in rows (bit n is row n), see CHIP8_GetDirtyRegion
+void CHIP8_RenderRGBARows(chip8_t *chip, uint32_t *pixels, uint32_t on_color, uint32_t off_color, uint64_t rows);
+
+#endif //CHIP8_CHIP8_RENDER_H
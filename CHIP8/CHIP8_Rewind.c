@@ -0,0 +1,359 @@
+/////////////////////////////////////////////////
+/// Includes
+/////////////////////////////////////////////////
+
+#include "CHIP8_Rewind.h"
+#include "CHIP8_State.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+/////////////////////////////////////////////////
+/// Defines
+/////////////////////////////////////////////////
+
+#define CHIP8_REWIND_ENTRY_OVERHEAD     (2 * sizeof(uint16_t))  /// Leading and trailing size of an entry
+#define CHIP8_REWIND_TOKEN_HEADER       (2 * sizeof(uint16_t))  /// Skip and literal length of a token
+#define CHIP8_REWIND_LITERAL_GAP        4                       /// Unchanged bytes that end a literal
+
+_Static_assert(sizeof(chip8_rewind_frame_t) % sizeof(uint64_t) == 0, "rewind frame must not have tail padding");
+_Static_assert(sizeof(chip8_rewind_frame_t) <= UINT16_MAX, "token offsets are 16-bit");
+
+/////////////////////////////////////////////////
+/// Prototype static functions
+/////////////////////////////////////////////////
+
+static void rewind_capture(const chip8_t *chip, chip8_rewind_frame_t *frame);
+static void rewind_restore(const chip8_rewind_frame_t *frame, chip8_t *chip, bool memory_changed);
+static uint32_t rewind_encode(const uint8_t *cur, const uint8_t *prev, uint32_t size, uint8_t *dst);
+static bool rewind_apply(const uint8_t *src, uint32_t size, uint8_t *frame);
+static void rewind_ring_write(chip8_rewind_t *rewind, uint32_t pos, const uint8_t *src, uint32_t size);
+static void rewind_ring_read(const chip8_rewind_t *rewind, uint32_t pos, uint8_t *dst, uint32_t size);
+static uint16_t rewind_ring_get16(const chip8_rewind_t *rewind, uint32_t pos);
+static void rewind_drop_oldest(chip8_rewind_t *rewind);
+
+/////////////////////////////////////////////////
+/// Public functions
+/////////////////////////////////////////////////
+
+chip8_error_t CHIP8_RewindCreate(chip8_rewind_t **prewind, uint32_t capacity)
+{
+    chip8_rewind_t *rewind = NULL;
+
+    if( prewind == NULL || capacity == 0 )
+    {
+        return CHIP8_ERROR_INIT;
+    }
+
+    rewind = (chip8_rewind_t *)calloc(1, sizeof(chip8_rewind_t));
+    if( rewind == NULL )
+    {
+        return CHIP8_ERROR_INIT;
+    }
+
+    rewind->ring = (uint8_t *)malloc(capacity);
+    if( rewind->ring == NULL )
+    {
+        free(rewind);
+        return CHIP8_ERROR_INIT;
+    }
+
+    rewind->capacity = capacity;
+
+    (*prewind) = rewind;
+    return CHIP8_ERROR_NO;
+}
+
+void CHIP8_RewindDestroy(chip8_rewind_t *rewind)
+{
+    if( rewind == NULL )
+    {
+        return;
+    }
+
+    free(rewind->ring);
+    free(rewind);
+}
+
+void CHIP8_RewindReset(chip8_rewind_t *rewind)
+{
+    rewind->head = 0;
+    rewind->tail = 0;
+    rewind->used = 0;
+    rewind->frames = 0;
+    rewind->hasBase = false;
+}
+
+void CHIP8_RewindPush(chip8_rewind_t *rewind, chip8_t *chip)
+{
+    rewind_capture(chip, &rewind->current);
+
+    if( rewind->hasBase == false )
+    {
+        rewind->base = rewind->current;
+        rewind->hasBase = true;
+        return;
+    }
+
+    uint32_t payload = rewind_encode((const uint8_t *)&rewind->current, (const uint8_t *)&rewind->base,
+                                     sizeof(chip8_rewind_frame_t), &rewind->scratch[sizeof(uint16_t)]);
+    if( payload == 0 )
+    {
+        return;
+    }
+
+    uint32_t entry = payload + CHIP8_REWIND_ENTRY_OVERHEAD;
+    if( entry > rewind->capacity )
+    {
+        /// Can never be stored, the history restarts from this frame
+        CHIP8_RewindReset(rewind);
+        rewind->base = rewind->current;
+        rewind->hasBase = true;
+        return;
+    }
+
+    while( rewind->used + entry > rewind->capacity )
+    {
+        rewind_drop_oldest(rewind);
+    }
+
+    /// Sizes go around the payload in the scratch buffer so the entry is copied in one go
+    rewind->scratch[0] = (uint8_t)payload;
+    rewind->scratch[1] = (uint8_t)(payload >> 8);
+    rewind->scratch[sizeof(uint16_t) + payload] = (uint8_t)payload;
+    rewind->scratch[sizeof(uint16_t) + payload + 1] = (uint8_t)(payload >> 8);
+
+    rewind_ring_write(rewind, rewind->head, rewind->scratch, entry);
+    rewind->head = (rewind->head + entry) % rewind->capacity;
+    rewind->used += entry;
+    rewind->frames++;
+
+    rewind->base = rewind->current;
+}
+
+bool CHIP8_RewindStep(chip8_rewind_t *rewind, chip8_t *chip)
+{
+    if( rewind->frames == 0 )
+    {
+        return false;
+    }
+
+    uint32_t payload = rewind_ring_get16(rewind, (rewind->head + rewind->capacity - sizeof(uint16_t)) % rewind->capacity);
+    uint32_t entry = payload + CHIP8_REWIND_ENTRY_OVERHEAD;
+    uint32_t start = (rewind->head + rewind->capacity - entry) % rewind->capacity;
+
+    rewind_ring_read(rewind, (start + sizeof(uint16_t)) % rewind->capacity, rewind->scratch, payload);
+
+    /// The delta is newest XOR previous, applying it to the newest frame yields the previous one
+    bool memory_changed = rewind_apply(rewind->scratch, payload, (uint8_t *)&rewind->base);
+
+    rewind->head = start;
+    rewind->used -= entry;
+    rewind->frames--;
+
+    rewind_restore(&rewind->base, chip, memory_changed);
+    return true;
+}
+
+uint32_t CHIP8_RewindGetFrames(chip8_rewind_t *rewind)
+{
+    return rewind->frames;
+}
+
+/////////////////////////////////////////////////
+/// Static functions
+/////////////////////////////////////////////////
+
+static void rewind_capture(const chip8_t *chip, chip8_rewind_frame_t *frame)
+{
+    memcpy(frame->rows, chip->screen.rows, sizeof(frame->rows));
+    frame->rng = chip->rng;
+    frame->cycles = chip->scheduler.cycles;
+    frame->ticks = chip->scheduler.ticks;
+    frame->ipsRemainder = chip->scheduler.ipsRemainder;
+    memcpy(frame->stack, chip->stack, sizeof(frame->stack));
+    frame->I = chip->registers.I;
+    frame->PC = chip->registers.PC;
+    memcpy(frame->V, chip->registers.V, sizeof(frame->V));
+    frame->SP = chip->registers.SP;
+    frame->delayTimer = chip->registers.delayTimer;
+    frame->soundTimer = chip->registers.soundTimer;
+    frame->fault = (uint8_t)chip->fault;
+    memcpy(frame->memory, chip->memory, sizeof(frame->memory));
+    frame->keyWaitPressed = chip->keyWaitPressed;
+    frame->keyWait = chip->keyWait ? 1 : 0;
+    frame->keyWaitReg = chip->keyWaitReg;
+    memcpy(frame->flags, chip->flags, sizeof(frame->flags));
+    frame->hires = chip->screen.hires ? 1 : 0;
+    memset(frame->reserved, 0, sizeof(frame->reserved));
+}
+
+static void rewind_restore(const chip8_rewind_frame_t *frame, chip8_t *chip, bool memory_changed)
+{
+    memcpy(chip->screen.rows, frame->rows, sizeof(frame->rows));
+    chip->rng = frame->rng;
+    chip->scheduler.cycles = frame->cycles;
+    chip->scheduler.ticks = frame->ticks;
+    chip->scheduler.ipsRemainder = frame->ipsRemainder;
+    memcpy(chip->stack, frame->stack, sizeof(frame->stack));
+    chip->registers.I = frame->I;
+    chip->registers.PC = frame->PC;
+    memcpy(chip->registers.V, frame->V, sizeof(frame->V));
+    chip->registers.SP = frame->SP;
+    chip->registers.delayTimer = frame->delayTimer;
+    chip->registers.soundTimer = frame->soundTimer;
+    chip->fault = (chip8_error_t)frame->fault;
+    chip->keyWaitPressed = frame->keyWaitPressed;
+    chip->keyWait = (frame->keyWait != 0);
+    chip->keyWaitReg = frame->keyWaitReg;
+    memcpy(chip->flags, frame->flags, sizeof(frame->flags));
+    chip->screen.hires = (frame->hires != 0);
+    chip->events = CHIP8_EVENT_NONE;
+
+    chip->scheduler.timeAccum = 0;
+    chip->scheduler.windowStartUs = 0;
+    chip->scheduler.windowCycles = 0;
+
+    chip_screen_invalidate(chip);
+
+    /// Most frames never write memory, the decode cache and JIT blocks stay valid then
+    if( memory_changed )
+    {
+        chip_state_reload(chip, frame->memory);
+    }
+}
+
+/// Run length encodes cur XOR prev as tokens of [u16 unchanged bytes][u16 literal length][literal XOR bytes]
+static uint32_t rewind_encode(const uint8_t *cur, const uint8_t *prev, uint32_t size, uint8_t *dst)
+{
+    uint32_t pos = 0;
+    uint32_t out = 0;
+
+    while( pos < size )
+    {
+        uint32_t start = pos;
+
+        /// Unchanged bytes are skipped eight at a time, most of the frame is unchanged memory
+        while( pos + sizeof(uint64_t) <= size )
+        {
+            uint64_t a;
+            uint64_t b;
+            memcpy(&a, &cur[pos], sizeof(a));
+            memcpy(&b, &prev[pos], sizeof(b));
+            if( a != b )
+            {
+                break;
+            }
+            pos += sizeof(uint64_t);
+        }
+
+        while( pos < size && cur[pos] == prev[pos] )
+        {
+            pos++;
+        }
+
+        if( pos == size )
+        {
+            break;
+        }
+
+        /// The literal ends once CHIP8_REWIND_LITERAL_GAP bytes in a row are unchanged
+        uint32_t literal = pos;
+        uint32_t end = pos + 1;
+        for(pos = end; pos < size && pos - end < CHIP8_REWIND_LITERAL_GAP; pos++)
+        {
+            if( cur[pos] != prev[pos] )
+            {
+                end = pos + 1;
+            }
+        }
+
+        uint32_t skip = literal - start;
+        uint32_t length = end - literal;
+
+        dst[out++] = (uint8_t)skip;
+        dst[out++] = (uint8_t)(skip >> 8);
+        dst[out++] = (uint8_t)length;
+        dst[out++] = (uint8_t)(length >> 8);
+        for(uint32_t itr = literal; itr < end; itr++)
+        {
+            dst[out++] = cur[itr] ^ prev[itr];
+        }
+
+        pos = end;
+    }
+
+    return out;
+}
+
+/// XORs a delta into frame, true when it touched the memory image
+static bool rewind_apply(const uint8_t *src, uint32_t size, uint8_t *frame)
+{
+    const uint32_t memory_start = offsetof(chip8_rewind_frame_t, memory);
+    const uint32_t memory_end = memory_start + CHIP8_MEMORY_SIZE;
+    bool memory_changed = false;
+    uint32_t pos = 0;
+    uint32_t in = 0;
+
+    while( in + CHIP8_REWIND_TOKEN_HEADER <= size )
+    {
+        uint32_t skip = src[in] | ((uint32_t)src[in + 1] << 8);
+        uint32_t length = src[in + 2] | ((uint32_t)src[in + 3] << 8);
+        in += CHIP8_REWIND_TOKEN_HEADER;
+        pos += skip;
+
+        if( pos < memory_end && pos + length > memory_start )
+        {
+            memory_changed = true;
+        }
+
+        for(uint32_t itr = 0; itr < length; itr++)
+        {
+            frame[pos++] ^= src[in++];
+        }
+    }
+
+    return memory_changed;
+}
+
+static void rewind_ring_write(chip8_rewind_t *rewind, uint32_t pos, const uint8_t *src, uint32_t size)
+{
+    uint32_t first = rewind->capacity - pos;
+    if( first >= size )
+    {
+        memcpy(&rewind->ring[pos], src, size);
+        return;
+    }
+
+    memcpy(&rewind->ring[pos], src, first);
+    memcpy(rewind->ring, &src[first], size - first);
+}
+
+static void rewind_ring_read(const chip8_rewind_t *rewind, uint32_t pos, uint8_t *dst, uint32_t size)
+{
+    uint32_t first = rewind->capacity - pos;
+    if( first >= size )
+    {
+        memcpy(dst, &rewind->ring[pos], size);
+        return;
+    }
+
+    memcpy(dst, &rewind->ring[pos], first);
+    memcpy(&dst[first], rewind->ring, size - first);
+}
+
+static uint16_t rewind_ring_get16(const chip8_rewind_t *rewind, uint32_t pos)
+{
+    uint8_t bytes[sizeof(uint16_t)];
+    rewind_ring_read(rewind, pos, bytes, sizeof(bytes));
+    return (uint16_t)(bytes[0] | (bytes[1] << 8));
+}
+
+static void rewind_drop_oldest(chip8_rewind_t *rewind)
+{
+    uint32_t entry = rewind_ring_get16(rewind, rewind->tail) + CHIP8_REWIND_ENTRY_OVERHEAD;
+
+    rewind->tail = (rewind->tail + entry) % rewind->capacity;
+    rewind->used -= entry;
+    rewind->frames--;
+}
@@ -0,0 +1,82 @@
+#ifndef CHIP8_CHIP8_REWIND_H
+#define CHIP8_CHIP8_REWIND_H
+
+/////////////////////////////////////////////////
+/// Includes
+/////////////////////////////////////////////////
+
+#include "CHIP8.h"
+
+/////////////////////////////////////////////////
+/// Defines
+/////////////////////////////////////////////////
+
+#define CHIP8_REWIND_DEFAULT_CAPACITY   (512u * 1024u)  /// Comfortably more than 60 seconds of typical history
+
+/////////////////////////////////////////////////
+/// Typedef structures
+/////////////////////////////////////////////////
+
+/// Flat image of everything a frame can change, the keyboard is input and is never rewound.
+/// Fields are ordered so there is no padding, deltas are taken over the raw bytes.
+typedef struct CHIP8_REWIND_FRAME_STRUCT
+{
+    uint64_t    rows[CHIP8_HEIGHT_SCREEN][CHIP8_SCREEN_ROW_WORDS];
+    uint64_t    rng;
+    uint64_t    cycles;
+    uint64_t    ticks;
+    uint32_t    ipsRemainder;
+    uint16_t    stack[CHIP8_STACK_DEPTH_TOTAL];
+    uint16_t    I;
+    uint16_t    PC;
+    uint8_t     V[CHIP8_DATA_REGISTERS_TOTAL];
+    uint8_t     SP;
+    uint8_t     delayTimer;
+    uint8_t     soundTimer;
+    uint8_t     fault;
+    uint8_t     memory[CHIP8_MEMORY_SIZE];
+    uint16_t    keyWaitPressed;
+    uint8_t     keyWait;
+    uint8_t     keyWaitReg;
+    uint8_t     flags[CHIP8_FLAG_REGISTERS_TOTAL];
+    uint8_t     hires;
+    uint8_t     reserved[7];    /// Keeps the size a multiple of 8 without tail padding
+
+} chip8_rewind_frame_t;
+
+/// Ring of XOR deltas between consecutive frames.
+/// Every entry is [u16 size][run length encoded delta][u16 size] so the ring can be walked
+/// forward to drop the oldest entry and backward to undo the newest one.
+typedef struct CHIP8_REWIND_STRUCT
+{
+    uint8_t                 *ring;
+    uint32_t                capacity;
+    uint32_t                head;       /// Where the next entry is written
+    uint32_t                tail;       /// Oldest entry
+    uint32_t                used;       /// Bytes held by entries
+    uint32_t                frames;     /// Entries in the ring, the number of possible steps back
+    bool                    hasBase;
+    chip8_rewind_frame_t    base;       /// Newest pushed frame, the deltas lead back from it
+    chip8_rewind_frame_t    current;    /// Scratch frame of the push in progress
+    uint8_t                 scratch[sizeof(chip8_rewind_frame_t) * 2];
+
+} chip8_rewind_t;
+
+/////////////////////////////////////////////////
+/// Public Prototype Functions
+/////////////////////////////////////////////////
+
+/// capacity is the size of the delta ring in bytes, the oldest frames are dropped once it is full
+chip8_error_t CHIP8_RewindCreate(chip8_rewind_t **prewind, uint32_t capacity);
+void CHIP8_RewindDestroy(chip8_rewind_t *rewind);
+void CHIP8_RewindReset(chip8_rewind_t *rewind);
+
+/// Records the state of chip, call once per frame. A frame identical to the previous one is not recorded.
+void CHIP8_RewindPush(chip8_rewind_t *rewind, chip8_t *chip);
+
+/// Moves chip one recorded frame back, false when the history is exhausted.
+/// The keymap, engine, speed and trace session of chip are kept.
+bool CHIP8_RewindStep(chip8_rewind_t *rewind, chip8_t *chip);
+uint32_t CHIP8_RewindGetFrames(chip8_rewind_t *rewind);
+
+#endif //CHIP8_CHIP8_REWIND_H
@@ -0,0 +1,417 @@
+/////////////////////////////////////////////////
+/// Includes
+/////////////////////////////////////////////////
+
+#include "CHIP8_State.h"
+#include <string.h>
+
+/////////////////////////////////////////////////
+/// Defines
+/////////////////////////////////////////////////
+
+#define CHIP8_STATE_FNV_OFFSET_BASIS    0x811C9DC5u
+#define CHIP8_STATE_FNV_PRIME           0x01000193u
+#define CHIP8_STATE_PACKBITS_RUN        128     /// Longest literal or repeat run of one PackBits header
+
+/////////////////////////////////////////////////
+/// Typedef structures
+/////////////////////////////////////////////////
+
+typedef struct CHIP8_STATE_CURSOR_STRUCT
+{
+    uint8_t         *data;
+    const uint8_t   *input;
+    uint32_t        pos;
+
+} chip8_state_cursor_t;
+
+/////////////////////////////////////////////////
+/// Prototype static functions
+/////////////////////////////////////////////////
+
+static void state_put8(chip8_state_cursor_t *c, uint8_t value);
+static void state_put16(chip8_state_cursor_t *c, uint16_t value);
+static void state_put32(chip8_state_cursor_t *c, uint32_t value);
+static void state_put64(chip8_state_cursor_t *c, uint64_t value);
+static uint8_t state_get8(chip8_state_cursor_t *c);
+static uint16_t state_get16(chip8_state_cursor_t *c);
+static uint32_t state_get32(chip8_state_cursor_t *c);
+static uint64_t state_get64(chip8_state_cursor_t *c);
+static uint32_t state_pack(const uint8_t *src, uint32_t size, uint8_t *dst);
+static bool state_unpack(const uint8_t *src, uint32_t size, uint8_t *dst, uint32_t capacity);
+static uint32_t state_checksum(const uint8_t *data, uint32_t size);
+static uint32_t state_screen_size(bool hires);
+
+/////////////////////////////////////////////////
+/// Public functions
+/////////////////////////////////////////////////
+
+chip8_error_t CHIP8_SaveState(chip8_t *chip, uint8_t *buffer, uint32_t capacity, uint32_t *size)
+{
+    uint8_t packed[CHIP8_STATE_MEMORY_MAX];
+    uint8_t screen[CHIP8_STATE_SCREEN_SIZE];
+    uint8_t packed_screen[CHIP8_STATE_SCREEN_MAX];
+    chip8_state_cursor_t c = { buffer, buffer, 0 };
+
+    if( chip == NULL || buffer == NULL )
+    {
+        return CHIP8_ERROR_INIT;
+    }
+
+    if( chip->scheduler.ips == CHIP8_IPS_UNBOUNDED )
+    {
+        return CHIP8_ERROR_NOT_SUPPORTED;
+    }
+
+    /// Only the active resolution is stored, big endian rows keep it a plain 1bpp image
+    chip8_state_cursor_t image = { screen, screen, 0 };
+    uint32_t height = chip->screen.hires ? CHIP8_HEIGHT_SCREEN : CHIP8_LORES_HEIGHT_SCREEN;
+    uint32_t words = chip->screen.hires ? CHIP8_SCREEN_ROW_WORDS : 1;
+
+    for(uint32_t row = 0; row < height; row++)
+    {
+        for(uint32_t word = 0; word < words; word++)
+        {
+            for(int32_t shift = 56; shift >= 0; shift -= 8)
+            {
+                state_put8(&image, (uint8_t)(chip->screen.rows[row][word] >> shift));
+            }
+        }
+    }
+
+    uint32_t screen_size = state_pack(screen, image.pos, packed_screen);
+    uint32_t packed_size = state_pack(chip->memory, CHIP8_MEMORY_SIZE, packed);
+    uint32_t total = CHIP8_STATE_FIXED_SIZE + screen_size + packed_size;
+    if( total > capacity )
+    {
+        return CHIP8_ERROR_DATA_OVERSIZE;
+    }
+
+    state_put32(&c, CHIP8_STATE_MAGIC);
+    state_put16(&c, CHIP8_STATE_VERSION);
+    state_put16(&c, (uint16_t)total);
+
+    memcpy(&buffer[c.pos], chip->registers.V, CHIP8_DATA_REGISTERS_TOTAL);
+    c.pos += CHIP8_DATA_REGISTERS_TOTAL;
+    state_put16(&c, chip->registers.I);
+    state_put16(&c, chip->registers.PC);
+    state_put8(&c, chip->registers.SP);
+    state_put8(&c, chip->registers.delayTimer);
+    state_put8(&c, chip->registers.soundTimer);
+
+    for(uint32_t itr = 0; itr < CHIP8_STACK_DEPTH_TOTAL; itr++)
+    {
+        state_put16(&c, chip->stack[itr]);
+    }
+
+    state_put16(&c, chip->keys);
+    state_put8(&c, (uint8_t)chip->fault);
+    state_put64(&c, chip->rng);
+    state_put8(&c, chip->keyWait ? chip->keyWaitReg : CHIP8_STATE_NO_KEY_WAIT);
+    state_put16(&c, chip->keyWaitPressed);
+    memcpy(&buffer[c.pos], chip->flags, CHIP8_FLAG_REGISTERS_TOTAL);
+    c.pos += CHIP8_FLAG_REGISTERS_TOTAL;
+    state_put8(&c, chip->screen.hires ? 1 : 0);
+
+    state_put32(&c, chip->scheduler.ips);
+    state_put32(&c, chip->scheduler.ipsRemainder);
+    state_put64(&c, chip->scheduler.cycles);
+    state_put64(&c, chip->scheduler.ticks);
+
+    state_put16(&c, (uint16_t)screen_size);
+    memcpy(&buffer[c.pos], packed_screen, screen_size);
+    c.pos += screen_size;
+
+    state_put16(&c, (uint16_t)packed_size);
+    memcpy(&buffer[c.pos], packed, packed_size);
+    c.pos += packed_size;
+
+    state_put32(&c, state_checksum(buffer, c.pos));
+
+    (*size) = c.pos;
+    return CHIP8_ERROR_NO;
+}
+
+chip8_error_t CHIP8_LoadState(chip8_t *chip, const uint8_t *buffer, uint32_t size)
+{
+    uint8_t memory[CHIP8_MEMORY_SIZE];
+    uint8_t screen[CHIP8_STATE_SCREEN_SIZE];
+    chip8_registers_t registers;
+    chip8_stack_t stack;
+    uint64_t rows[CHIP8_HEIGHT_SCREEN][CHIP8_SCREEN_ROW_WORDS];
+    uint8_t flags[CHIP8_FLAG_REGISTERS_TOTAL];
+    chip8_state_cursor_t c = { NULL, buffer, 0 };
+
+    if( chip == NULL || buffer == NULL )
+    {
+        return CHIP8_ERROR_INIT;
+    }
+
+    if( size < CHIP8_STATE_FIXED_SIZE || state_get32(&c) != CHIP8_STATE_MAGIC || state_get16(&c) != CHIP8_STATE_VERSION
+        || state_get16(&c) != size )
+    {
+        return CHIP8_ERROR_INVALID_STATE;
+    }
+
+    c.pos = size - sizeof(uint32_t);
+    if( state_get32(&c) != state_checksum(buffer, size - sizeof(uint32_t)) )
+    {
+        return CHIP8_ERROR_INVALID_STATE;
+    }
+
+    c.pos = 8;
+    memcpy(registers.V, &buffer[c.pos], CHIP8_DATA_REGISTERS_TOTAL);
+    c.pos += CHIP8_DATA_REGISTERS_TOTAL;
+    registers.I = state_get16(&c);
+    registers.PC = state_get16(&c);
+    registers.SP = state_get8(&c);
+    registers.delayTimer = state_get8(&c);
+    registers.soundTimer = state_get8(&c);
+
+    for(uint32_t itr = 0; itr < CHIP8_STACK_DEPTH_TOTAL; itr++)
+    {
+        stack[itr] = state_get16(&c);
+    }
+
+    uint16_t keys = state_get16(&c);
+    uint8_t fault = state_get8(&c);
+    uint64_t rng = state_get64(&c);
+    uint8_t key_wait = state_get8(&c);
+    uint16_t key_wait_pressed = state_get16(&c);
+    memcpy(flags, &buffer[c.pos], CHIP8_FLAG_REGISTERS_TOTAL);
+    c.pos += CHIP8_FLAG_REGISTERS_TOTAL;
+    uint8_t hires = state_get8(&c);
+
+    uint32_t ips = state_get32(&c);
+    uint32_t ips_remainder = state_get32(&c);
+    uint64_t cycles = state_get64(&c);
+    uint64_t ticks = state_get64(&c);
+
+    uint16_t screen_size = state_get16(&c);
+
+    /// The screen is checked first, its size decides where the memory image starts
+    if( hires > 1 || c.pos + screen_size + sizeof(uint16_t) + sizeof(uint32_t) > size
+        || state_unpack(&buffer[c.pos], screen_size, screen, state_screen_size(hires != 0)) == false )
+    {
+        return CHIP8_ERROR_INVALID_STATE;
+    }
+    c.pos += screen_size;
+
+    chip8_state_cursor_t image = { NULL, screen, 0 };
+    uint32_t height = (hires != 0) ? CHIP8_HEIGHT_SCREEN : CHIP8_LORES_HEIGHT_SCREEN;
+    uint32_t words = (hires != 0) ? CHIP8_SCREEN_ROW_WORDS : 1;
+
+    memset(rows, 0, sizeof(rows));
+    for(uint32_t row = 0; row < height; row++)
+    {
+        for(uint32_t word = 0; word < words; word++)
+        {
+            for(uint32_t byte = 0; byte < sizeof(rows[0][0]); byte++)
+            {
+                rows[row][word] = (rows[row][word] << 8) | state_get8(&image);
+            }
+        }
+    }
+
+    uint16_t packed_size = state_get16(&c);
+
+    if( registers.SP > CHIP8_STACK_DEPTH_TOTAL || rng == 0 || fault > CHIP8_ERROR_EXIT
+        || ips == CHIP8_IPS_UNBOUNDED || ips_remainder >= CHIP8_TIMER_FREQUENCY_HZ
+        || (key_wait >= CHIP8_DATA_REGISTERS_TOTAL && key_wait != CHIP8_STATE_NO_KEY_WAIT)
+        || c.pos + packed_size + sizeof(uint32_t) != size
+        || state_unpack(&buffer[c.pos], packed_size, memory, sizeof(memory)) == false )
+    {
+        return CHIP8_ERROR_INVALID_STATE;
+    }
+
+    /// Everything is validated, commit
+    chip->registers = registers;
+    memcpy(chip->stack, stack, sizeof(stack));
+    memcpy(chip->screen.rows, rows, sizeof(rows));
+    memcpy(chip->flags, flags, sizeof(flags));
+    chip->screen.hires = (hires != 0);
+
+    chip->keys = keys;
+
+    chip->fault = (chip8_error_t)fault;
+    chip->rng = rng;
+    chip->keyWait = (key_wait != CHIP8_STATE_NO_KEY_WAIT);
+    chip->keyWaitReg = chip->keyWait ? key_wait : 0;
+    chip->keyWaitPressed = key_wait_pressed;
+    chip->events = CHIP8_EVENT_NONE;
+
+    chip->scheduler.ips = ips;
+    chip->scheduler.ipsRemainder = ips_remainder;
+    chip->scheduler.cycles = cycles;
+    chip->scheduler.ticks = ticks;
+    chip->scheduler.timeAccum = 0;
+    chip->scheduler.windowStartUs = 0;
+    chip->scheduler.windowCycles = 0;
+
+    /// The restored screen has nothing in common with what the front-end shows
+    chip_screen_invalidate(chip);
+
+    chip_state_reload(chip, memory);
+
+    return CHIP8_ERROR_NO;
+}
+
+/////////////////////////////////////////////////
+/// Static functions
+/////////////////////////////////////////////////
+
+static void state_put8(chip8_state_cursor_t *c, uint8_t value)
+{
+    c->data[c->pos++] = value;
+}
+
+static void state_put16(chip8_state_cursor_t *c, uint16_t value)
+{
+    state_put8(c, (uint8_t)value);
+    state_put8(c, (uint8_t)(value >> 8));
+}
+
+static void state_put32(chip8_state_cursor_t *c, uint32_t value)
+{
+    state_put16(c, (uint16_t)value);
+    state_put16(c, (uint16_t)(value >> 16));
+}
+
+static void state_put64(chip8_state_cursor_t *c, uint64_t value)
+{
+    state_put32(c, (uint32_t)value);
+    state_put32(c, (uint32_t)(value >> 32));
+}
+
+static uint8_t state_get8(chip8_state_cursor_t *c)
+{
+    return c->input[c->pos++];
+}
+
+static uint16_t state_get16(chip8_state_cursor_t *c)
+{
+    uint16_t low = state_get8(c);
+    return (uint16_t)(low | (uint16_t)state_get8(c) << 8);
+}
+
+static uint32_t state_get32(chip8_state_cursor_t *c)
+{
+    uint32_t low = state_get16(c);
+    return low | (uint32_t)state_get16(c) << 16;
+}
+
+static uint64_t state_get64(chip8_state_cursor_t *c)
+{
+    uint64_t low = state_get32(c);
+    return low | (uint64_t)state_get32(c) << 32;
+}
+
+static uint32_t state_pack(const uint8_t *src, uint32_t size, uint8_t *dst)
+{
+    uint32_t in = 0;
+    uint32_t out = 0;
+
+    /// PackBits: header n < 128 is followed by n + 1 literal bytes, n > 128 repeats the next byte 257 - n times
+    while( in < size )
+    {
+        uint32_t run = 1;
+        uint64_t pattern = src[in] * 0x0101010101010101ULL;
+
+        /// Long runs (the unused memory) are compared eight bytes at a time
+        while( in + run + sizeof(uint64_t) <= size && run + sizeof(uint64_t) <= CHIP8_STATE_PACKBITS_RUN )
+        {
+            uint64_t chunk;
+            memcpy(&chunk, &src[in + run], sizeof(chunk));
+            if( chunk != pattern )
+            {
+                break;
+            }
+            run += sizeof(uint64_t);
+        }
+
+        while( in + run < size && run < CHIP8_STATE_PACKBITS_RUN && src[in + run] == src[in] )
+        {
+            run++;
+        }
+
+        if( run >= 3 )
+        {
+            dst[out++] = (uint8_t)(257 - run);
+            dst[out++] = src[in];
+            in += run;
+            continue;
+        }
+
+        /// Literal bytes up to the next run worth encoding
+        uint32_t start = in;
+        while( in < size && in - start < CHIP8_STATE_PACKBITS_RUN )
+        {
+            if( in + 2 < size && src[in] == src[in + 1] && src[in] == src[in + 2] )
+            {
+                break;
+            }
+            in++;
+        }
+
+        dst[out++] = (uint8_t)(in - start - 1);
+        memcpy(&dst[out], &src[start], in - start);
+        out += in - start;
+    }
+
+    return out;
+}
+
+static bool state_unpack(const uint8_t *src, uint32_t size, uint8_t *dst, uint32_t capacity)
+{
+    uint32_t in = 0;
+    uint32_t out = 0;
+
+    while( in < size )
+    {
+        uint8_t header = src[in++];
+
+        if( header < 128 )
+        {
+            uint32_t length = header + 1u;
+            if( in + length > size || out + length > capacity )
+            {
+                return false;
+            }
+
+            memcpy(&dst[out], &src[in], length);
+            in += length;
+            out += length;
+        }
+        else if( header > 128 )
+        {
+            uint32_t length = 257u - header;
+            if( in >= size || out + length > capacity )
+            {
+                return false;
+            }
+
+            memset(&dst[out], src[in++], length);
+            out += length;
+        }
+    }
+
+    return out == capacity;
+}
+
+static uint32_t state_checksum(const uint8_t *data, uint32_t size)
+{
+    uint32_t hash = CHIP8_STATE_FNV_OFFSET_BASIS;
+
+    for(uint32_t itr = 0; itr < size; itr++)
+    {
+        hash ^= data[itr];
+        hash *= CHIP8_STATE_FNV_PRIME;
+    }
+
+    return hash;
+}
+
+static uint32_t state_screen_size(bool hires)
+{
+    return hires ? CHIP8_STATE_SCREEN_SIZE : CHIP8_STATE_SCREEN_SIZE / 4;
+}
@@ -0,0 +1,58 @@
+#ifndef CHIP8_CHIP8_STATE_H
+#define CHIP8_CHIP8_STATE_H
+
+/////////////////////////////////////////////////
+/// Includes
+/////////////////////////////////////////////////
+
+#include "CHIP8.h"
+
+/////////////////////////////////////////////////
+/// Defines
+/////////////////////////////////////////////////
+
+#define CHIP8_STATE_MAGIC           0x54533843  /// "C8ST"
+#define CHIP8_STATE_VERSION         4
+#define CHIP8_STATE_FIXED_SIZE      126         /// Every field except the packed screen and memory images
+#define CHIP8_STATE_NO_KEY_WAIT     0xFF        /// Key wait register of a VM that is not parked in FX0A
+#define CHIP8_STATE_SCREEN_SIZE     (CHIP8_WIDTH_SCREEN * CHIP8_HEIGHT_SCREEN / 8)         /// High resolution 1bpp image
+#define CHIP8_STATE_SCREEN_MAX      (CHIP8_STATE_SCREEN_SIZE + CHIP8_STATE_SCREEN_SIZE / 128)  /// PackBits worst case
+#define CHIP8_STATE_MEMORY_MAX      (CHIP8_MEMORY_SIZE + CHIP8_MEMORY_SIZE / 128)  /// PackBits worst case
+#define CHIP8_STATE_MAX_SIZE        (CHIP8_STATE_FIXED_SIZE + CHIP8_STATE_SCREEN_MAX + CHIP8_STATE_MEMORY_MAX)
+/// Bound of a snapshot taken in the 64x32 mode, only a high resolution screen of noise goes past it
+#define CHIP8_STATE_LORES_MAX_SIZE  (CHIP8_STATE_FIXED_SIZE + CHIP8_STATE_SCREEN_SIZE / 4 + CHIP8_STATE_SCREEN_SIZE / 512 + CHIP8_STATE_MEMORY_MAX)
+
+/// Snapshot layout, every integer little endian:
+///     u32 magic, u16 version, u16 total size
+///     u8 V[16], u16 I, u16 PC, u8 SP, u8 delay timer, u8 sound timer
+///     u16 stack[16], u16 key mask (bit n is key n), u8 fault, u64 rng
+///     u8 key wait register or CHIP8_STATE_NO_KEY_WAIT, u16 keys pressed during the wait
+///     u8 flags[16], u8 high resolution (0 or 1)
+///     u32 ips, u32 ips remainder, u64 cycles, u64 ticks
+///     u16 packed screen size, PackBits compressed rows of the active resolution (32 rows of 8 bytes or
+///     64 rows of 16 bytes), leftmost pixel in the most significant bit of the first byte (PBM P4)
+///     u16 packed memory size, PackBits compressed memory image
+///     u32 FNV-1a of everything before it
+
+/////////////////////////////////////////////////
+/// Public Prototype Functions
+/////////////////////////////////////////////////
+
+/// Writes the VM state to buffer, CHIP8_STATE_MAX_SIZE bytes are always enough.
+/// A VM running at CHIP8_IPS_UNBOUNDED has no reproducible schedule and is not saved.
+chip8_error_t CHIP8_SaveState(chip8_t *chip, uint8_t *buffer, uint32_t capacity, uint32_t *size);
+
+/// Restores a snapshot, the keymap, engine and trace session of chip are kept.
+/// Nothing is modified when the snapshot is rejected.
+chip8_error_t CHIP8_LoadState(chip8_t *chip, const uint8_t *buffer, uint32_t size);
+
+/////////////////////////////////////////////////
+/// Internal Prototype Functions
+/////////////////////////////////////////////////
+
+/// Implemented by the core, copies a restored memory image in and only decodes or translates again what it changed
+void chip_state_reload(chip8_t *chip, const uint8_t *memory);
+/// Implemented by the core, reports the whole active screen dirty after it was replaced
+void chip_screen_invalidate(chip8_t *chip);
+
+#endif //CHIP8_CHIP8_STATE_H
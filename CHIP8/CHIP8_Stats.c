@@ -0,0 +1,247 @@
+/////////////////////////////////////////////////
+/// Includes
+/////////////////////////////////////////////////
+
+#include "CHIP8_Stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/////////////////////////////////////////////////
+/// Local variables
+/////////////////////////////////////////////////
+
+static const char *const stats_class_names[CHIP8_STATS_CLASS_TOTAL] =
+{
+    "00E0", "00EE", "00CN", "00FB", "00FC", "00FD", "00FE", "00FF",
+    "1NNN", "2NNN", "3XNN", "4XNN", "5XY0", "6XNN", "7XNN",
+    "8XY0", "8XY1", "8XY2", "8XY3", "8XY4", "8XY5", "8XY6", "8XY7", "8XYE",
+    "9XY0", "ANNN", "BNNN", "CXNN", "DXYN", "DXY0", "EX9E", "EXA1",
+    "FX07", "FX0A", "FX15", "FX18", "FX1E", "FX29", "FX30", "FX33", "FX55", "FX65", "FX75", "FX85",
+    "invalid",
+};
+
+/////////////////////////////////////////////////
+/// Public functions
+/////////////////////////////////////////////////
+
+chip8_stats_class_id_t CHIP8_StatsClassify(uint16_t opcode)
+{
+    switch( opcode >> 12 )
+    {
+        case 0x0:
+            if( (opcode & 0xFFF0) == 0x00C0 )
+            {
+                return CHIP8_STATS_CLASS_00CN;
+            }
+            switch( opcode )
+            {
+                case 0x00E0: return CHIP8_STATS_CLASS_00E0;
+                case 0x00EE: return CHIP8_STATS_CLASS_00EE;
+                case 0x00FB: return CHIP8_STATS_CLASS_00FB;
+                case 0x00FC: return CHIP8_STATS_CLASS_00FC;
+                case 0x00FD: return CHIP8_STATS_CLASS_00FD;
+                case 0x00FE: return CHIP8_STATS_CLASS_00FE;
+                case 0x00FF: return CHIP8_STATS_CLASS_00FF;
+                default: return CHIP8_STATS_CLASS_INVALID;
+            }
+
+        case 0x1: return CHIP8_STATS_CLASS_1NNN;
+        case 0x2: return CHIP8_STATS_CLASS_2NNN;
+        case 0x3: return CHIP8_STATS_CLASS_3XNN;
+        case 0x4: return CHIP8_STATS_CLASS_4XNN;
+        case 0x5: return CHIP8_STATS_CLASS_5XY0;
+        case 0x6: return CHIP8_STATS_CLASS_6XNN;
+        case 0x7: return CHIP8_STATS_CLASS_7XNN;
+
+        case 0x8:
+            switch( opcode & 0x000F )
+            {
+                case 0x0: return CHIP8_STATS_CLASS_8XY0;
+                case 0x1: return CHIP8_STATS_CLASS_8XY1;
+                case 0x2: return CHIP8_STATS_CLASS_8XY2;
+                case 0x3: return CHIP8_STATS_CLASS_8XY3;
+                case 0x4: return CHIP8_STATS_CLASS_8XY4;
+                case 0x5: return CHIP8_STATS_CLASS_8XY5;
+                case 0x6: return CHIP8_STATS_CLASS_8XY6;
+                case 0x7: return CHIP8_STATS_CLASS_8XY7;
+                case 0xE: return CHIP8_STATS_CLASS_8XYE;
+                default: return CHIP8_STATS_CLASS_INVALID;
+            }
+
+        case 0x9: return CHIP8_STATS_CLASS_9XY0;
+        case 0xA: return CHIP8_STATS_CLASS_ANNN;
+        case 0xB: return CHIP8_STATS_CLASS_BNNN;
+        case 0xC: return CHIP8_STATS_CLASS_CXNN;
+        case 0xD: return ((opcode & 0x000F) == 0) ? CHIP8_STATS_CLASS_DXY0 : CHIP8_STATS_CLASS_DXYN;
+
+        case 0xE:
+            switch( opcode & 0x00FF )
+            {
+                case 0x9E: return CHIP8_STATS_CLASS_EX9E;
+                case 0xA1: return CHIP8_STATS_CLASS_EXA1;
+                default: return CHIP8_STATS_CLASS_INVALID;
+            }
+
+        default:
+            switch( opcode & 0x00FF )
+            {
+                case 0x07: return CHIP8_STATS_CLASS_FX07;
+                case 0x0A: return CHIP8_STATS_CLASS_FX0A;
+                case 0x15: return CHIP8_STATS_CLASS_FX15;
+                case 0x18: return CHIP8_STATS_CLASS_FX18;
+                case 0x1E: return CHIP8_STATS_CLASS_FX1E;
+                case 0x29: return CHIP8_STATS_CLASS_FX29;
+                case 0x30: return CHIP8_STATS_CLASS_FX30;
+                case 0x33: return CHIP8_STATS_CLASS_FX33;
+                case 0x55: return CHIP8_STATS_CLASS_FX55;
+                case 0x65: return CHIP8_STATS_CLASS_FX65;
+                case 0x75: return CHIP8_STATS_CLASS_FX75;
+                case 0x85: return CHIP8_STATS_CLASS_FX85;
+                default: return CHIP8_STATS_CLASS_INVALID;
+            }
+    }
+}
+
+const char *CHIP8_StatsGetClassName(chip8_stats_class_id_t id)
+{
+    return (id < CHIP8_STATS_CLASS_TOTAL) ? stats_class_names[id] : "unknown";
+}
+
+chip8_error_t CHIP8_StatsWriteCsv(const chip8_stats_t *stats, const char *path)
+{
+    if( stats == NULL || path == NULL )
+    {
+        return CHIP8_ERROR_INIT;
+    }
+
+    FILE *f = fopen(path, "w");
+    if( f == NULL )
+    {
+        return CHIP8_ERROR_INIT;
+    }
+
+    fprintf(f, "kind,name,count,samples,ticks");
+    for(uint32_t bucket = 0; bucket < CHIP8_STATS_BUCKETS; bucket++)
+    {
+        fprintf(f, ",bucket_%u", bucket);
+    }
+    fprintf(f, "\n");
+
+    for(uint32_t itr = 0; itr < CHIP8_STATS_CLASS_TOTAL; itr++)
+    {
+        const chip8_stats_class_t *cls = &stats->classes[itr];
+
+        fprintf(f, "class,%s,%llu,%llu,%llu", stats_class_names[itr], (unsigned long long)cls->count,
+                (unsigned long long)cls->samples, (unsigned long long)cls->ticks);
+        for(uint32_t bucket = 0; bucket < CHIP8_STATS_BUCKETS; bucket++)
+        {
+            fprintf(f, ",%llu", (unsigned long long)cls->histogram[bucket]);
+        }
+        fprintf(f, "\n");
+    }
+
+    /// Exact opcodes are only counted, their cost is in the class rows
+    for(uint32_t opcode = 0; opcode < CHIP8_STATS_OPCODES; opcode++)
+    {
+        if( stats->opcodes[opcode] != 0 )
+        {
+            fprintf(f, "opcode,%04X,%llu,,\n", opcode, (unsigned long long)stats->opcodes[opcode]);
+        }
+    }
+
+    bool failed = (ferror(f) != 0);
+    failed |= (fclose(f) != 0);
+
+    return failed ? CHIP8_ERROR_INIT : CHIP8_ERROR_NO;
+}
+
+#ifdef CHIP8_STATS
+
+chip8_error_t CHIP8_StatsStart(chip8_t *chip, uint32_t sample_shift)
+{
+    if( chip == NULL || chip->stats != NULL || sample_shift >= 32 )
+    {
+        return CHIP8_ERROR_INIT;
+    }
+
+    chip8_stats_t *stats = (chip8_stats_t *)calloc(1, sizeof(chip8_stats_t));
+    if( stats == NULL )
+    {
+        return CHIP8_ERROR_INIT;
+    }
+
+    stats->sampleMask = ~(UINT32_MAX >> sample_shift);
+    chip->stats = stats;
+
+    return CHIP8_ERROR_NO;
+}
+
+chip8_error_t CHIP8_StatsStop(chip8_t *chip)
+{
+    if( chip->stats == NULL )
+    {
+        return CHIP8_ERROR_INIT;
+    }
+
+    free(chip->stats);
+    chip->stats = NULL;
+
+    return CHIP8_ERROR_NO;
+}
+
+chip8_error_t CHIP8_GetStats(chip8_t *chip, chip8_stats_t *stats)
+{
+    if( chip->stats == NULL || stats == NULL )
+    {
+        return CHIP8_ERROR_INIT;
+    }
+
+    memcpy(stats, chip->stats, sizeof(chip8_stats_t));
+
+    /// Class counts are derived here so the hot path only bumps the opcode counter
+    stats->instructions = 0;
+    for(uint32_t itr = 0; itr < CHIP8_STATS_CLASS_TOTAL; itr++)
+    {
+        stats->classes[itr].count = 0;
+    }
+
+    for(uint32_t opcode = 0; opcode < CHIP8_STATS_OPCODES; opcode++)
+    {
+        if( stats->opcodes[opcode] != 0 )
+        {
+            stats->classes[CHIP8_StatsClassify((uint16_t)opcode)].count += stats->opcodes[opcode];
+            stats->instructions += stats->opcodes[opcode];
+        }
+    }
+
+    return CHIP8_ERROR_NO;
+}
+
+#else
+
+/////////////////////////////////////////////////
+/// Public functions (statistics compiled out)
+/////////////////////////////////////////////////
+
+chip8_error_t CHIP8_StatsStart(chip8_t *chip, uint32_t sample_shift)
+{
+    (void)chip;
+    (void)sample_shift;
+    return CHIP8_ERROR_NOT_SUPPORTED;
+}
+
+chip8_error_t CHIP8_StatsStop(chip8_t *chip)
+{
+    (void)chip;
+    return CHIP8_ERROR_NOT_SUPPORTED;
+}
+
+chip8_error_t CHIP8_GetStats(chip8_t *chip, chip8_stats_t *stats)
+{
+    (void)chip;
+    (void)stats;
+    return CHIP8_ERROR_NOT_SUPPORTED;
+}
+
+#endif
@@ -0,0 +1,193 @@
+#ifndef CHIP8_CHIP8_STATS_H
+#define CHIP8_CHIP8_STATS_H
+
+/////////////////////////////////////////////////
+/// Includes
+/////////////////////////////////////////////////
+
+#include "CHIP8.h"
+
+#ifdef CHIP8_STATS
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#endif
+
+/////////////////////////////////////////////////
+/// Defines
+/////////////////////////////////////////////////
+
+#define CHIP8_STATS_OPCODES             65536   /// One counter per 16-bit opcode
+#define CHIP8_STATS_BUCKETS             32      /// Bucket n counts handler costs of [2^n, 2^(n+1)) host ticks
+#define CHIP8_STATS_DEFAULT_SAMPLE_SHIFT 4      /// Time one instruction in 2^shift
+
+/////////////////////////////////////////////////
+/// Typedef enumerations
+/////////////////////////////////////////////////
+
+/// Instruction families, named after the opcode pattern, SCHIP ones included
+typedef enum CHIP8_STATS_CLASS_TYPE
+{
+    CHIP8_STATS_CLASS_00E0 = 0,
+    CHIP8_STATS_CLASS_00EE,
+    CHIP8_STATS_CLASS_00CN,
+    CHIP8_STATS_CLASS_00FB,
+    CHIP8_STATS_CLASS_00FC,
+    CHIP8_STATS_CLASS_00FD,
+    CHIP8_STATS_CLASS_00FE,
+    CHIP8_STATS_CLASS_00FF,
+    CHIP8_STATS_CLASS_1NNN,
+    CHIP8_STATS_CLASS_2NNN,
+    CHIP8_STATS_CLASS_3XNN,
+    CHIP8_STATS_CLASS_4XNN,
+    CHIP8_STATS_CLASS_5XY0,
+    CHIP8_STATS_CLASS_6XNN,
+    CHIP8_STATS_CLASS_7XNN,
+    CHIP8_STATS_CLASS_8XY0,
+    CHIP8_STATS_CLASS_8XY1,
+    CHIP8_STATS_CLASS_8XY2,
+    CHIP8_STATS_CLASS_8XY3,
+    CHIP8_STATS_CLASS_8XY4,
+    CHIP8_STATS_CLASS_8XY5,
+    CHIP8_STATS_CLASS_8XY6,
+    CHIP8_STATS_CLASS_8XY7,
+    CHIP8_STATS_CLASS_8XYE,
+    CHIP8_STATS_CLASS_9XY0,
+    CHIP8_STATS_CLASS_ANNN,
+    CHIP8_STATS_CLASS_BNNN,
+    CHIP8_STATS_CLASS_CXNN,
+    CHIP8_STATS_CLASS_DXYN,
+    CHIP8_STATS_CLASS_DXY0,
+    CHIP8_STATS_CLASS_EX9E,
+    CHIP8_STATS_CLASS_EXA1,
+    CHIP8_STATS_CLASS_FX07,
+    CHIP8_STATS_CLASS_FX0A,
+    CHIP8_STATS_CLASS_FX15,
+    CHIP8_STATS_CLASS_FX18,
+    CHIP8_STATS_CLASS_FX1E,
+    CHIP8_STATS_CLASS_FX29,
+    CHIP8_STATS_CLASS_FX30,
+    CHIP8_STATS_CLASS_FX33,
+    CHIP8_STATS_CLASS_FX55,
+    CHIP8_STATS_CLASS_FX65,
+    CHIP8_STATS_CLASS_FX75,
+    CHIP8_STATS_CLASS_FX85,
+    CHIP8_STATS_CLASS_INVALID,
+
+    CHIP8_STATS_CLASS_TOTAL
+} chip8_stats_class_id_t;
+
+/////////////////////////////////////////////////
+/// Typedef structures
+/////////////////////////////////////////////////
+
+typedef struct CHIP8_STATS_CLASS_STRUCT
+{
+    uint64_t    count;      /// Executions, filled by CHIP8_GetStats from the opcode counters
+    uint64_t    samples;    /// Executions that were timed
+    uint64_t    ticks;      /// Host ticks spent by the timed executions
+    uint64_t    histogram[CHIP8_STATS_BUCKETS];
+
+} chip8_stats_class_t;
+
+/// Counters of a statistics session. Ticks are rdtsc cycles on x86 and nanoseconds elsewhere.
+typedef struct CHIP8_STATS_STRUCT
+{
+    uint64_t            instructions;                       /// Filled by CHIP8_GetStats
+    uint64_t            opcodes[CHIP8_STATS_OPCODES];       /// Executions of every exact opcode
+    chip8_stats_class_t classes[CHIP8_STATS_CLASS_TOTAL];
+    uint32_t            sampleMask;                         /// Top sample_shift bits, an instruction is timed when they are 0 in the counter
+    uint32_t            sampleCounter;                      /// Advanced by CHIP8_SAMPLE_STEP per instruction
+
+} chip8_stats_t;
+
+/////////////////////////////////////////////////
+/// Public Prototype Functions
+/////////////////////////////////////////////////
+
+/// Starts counting every instruction chip executes and timing one in 2^sample_shift of them.
+/// Returns CHIP8_ERROR_NOT_SUPPORTED unless the core is built with CHIP8_STATS.
+/// The JIT and the idle loop detection step aside while a session is active so every instruction is seen.
+chip8_error_t CHIP8_StatsStart(chip8_t *chip, uint32_t sample_shift);
+chip8_error_t CHIP8_StatsStop(chip8_t *chip);
+
+/// Copies the counters of the running session into stats and fills the per class counts
+chip8_error_t CHIP8_GetStats(chip8_t *chip, chip8_stats_t *stats);
+
+/// One row per class and one per executed opcode: kind,name,count,samples,ticks,bucket_0..bucket_31
+chip8_error_t CHIP8_StatsWriteCsv(const chip8_stats_t *stats, const char *path);
+
+chip8_stats_class_id_t CHIP8_StatsClassify(uint16_t opcode);
+const char *CHIP8_StatsGetClassName(chip8_stats_class_id_t id);
+
+/////////////////////////////////////////////////
+/// Statistics hook
+/////////////////////////////////////////////////
+
+#ifdef CHIP8_STATS
+
+static inline uint64_t chip_stats_ticks(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/// Start time of a sampled instruction, 0 when this one is not timed
+static inline uint64_t chip_stats_begin(chip8_t *chip)
+{
+    chip8_stats_t *stats = chip->stats;
+    if( stats == NULL || ((stats->sampleCounter += CHIP8_SAMPLE_STEP) & stats->sampleMask) != 0 )
+    {
+        return 0;
+    }
+
+    return chip_stats_ticks();
+}
+
+static inline void chip_stats_end(chip8_t *chip, uint16_t opcode, uint64_t start)
+{
+    chip8_stats_t *stats = chip->stats;
+    if( stats == NULL )
+    {
+        return;
+    }
+
+    stats->opcodes[opcode]++;
+
+    if( start != 0 )
+    {
+        uint64_t cost = chip_stats_ticks() - start;
+        chip8_stats_class_t *cls = &stats->classes[CHIP8_StatsClassify(opcode)];
+        uint32_t bucket = 63u - (uint32_t)__builtin_clzll(cost | 1);
+
+        cls->samples++;
+        cls->ticks += cost;
+        cls->histogram[(bucket < CHIP8_STATS_BUCKETS) ? bucket : CHIP8_STATS_BUCKETS - 1]++;
+    }
+}
+
+/// Runs statement, the instruction that was executed is opcode (evaluated afterwards)
+#define CHIP8_STATS_EXECUTE(chip, opcode, statement)                   \
+    do                                                                  \
+    {                                                                   \
+        uint64_t chip_stats_start = chip_stats_begin(chip);             \
+        statement;                                                      \
+        chip_stats_end((chip), (opcode), chip_stats_start);             \
+    } while( 0 )
+
+#define CHIP8_STATS_ACTIVE(chip)    ((chip)->stats != NULL)
+
+#else
+
+#define CHIP8_STATS_EXECUTE(chip, opcode, statement)    statement
+#define CHIP8_STATS_ACTIVE(chip)                        false
+
+#endif
+
+#endif //CHIP8_CHIP8_STATS_H
@@ -0,0 +1,179 @@
+/////////////////////////////////////////////////
+/// Includes
+/////////////////////////////////////////////////
+
+#define _POSIX_C_SOURCE 200809L     /// nanosleep
+
+#include "CHIP8_Trace.h"
+#include <stdlib.h>
+#include <time.h>
+
+#ifdef CHIP8_TRACE
+
+/////////////////////////////////////////////////
+/// Defines
+/////////////////////////////////////////////////
+
+#define CHIP8_TRACE_IDLE_SLEEP_NS   1000000     /// Writer back-off when the ring is empty
+
+/////////////////////////////////////////////////
+/// Prototype static functions
+/////////////////////////////////////////////////
+
+static void *trace_writer_thread(void *arg);
+static uint32_t trace_drain(chip8_trace_t *trace);
+
+/////////////////////////////////////////////////
+/// Public functions
+/////////////////////////////////////////////////
+
+chip8_error_t CHIP8_TraceStart(chip8_t *chip, const char *path)
+{
+    chip8_trace_header_t header = { CHIP8_TRACE_MAGIC, CHIP8_TRACE_VERSION, sizeof(chip8_trace_record_t) };
+    chip8_trace_t *trace = NULL;
+
+    if( chip == NULL || path == NULL || chip->trace != NULL )
+    {
+        return CHIP8_ERROR_INIT;
+    }
+
+    trace = (chip8_trace_t *)calloc(1, sizeof(chip8_trace_t));
+    if( trace == NULL )
+    {
+        return CHIP8_ERROR_INIT;
+    }
+
+    trace->file = fopen(path, "wb");
+    if( trace->file == NULL )
+    {
+        free(trace);
+        return CHIP8_ERROR_INIT;
+    }
+
+    fwrite(&header, sizeof(header), 1, trace->file);
+
+    atomic_init(&trace->head, 0);
+    atomic_init(&trace->tail, 0);
+    atomic_init(&trace->stop, false);
+
+    if( pthread_create(&trace->writer, NULL, trace_writer_thread, trace) != 0 )
+    {
+        fclose(trace->file);
+        free(trace);
+        return CHIP8_ERROR_INIT;
+    }
+
+    chip->trace = trace;
+    return CHIP8_ERROR_NO;
+}
+
+chip8_error_t CHIP8_TraceStop(chip8_t *chip, uint64_t *dropped)
+{
+    chip8_trace_t *trace = chip->trace;
+    if( trace == NULL )
+    {
+        return CHIP8_ERROR_INIT;
+    }
+
+    /// Detach from the VM first so no record is produced while draining
+    chip->trace = NULL;
+
+    atomic_store_explicit(&trace->stop, true, memory_order_release);
+    pthread_join(trace->writer, NULL);
+
+    if( dropped != NULL )
+    {
+        (*dropped) = trace->dropped;
+    }
+
+    fclose(trace->file);
+    free(trace);
+
+    return CHIP8_ERROR_NO;
+}
+
+uint64_t CHIP8_TraceGetDropped(chip8_t *chip)
+{
+    return (chip->trace != NULL) ? chip->trace->dropped : 0;
+}
+
+/////////////////////////////////////////////////
+/// Static functions
+/////////////////////////////////////////////////
+
+static void *trace_writer_thread(void *arg)
+{
+    chip8_trace_t *trace = (chip8_trace_t *)arg;
+    const struct timespec idle = { 0, CHIP8_TRACE_IDLE_SLEEP_NS };
+
+    while( atomic_load_explicit(&trace->stop, memory_order_acquire) == false )
+    {
+        if( trace_drain(trace) == 0 )
+        {
+            nanosleep(&idle, NULL);
+        }
+    }
+
+    /// Flush what the VM produced before stopping
+    trace_drain(trace);
+    fflush(trace->file);
+
+    return NULL;
+}
+
+static uint32_t trace_drain(chip8_trace_t *trace)
+{
+    uint32_t tail = atomic_load_explicit(&trace->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&trace->head, memory_order_acquire);
+    uint32_t count = head - tail;
+
+    if( count == 0 )
+    {
+        return 0;
+    }
+
+    /// Write the pending span in at most two contiguous chunks
+    uint32_t start = tail & (CHIP8_TRACE_RING_SIZE - 1);
+    uint32_t first = CHIP8_TRACE_RING_SIZE - start;
+    if( first > count )
+    {
+        first = count;
+    }
+
+    fwrite(&trace->ring[start], sizeof(chip8_trace_record_t), first, trace->file);
+    if( count > first )
+    {
+        fwrite(&trace->ring[0], sizeof(chip8_trace_record_t), count - first, trace->file);
+    }
+
+    atomic_store_explicit(&trace->tail, head, memory_order_release);
+    return count;
+}
+
+#else
+
+/////////////////////////////////////////////////
+/// Public functions (tracing compiled out)
+/////////////////////////////////////////////////
+
+chip8_error_t CHIP8_TraceStart(chip8_t *chip, const char *path)
+{
+    (void)chip;
+    (void)path;
+    return CHIP8_ERROR_NOT_SUPPORTED;
+}
+
+chip8_error_t CHIP8_TraceStop(chip8_t *chip, uint64_t *dropped)
+{
+    (void)chip;
+    (void)dropped;
+    return CHIP8_ERROR_NOT_SUPPORTED;
+}
+
+uint64_t CHIP8_TraceGetDropped(chip8_t *chip)
+{
+    (void)chip;
+    return 0;
+}
+
+#endif
@@ -0,0 +1,145 @@
+#ifndef CHIP8_CHIP8_TRACE_H
+#define CHIP8_CHIP8_TRACE_H
+
+/////////////////////////////////////////////////
+/// Includes
+/////////////////////////////////////////////////
+
+#include "CHIP8.h"
+
+#ifdef CHIP8_TRACE
+#include <stdio.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#endif
+
+/////////////////////////////////////////////////
+/// Defines
+/////////////////////////////////////////////////
+
+#define CHIP8_TRACE_MAGIC           0x52543843  /// "C8TR"
+#define CHIP8_TRACE_VERSION         1
+#define CHIP8_TRACE_RING_SIZE       (1u << 16)  /// Records, must be a power of two
+#define CHIP8_TRACE_NO_REG          0xFF        /// Instruction did not write a V register
+
+/////////////////////////////////////////////////
+/// Typedef structures
+/////////////////////////////////////////////////
+
+/// Fixed size record written for every executed instruction, stored in host byte order
+typedef struct CHIP8_TRACE_RECORD_STRUCT
+{
+    uint16_t    PC;         /// Address of the instruction
+    uint16_t    opcode;
+    uint16_t    I;          /// I after execution
+    uint8_t     reg;        /// Written V register or CHIP8_TRACE_NO_REG
+    uint8_t     value;      /// Value of the written V register
+
+} chip8_trace_record_t;
+
+/// File header preceding the records
+typedef struct CHIP8_TRACE_HEADER_STRUCT
+{
+    uint32_t    magic;
+    uint16_t    version;
+    uint16_t    recordSize;
+
+} chip8_trace_header_t;
+
+#ifdef CHIP8_TRACE
+
+/// Single producer (the VM) single consumer (the writer thread) ring buffer
+typedef struct CHIP8_TRACE_STRUCT
+{
+    chip8_trace_record_t    ring[CHIP8_TRACE_RING_SIZE];
+    _Atomic uint32_t        head;       /// Next slot written by the VM
+    _Atomic uint32_t        tail;       /// Next slot drained by the writer
+    _Atomic bool            stop;
+    uint64_t                dropped;    /// Records lost because the ring was full
+    FILE                    *file;
+    pthread_t               writer;
+
+} chip8_trace_t;
+
+#endif
+
+/////////////////////////////////////////////////
+/// Public Prototype Functions
+/////////////////////////////////////////////////
+
+chip8_error_t CHIP8_TraceStart(chip8_t *chip, const char *path);
+/// Drains the pending records and closes the file, dropped (may be NULL) receives the records lost to a full ring
+chip8_error_t CHIP8_TraceStop(chip8_t *chip, uint64_t *dropped);
+uint64_t CHIP8_TraceGetDropped(chip8_t *chip);
+
+/////////////////////////////////////////////////
+/// Trace hook
+/////////////////////////////////////////////////
+
+#ifdef CHIP8_TRACE
+
+static inline void chip_trace_instruction(chip8_t *chip, uint16_t pc, uint16_t opcode)
+{
+    chip8_trace_t *trace = chip->trace;
+    if( trace == NULL )
+    {
+        return;
+    }
+
+    uint32_t head = atomic_load_explicit(&trace->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&trace->tail, memory_order_acquire);
+    if( head - tail >= CHIP8_TRACE_RING_SIZE )
+    {
+        /// Never block the VM, the writer fell behind
+        trace->dropped++;
+        return;
+    }
+
+    chip8_trace_record_t *rec = &trace->ring[head & (CHIP8_TRACE_RING_SIZE - 1)];
+    uint8_t x = (opcode & 0x0F00) >> 8;
+
+    rec->PC = pc;
+    rec->opcode = opcode;
+    rec->I = chip->registers.I;
+    rec->reg = CHIP8_TRACE_NO_REG;
+
+    switch( opcode >> 12 )
+    {
+        case 0x6:
+        case 0x7:
+        case 0x8:
+        case 0xC:
+            rec->reg = x;
+            break;
+
+        case 0xD:
+            rec->reg = 0xF;
+            break;
+
+        case 0xF:
+            if( (opcode & 0x00FF) == 0x07 || (opcode & 0x00FF) == 0x0A || (opcode & 0x00FF) == 0x65 || (opcode & 0x00FF) == 0x85 )
+            {
+                rec->reg = x;
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    rec->value = (rec->reg != CHIP8_TRACE_NO_REG) ? chip->registers.V[rec->reg] : 0;
+
+    atomic_store_explicit(&trace->head, head + 1, memory_order_release);
+}
+
+#define CHIP8_TRACE_INSTRUCTION(chip, pc, opcode)   chip_trace_instruction((chip), (pc), (opcode))
+#define CHIP8_TRACE_ACTIVE(chip)                    ((chip)->trace != NULL)
+
+#else
+
+#define CHIP8_TRACE_INSTRUCTION(chip, pc, opcode)   ((void)0)
+#define CHIP8_TRACE_ACTIVE(chip)                    false
+
+#endif
+
+#endif //CHIP8_CHIP8_TRACE_H
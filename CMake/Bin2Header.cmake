@@ -0,0 +1,58 @@
+# Concatenates binary files into a single static const byte array of a C header
+#
+# Usage: cmake -DINPUTS="a.bin;b.bin" -DNAME=array_name -DOUTPUT=out.h -P Bin2Header.cmake
+
+if (NOT INPUTS OR NOT NAME OR NOT OUTPUT)
+    message(FATAL_ERROR "Bin2Header: INPUTS, NAME and OUTPUT are required")
+endif()
+
+get_filename_component(guard ${OUTPUT} NAME_WE)
+string(TOUPPER "CHIP8_GENERATED_${guard}_H" guard)
+
+set(hex "")
+set(sources "")
+foreach(input ${INPUTS})
+    file(READ ${input} input_hex HEX)
+    string(APPEND hex "${input_hex}")
+
+    get_filename_component(input_name ${input} NAME)
+    list(APPEND sources ${input_name})
+endforeach()
+
+string(LENGTH "${hex}" hex_length)
+math(EXPR size "${hex_length} / 2")
+string(REPLACE ";" ", " sources "${sources}")
+
+# Sixteen bytes per line
+set(bytes "")
+set(offset 0)
+while (offset LESS hex_length)
+    string(SUBSTRING "${hex}" ${offset} 2 byte)
+    math(EXPR offset "${offset} + 2")
+    math(EXPR column "${offset} % 32")
+    if (offset EQUAL hex_length)
+        string(APPEND bytes "0x${byte}")
+    elseif (column EQUAL 0)
+        string(APPEND bytes "0x${byte},\n    ")
+    else()
+        string(APPEND bytes "0x${byte}, ")
+    endif()
+endwhile()
+
+set(content "/// Generated by CMake/Bin2Header.cmake, do not edit\n")
+string(APPEND content "#ifndef ${guard}\n#define ${guard}\n\n#include <stdint.h>\n\n")
+string(APPEND content "/// ${size} bytes from ${sources}\n")
+string(APPEND content "static const uint8_t ${NAME}[${size}] =\n{\n    ${bytes}\n};\n")
+string(APPEND content "\n#endif //${guard}\n")
+
+# Only rewrite the file when the data changed, an unchanged one is still touched
+# so it is newer than its inputs and the build does not run the generator again
+if (EXISTS ${OUTPUT})
+    file(READ ${OUTPUT} previous)
+    if (previous STREQUAL content)
+        file(TOUCH ${OUTPUT})
+        return()
+    endif()
+endif()
+
+file(WRITE ${OUTPUT} "${content}")
@@ -0,0 +1,111 @@
+#ifndef CHIP8_TESTS_CHIP8_TEST_H
+#define CHIP8_TESTS_CHIP8_TEST_H
+
+/////////////////////////////////////////////////
+/// Includes
+/////////////////////////////////////////////////
+
+#include <string.h>
+#include "CHIP8/CHIP8.h"
+
+/////////////////////////////////////////////////
+/// Defines
+/////////////////////////////////////////////////
+
+#define TEST_ROM_INSTRUCTIONS   64u
+#define TEST_SKIP               77      /// ctest SKIP_RETURN_CODE
+
+/// Opcode mixes of test_random_rom
+#define TEST_MIX_CHIP8          0x0u
+#define TEST_MIX_SCHIP          0x1u    /// Scrolling, resolution, DXY0 and the flag registers
+#define TEST_MIX_KEY_WAIT       0x2u    /// FX0A, for tests that press keys
+
+/////////////////////////////////////////////////
+/// Local variables
+/////////////////////////////////////////////////
+
+static uint64_t test_rng;
+
+/////////////////////////////////////////////////
+/// Static functions
+/////////////////////////////////////////////////
+
+static inline uint32_t test_random(uint32_t range)
+{
+    /// xorshift64*, the sequence is the same on every host
+    test_rng ^= test_rng >> 12;
+    test_rng ^= test_rng << 25;
+    test_rng ^= test_rng >> 27;
+
+    return (uint32_t)(((test_rng * 0x2545F4914F6CDD1DULL) >> 32) % range);
+}
+
+static inline uint16_t test_random_opcode(uint32_t mix)
+{
+    static const uint8_t alu[] = { 0x0, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7, 0xE };
+    static const uint8_t misc[] = { 0x0A, 0x07, 0x15, 0x18, 0x1E, 0x29, 0x30, 0x33, 0x55, 0x65, 0x75, 0x85 };
+    bool schip = (mix & TEST_MIX_SCHIP) != 0;
+    uint32_t misc_first = ((mix & TEST_MIX_KEY_WAIT) != 0) ? 0 : 1;
+    uint32_t misc_end = schip ? sizeof(misc) : sizeof(misc) - 2;
+    uint16_t x = (uint16_t)(test_random(16) << 8);
+    uint16_t y = (uint16_t)(test_random(16) << 4);
+    uint16_t nn = (uint16_t)test_random(256);
+    uint16_t target = (uint16_t)(CHIP8_PROGRAM_START_ADDR + test_random(TEST_ROM_INSTRUCTIONS) * 2);
+    uint32_t pick = test_random(100);
+
+    /// Weighted towards the instructions the fast paths translate, the rest exercises the interpreter fallback
+    if( pick < 10 ) return 0x6000 | x | nn;
+    if( pick < 20 ) return 0x7000 | x | nn;
+    if( pick < 45 ) return 0x8000 | x | y | alu[test_random(sizeof(alu))];
+    if( pick < 50 ) return 0x3000 | x | nn;
+    if( pick < 53 ) return 0x4000 | x | nn;
+    if( pick < 56 ) return 0x5000 | x | y;
+    if( pick < 59 ) return 0x9000 | x | y;
+    if( pick < 63 ) return 0x1000 | target;
+    if( pick < 67 ) return 0x2000 | target;
+    if( pick < 71 ) return 0x00EE;
+    if( pick < 73 ) return 0xA000 | (uint16_t)(0x300 + test_random(0x100));
+    if( pick < 74 ) return 0xA000 | target;     /// FX55 through it rewrites the program
+    if( pick < 76 ) return 0xB000 | (uint16_t)(CHIP8_PROGRAM_START_ADDR + test_random(32) * 2);
+    if( pick < 78 ) return 0xC000 | x | nn;
+    if( pick < 81 ) return 0xD000 | x | y | (uint16_t)(schip ? test_random(6) : 1 + test_random(5));
+    if( pick < 83 ) return 0xE09E | x;
+    if( pick < 85 ) return 0xE0A1 | x;
+    if( pick < 97 ) return 0xF000 | x | misc[misc_first + test_random(misc_end - misc_first)];
+    if( pick < 98 || schip == false ) return 0x00E0;
+    if( pick < 99 ) return 0x00C0 | (uint16_t)test_random(16);
+    return (test_random(2) == 0) ? 0x00FB : 0x00FC;
+}
+
+/// Fills rom with TEST_ROM_INSTRUCTIONS random instructions, the same ones for the same index on every host
+static inline void test_random_rom(uint8_t *rom, uint32_t index, uint32_t mix)
+{
+    test_rng = 0x9E3779B97F4A7C15ULL * (index + 1);
+
+    for(uint32_t ins = 0; ins < TEST_ROM_INSTRUCTIONS; ins++)
+    {
+        uint16_t opcode = test_random_opcode(mix);
+        rom[2 * ins] = (uint8_t)(opcode >> 8);
+        rom[2 * ins + 1] = (uint8_t)opcode;
+    }
+}
+
+/// Returns the first part of the VM state that differs between a and b, NULL when they match
+static inline const char *test_compare_vm(chip8_t *a, chip8_t *b)
+{
+    if( a->scheduler.cycles != b->scheduler.cycles ) return "executed cycles";
+    if( memcmp(&a->registers, &b->registers, sizeof(a->registers)) != 0 ) return "registers";
+    if( memcmp(a->stack, b->stack, sizeof(a->stack)) != 0 ) return "stack";
+    if( memcmp(a->memory, b->memory, sizeof(a->memory)) != 0 ) return "memory";
+    if( memcmp(a->flags, b->flags, sizeof(a->flags)) != 0 ) return "flag registers";
+    if( CHIP8_ScreenHash(a) != CHIP8_ScreenHash(b) ) return "screen";
+    if( a->rng != b->rng ) return "generator";
+    if( CHIP8_GetFault(a) != CHIP8_GetFault(b) ) return "fault";
+    if( a->keys != b->keys ) return "keys";
+    if( a->keyWait != b->keyWait ) return "key wait";
+    if( a->keyWait && (a->keyWaitReg != b->keyWaitReg || a->keyWaitPressed != b->keyWaitPressed) ) return "key wait state";
+
+    return NULL;
+}
+
+#endif //CHIP8_TESTS_CHIP8_TEST_H
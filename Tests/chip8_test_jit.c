@@ -0,0 +1,116 @@
+/////////////////////////////////////////////////
+/// Includes
+/////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "CHIP8/CHIP8.h"
+#include "chip8_test.h"
+
+/////////////////////////////////////////////////
+/// Defines
+/////////////////////////////////////////////////
+
+#define TEST_DEFAULT_ROMS       2000u
+
+/////////////////////////////////////////////////
+/// Local variables
+/////////////////////////////////////////////////
+
+static chip8_t reference;
+static chip8_t jit;
+static chip8_keymap_t keymap;
+
+/// Budgets that end runs inside, at and across translated blocks
+static const uint32_t test_budgets[] = { 1, 7, 100, 1000, 33, 5000, 2, 64, 65 };
+
+/////////////////////////////////////////////////
+/// Local functions
+/////////////////////////////////////////////////
+
+static bool test_compare(uint32_t rom, uint32_t step, uint32_t executed_ref, uint32_t executed_jit, uint32_t events_ref, uint32_t events_jit);
+
+/////////////////////////////////////////////////
+/// Main function
+/////////////////////////////////////////////////
+
+/// Runs random ROMs on the switch engine and the JIT with the same budgets and compares the whole VM after every run
+int main(int argc, char **argv)
+{
+    uint32_t roms = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : TEST_DEFAULT_ROMS;
+    uint8_t rom[TEST_ROM_INSTRUCTIONS * 2];
+
+    if( CHIP8_IsEngineSupported(CHIP8_ENGINE_JIT) == false )
+    {
+        puts("JIT not supported on this target, skipped");
+        return TEST_SKIP;
+    }
+
+    CHIP8_KeymapBuild(&keymap);
+
+    for(uint32_t itr = 0; itr < roms; itr++)
+    {
+        test_random_rom(rom, itr, TEST_MIX_SCHIP);
+
+        CHIP8_Init(&reference, &keymap, rom, sizeof(rom));
+        CHIP8_Init(&jit, &keymap, rom, sizeof(rom));
+        CHIP8_SetEngine(&reference, CHIP8_ENGINE_SWITCH);
+        if( CHIP8_SetEngine(&jit, CHIP8_ENGINE_JIT) != CHIP8_ERROR_NO )
+        {
+            printf("rom %u: JIT could not be created\n", itr);
+            return 1;
+        }
+
+        CHIP8_SetSeed(&reference, itr + 1);
+        CHIP8_SetSeed(&jit, itr + 1);
+        for(uint32_t reg = 0; reg < CHIP8_DATA_REGISTERS_TOTAL; reg++)
+        {
+            reference.registers.V[reg] = jit.registers.V[reg] = (uint8_t)test_random(256);
+        }
+
+        for(uint32_t step = 0; step < sizeof(test_budgets) / sizeof(test_budgets[0]); step++)
+        {
+            uint32_t events_ref = 0;
+            uint32_t events_jit = 0;
+            uint32_t executed_ref = CHIP8_RunUntil(&reference, test_budgets[step], CHIP8_EVENT_FAULT, &events_ref);
+            uint32_t executed_jit = CHIP8_RunUntil(&jit, test_budgets[step], CHIP8_EVENT_FAULT, &events_jit);
+
+            if( test_compare(itr, step, executed_ref, executed_jit, events_ref, events_jit) == false )
+            {
+                return 1;
+            }
+
+            /// Timers only move between runs, FX07 must see the same value on both sides
+            reference.registers.delayTimer++;
+            jit.registers.delayTimer++;
+        }
+
+        CHIP8_Deinit(&reference);
+        CHIP8_Deinit(&jit);
+    }
+
+    printf("%u ROMs, JIT matches the switch engine\n", roms);
+    return 0;
+}
+
+/////////////////////////////////////////////////
+/// Static functions
+/////////////////////////////////////////////////
+
+static bool test_compare(uint32_t rom, uint32_t step, uint32_t executed_ref, uint32_t executed_jit, uint32_t events_ref, uint32_t events_jit)
+{
+    const char *field = NULL;
+
+    if( executed_ref != executed_jit ) field = "executed cycles";
+    else if( events_ref != events_jit ) field = "events";
+    else field = test_compare_vm(&reference, &jit);
+
+    if( field == NULL )
+    {
+        return true;
+    }
+
+    printf("rom %u run %u: %s differ (switch PC %03X, JIT PC %03X, cycles %u/%u)\n", rom, step, field,
+           reference.registers.PC, jit.registers.PC, executed_ref, executed_jit);
+    return false;
+}
@@ -0,0 +1,194 @@
+/////////////////////////////////////////////////
+/// Includes
+/////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "CHIP8/CHIP8.h"
+#include "CHIP8/CHIP8_Lockstep.h"
+#include "chip8_test.h"
+
+/////////////////////////////////////////////////
+/// Defines
+/////////////////////////////////////////////////
+
+#define TEST_DEFAULT_ROMS       300u
+#define TEST_FRAMES             40u
+#define TEST_MAX_LANES          69u     /// Several vector groups and a partial one on every width
+
+/////////////////////////////////////////////////
+/// Local variables
+/////////////////////////////////////////////////
+
+static chip8_t scalar[TEST_MAX_LANES];
+static chip8_t extracted;
+static chip8_keymap_t keymap;
+static bool stopped[TEST_MAX_LANES];
+
+/////////////////////////////////////////////////
+/// Local functions
+/////////////////////////////////////////////////
+
+static bool test_rom(uint32_t index);
+static bool test_lane(chip8_lockstep_t *lockstep, uint32_t lane);
+static void test_set_keys(chip8_t *chip, uint16_t keys);
+
+/////////////////////////////////////////////////
+/// Main function
+/////////////////////////////////////////////////
+
+/// Runs random ROMs on many lockstep lanes with per lane input and compares every extracted lane with a scalar VM
+int main(int argc, char **argv)
+{
+    uint32_t roms = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : TEST_DEFAULT_ROMS;
+    chip8_lockstep_t *lockstep = NULL;
+    uint8_t probe = 0;
+
+    if( CHIP8_LockstepCreate(&lockstep, 1, NULL, &probe, sizeof(probe)) == CHIP8_ERROR_NOT_SUPPORTED )
+    {
+        puts("lockstep not supported on this target, skipped");
+        return TEST_SKIP;
+    }
+    CHIP8_LockstepDestroy(lockstep);
+
+    CHIP8_KeymapBuild(&keymap);
+
+    for(uint32_t itr = 0; itr < roms; itr++)
+    {
+        if( test_rom(itr) == false )
+        {
+            return 1;
+        }
+    }
+
+    printf("%u ROMs, every lockstep lane matches a scalar VM\n", roms);
+    return 0;
+}
+
+/////////////////////////////////////////////////
+/// Static functions
+/////////////////////////////////////////////////
+
+static bool test_rom(uint32_t index)
+{
+    uint8_t rom[TEST_ROM_INSTRUCTIONS * 2];
+    chip8_lockstep_t *lockstep = NULL;
+    bool passed = true;
+
+    test_random_rom(rom, index, TEST_MIX_KEY_WAIT);
+
+    uint32_t lanes = 1 + test_random(TEST_MAX_LANES);
+    uint32_t ips = 60 + test_random(3000);
+    chip8_config_t config = { .seed = index + 1 };
+
+    if( CHIP8_LockstepCreate(&lockstep, lanes, &config, rom, sizeof(rom)) != CHIP8_ERROR_NO )
+    {
+        printf("rom %u: %u lanes could not be created\n", index, lanes);
+        return false;
+    }
+    CHIP8_LockstepSetSpeed(lockstep, ips);
+
+    for(uint32_t lane = 0; lane < lanes; lane++)
+    {
+        chip8_config_t lane_config = { .seed = config.seed + lane };
+        CHIP8_InitWithConfig(&scalar[lane], &lane_config, &keymap, rom, sizeof(rom));
+        CHIP8_SetSpeed(&scalar[lane], ips);
+        stopped[lane] = false;
+    }
+
+    for(uint32_t frame = 0; frame < TEST_FRAMES && passed; frame++)
+    {
+        /// Lanes get different keys, so EX9E/EXA1 and FX0A split them apart
+        for(uint32_t lane = 0; lane < lanes; lane++)
+        {
+            if( test_random(3) == 0 )
+            {
+                uint16_t keys = (uint16_t)(test_random(0x10000) & test_random(0x10000));
+                test_set_keys(&scalar[lane], keys);
+                CHIP8_LockstepSetKeys(lockstep, lane, keys);
+            }
+        }
+
+        CHIP8_LockstepRunFrame(lockstep);
+
+        for(uint32_t lane = 0; lane < lanes && passed; lane++)
+        {
+            if( stopped[lane] == false )
+            {
+                passed = test_lane(lockstep, lane);
+            }
+        }
+
+        if( passed == false )
+        {
+            printf("rom %u: frame %u of %u lanes at %u ips\n", index, frame, lanes, ips);
+        }
+    }
+
+    for(uint32_t lane = 0; lane < lanes; lane++)
+    {
+        CHIP8_Deinit(&scalar[lane]);
+    }
+    CHIP8_LockstepDestroy(lockstep);
+
+    return passed;
+}
+
+static bool test_lane(chip8_lockstep_t *lockstep, uint32_t lane)
+{
+    chip8_t *chip = &scalar[lane];
+    chip8_error_t err = CHIP8_RunFrame(chip);
+
+    stopped[lane] = (err != CHIP8_ERROR_NO && err != CHIP8_ERROR_WAITING_FOR_KEY);
+
+    /// A rewritten program can reach SCHIP instructions, lanes stop there while the scalar VM runs them
+    if( CHIP8_LockstepGetStatus(lockstep, lane) == CHIP8_ERROR_INVALID_OPCODE )
+    {
+        stopped[lane] = true;
+        return true;
+    }
+
+    /// An extracted lane parked in FX0A is a VM in the key wait without a fault
+    if( CHIP8_GetFault(chip) == CHIP8_ERROR_WAITING_FOR_KEY )
+    {
+        chip->fault = CHIP8_ERROR_NO;
+    }
+
+    CHIP8_LockstepExtract(lockstep, lane, &extracted, &keymap);
+
+    const char *field = test_compare_vm(chip, &extracted);
+    if( field == NULL && CHIP8_LockstepScreenHash(lockstep, lane) != CHIP8_ScreenHash(chip) )
+    {
+        field = "lane screen hash";
+    }
+
+    if( field != NULL )
+    {
+        printf("lane %u: %s differ (scalar PC %03X, lane PC %03X)\n", lane, field, chip->registers.PC, extracted.registers.PC);
+    }
+
+    CHIP8_Deinit(&extracted);
+    return field == NULL;
+}
+
+static void test_set_keys(chip8_t *chip, uint16_t keys)
+{
+    uint16_t held = chip->keys;
+
+    /// Releases first in ascending order, the order CHIP8_LockstepSetKeys resolves a key wait in
+    for(uint32_t id = 0; id < CHIP8_KEY_ID_TOTAL; id++)
+    {
+        if( (held & (1u << id)) != 0 && (keys & (1u << id)) == 0 )
+        {
+            CHIP8_SetKeyId(chip, (chip8_key_id_t)id, false);
+        }
+    }
+
+    for(uint32_t id = 0; id < CHIP8_KEY_ID_TOTAL; id++)
+    {
+        if( (held & (1u << id)) == 0 && (keys & (1u << id)) != 0 )
+        {
+            CHIP8_SetKeyId(chip, (chip8_key_id_t)id, true);
+        }
+    }
+}
@@ -0,0 +1,148 @@
+/////////////////////////////////////////////////
+/// Includes
+/////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "CHIP8/CHIP8.h"
+#include "CHIP8/CHIP8_Movie.h"
+
+/////////////////////////////////////////////////
+/// Defines
+/////////////////////////////////////////////////
+
+#define TEST_DEFAULT_PATH   "chip8_test_movie.c8m"
+#define TEST_SEED           0x5EEDu
+#define TEST_IPS            700u
+#define TEST_FRAMES         300u
+
+/////////////////////////////////////////////////
+/// Local variables
+/////////////////////////////////////////////////
+
+static chip8_t recorded;
+static chip8_t replayed;
+static chip8_movie_playback_t movie;
+
+/// Draws random glyphs of the font, moving down while key 0 is held:
+///     200 RND V0,0F   202 LD F,V0   204 DRW V1,V2,5   206 ADD V1,8   208 SKNP V3   20A ADD V2,6   20C JP 200
+static const uint8_t test_rom[] =
+{
+    0xC0, 0x0F, 0xF0, 0x29, 0xD1, 0x25, 0x71, 0x08, 0xE3, 0xA1, 0x72, 0x06, 0x12, 0x00,
+};
+
+/////////////////////////////////////////////////
+/// Local functions
+/////////////////////////////////////////////////
+
+static bool test_record(const char *path);
+static bool test_replay(const char *path, chip8_engine_t engine);
+
+/////////////////////////////////////////////////
+/// Main function
+/////////////////////////////////////////////////
+
+/// Records a session with a custom font, mid-tick input and a speed change, then replays it on every engine
+int main(int argc, char **argv)
+{
+    const char *path = (argc > 1) ? argv[1] : TEST_DEFAULT_PATH;
+    bool passed = test_record(path);
+
+    for(uint32_t engine = 0; engine < CHIP8_ENGINE_TOTAL && passed; engine++)
+    {
+        if( CHIP8_IsEngineSupported((chip8_engine_t)engine) )
+        {
+            passed = test_replay(path, (chip8_engine_t)engine);
+        }
+    }
+
+    CHIP8_Deinit(&recorded);
+    remove(path);
+    return passed ? 0 : 1;
+}
+
+/////////////////////////////////////////////////
+/// Static functions
+/////////////////////////////////////////////////
+
+static bool test_record(const char *path)
+{
+    uint8_t font[CHIP8_FONT_SIZE];
+    uint32_t events = CHIP8_EVENT_NONE;
+
+    for(uint32_t itr = 0; itr < sizeof(font); itr++)
+    {
+        font[itr] = (uint8_t)(itr * 37 + 11);
+    }
+
+    chip8_config_t config = { .font = font, .seed = TEST_SEED };
+    CHIP8_InitWithConfig(&recorded, &config, NULL, (uint8_t *)test_rom, sizeof(test_rom));
+    CHIP8_SetSpeed(&recorded, TEST_IPS);
+
+    if( CHIP8_MovieRecordStart(&recorded, path, test_rom, sizeof(test_rom)) != CHIP8_ERROR_NO )
+    {
+        puts("recording could not start");
+        return false;
+    }
+
+    /// A frame driven host, then a host running bare instructions that reacts part way into a tick
+    for(uint32_t frame = 0; frame < TEST_FRAMES; frame++)
+    {
+        if( frame % 7 == 0 )
+        {
+            CHIP8_SetKeyId(&recorded, CHIP8_KEY_ID_0, (frame / 7) % 2 == 0);
+        }
+        CHIP8_RunFrame(&recorded);
+    }
+
+    if( CHIP8_SetSpeed(&recorded, CHIP8_IPS_UNBOUNDED) != CHIP8_ERROR_NOT_SUPPORTED )
+    {
+        puts("an unbounded speed was accepted while recording");
+        CHIP8_MovieRecordStop(&recorded);
+        return false;
+    }
+    CHIP8_SetSpeed(&recorded, TEST_IPS * 2);
+
+    for(uint32_t step = 0; step < TEST_FRAMES; step++)
+    {
+        CHIP8_RunUntil(&recorded, 13 + step % 5, CHIP8_EVENT_FAULT, &events);
+        CHIP8_SetKeyId(&recorded, CHIP8_KEY_ID_0, step % 3 == 0);
+    }
+
+    CHIP8_MovieRecordStop(&recorded);
+    return true;
+}
+
+static bool test_replay(const char *path, chip8_engine_t engine)
+{
+    chip8_movie_result_t result;
+
+    chip8_error_t err = CHIP8_MovieLoad(&movie, path);
+    if( err != CHIP8_ERROR_NO )
+    {
+        printf("movie could not be loaded (%d)\n", (int)err);
+        return false;
+    }
+
+    err = CHIP8_MovieReplay(&movie, &replayed, engine, &result);
+    CHIP8_MovieUnload(&movie);
+
+    bool same = (err == CHIP8_ERROR_NO && result.cycles == recorded.scheduler.cycles
+                 && CHIP8_ScreenHash(&replayed) == CHIP8_ScreenHash(&recorded)
+                 && memcmp(replayed.memory, recorded.memory, sizeof(recorded.memory)) == 0
+                 && replayed.rng == recorded.rng);
+
+    if( same == false )
+    {
+        printf("%s: replay error %d at tick %llu, cycles %llu of %llu\n", CHIP8_GetEngineName(engine), (int)err,
+               (unsigned long long)result.desyncTick, (unsigned long long)result.cycles, (unsigned long long)recorded.scheduler.cycles);
+    }
+    else
+    {
+        printf("%s: %u key events and %u checkpoints replayed\n", CHIP8_GetEngineName(engine), result.keyEvents, result.checkpoints);
+    }
+
+    CHIP8_Deinit(&replayed);
+    return same;
+}
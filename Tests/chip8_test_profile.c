@@ -0,0 +1,175 @@
+/////////////////////////////////////////////////
+/// Includes
+/////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "CHIP8/CHIP8.h"
+#include "CHIP8/CHIP8_Profile.h"
+#include "chip8_test.h"
+
+/////////////////////////////////////////////////
+/// Defines
+/////////////////////////////////////////////////
+
+#define TEST_DEFAULT_ROMS       2000u
+#define TEST_FRAMES             40u
+#define TEST_IPS                6000u
+#define TEST_SUB_ADDR           0x20C   /// Subroutine of the synthetic ROM
+
+/////////////////////////////////////////////////
+/// Local variables
+/////////////////////////////////////////////////
+
+static chip8_t reference;
+static chip8_t profiled;
+static chip8_profile_t samples;
+
+/// Calls the subroutine three times then exits:
+///     200 LD V0,3   202 CALL 20C   204 ADD V0,FF   206 SE V0,0   208 JP 202   20A EXIT
+///     20C LD V1,1   20E RET
+static const uint8_t test_synthetic_rom[] =
+{
+    0x60, 0x03, 0x22, 0x0C, 0x70, 0xFF, 0x30, 0x00, 0x12, 0x02, 0x00, 0xFD,
+    0x61, 0x01, 0x00, 0xEE,
+};
+
+/// Samples per address in exact mode, EXIT is sampled once before it stops the run
+static const uint16_t test_synthetic_pc[][2] =
+{
+    { 0x200, 1 }, { 0x202, 3 }, { 0x204, 3 }, { 0x206, 3 }, { 0x208, 2 }, { 0x20A, 1 },
+    { 0x20C, 3 }, { 0x20E, 3 },
+};
+
+/// Periods tried on the random ROMs, exact mode cuts every run into single instruction slices
+static const uint32_t test_periods[] = { CHIP8_PROFILE_EXACT, 7, CHIP8_PROFILE_DEFAULT_PERIOD };
+
+/////////////////////////////////////////////////
+/// Local functions
+/////////////////////////////////////////////////
+
+static bool test_synthetic(chip8_engine_t engine);
+static bool test_identical(chip8_engine_t engine, uint32_t roms);
+
+/////////////////////////////////////////////////
+/// Main function
+/////////////////////////////////////////////////
+
+/// Checks the exact sample counts of a known ROM and that profiling never changes what a ROM does, on every engine
+int main(int argc, char **argv)
+{
+    uint32_t roms = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : TEST_DEFAULT_ROMS;
+
+    for(uint32_t engine = 0; engine < CHIP8_ENGINE_TOTAL; engine++)
+    {
+        if( CHIP8_IsEngineSupported((chip8_engine_t)engine) == false )
+        {
+            continue;
+        }
+
+        if( test_synthetic((chip8_engine_t)engine) == false || test_identical((chip8_engine_t)engine, roms) == false )
+        {
+            return 1;
+        }
+
+        printf("%s: profile counts exact, %u ROMs unchanged by profiling\n", CHIP8_GetEngineName((chip8_engine_t)engine), roms);
+    }
+
+    return 0;
+}
+
+/////////////////////////////////////////////////
+/// Static functions
+/////////////////////////////////////////////////
+
+static bool test_synthetic(chip8_engine_t engine)
+{
+    uint32_t events = CHIP8_EVENT_NONE;
+    uint64_t total = 0;
+    const char *field = NULL;
+
+    CHIP8_Init(&profiled, NULL, (uint8_t *)test_synthetic_rom, sizeof(test_synthetic_rom));
+    CHIP8_SetEngine(&profiled, engine);
+    CHIP8_ProfileStart(&profiled, CHIP8_PROFILE_EXACT);
+    CHIP8_RunUntil(&profiled, 1000, CHIP8_EVENT_FAULT, &events);
+    CHIP8_GetProfile(&profiled, &samples);
+
+    for(uint32_t itr = 0; itr < sizeof(test_synthetic_pc) / sizeof(test_synthetic_pc[0]); itr++)
+    {
+        if( samples.pc[test_synthetic_pc[itr][0]] != test_synthetic_pc[itr][1] )
+        {
+            printf("%s: %03X sampled %llu times, expected %u\n", CHIP8_GetEngineName(engine), test_synthetic_pc[itr][0],
+                   (unsigned long long)samples.pc[test_synthetic_pc[itr][0]], test_synthetic_pc[itr][1]);
+            CHIP8_Deinit(&profiled);
+            return false;
+        }
+        total += test_synthetic_pc[itr][1];
+    }
+
+    if( CHIP8_GetFault(&profiled) != CHIP8_ERROR_EXIT ) field = "exit";
+    else if( samples.samples != total ) field = "sample total";
+    else if( samples.functions[TEST_SUB_ADDR].exclusive != 6 || samples.functions[TEST_SUB_ADDR].inclusive != 6 ) field = "subroutine";
+    else if( samples.functions[CHIP8_PROGRAM_START_ADDR].exclusive != total - 6 ) field = "entry point exclusive";
+    else if( samples.functions[CHIP8_PROGRAM_START_ADDR].inclusive != total ) field = "entry point inclusive";
+    else if( samples.stackCount != 2 || samples.droppedStacks != 0 ) field = "call stacks";
+
+    CHIP8_Deinit(&profiled);
+
+    if( field != NULL )
+    {
+        printf("%s: synthetic ROM %s differ\n", CHIP8_GetEngineName(engine), field);
+        return false;
+    }
+
+    return true;
+}
+
+static bool test_identical(chip8_engine_t engine, uint32_t roms)
+{
+    uint8_t rom[TEST_ROM_INSTRUCTIONS * 2];
+
+    for(uint32_t itr = 0; itr < roms; itr++)
+    {
+        test_random_rom(rom, itr, TEST_MIX_SCHIP | TEST_MIX_KEY_WAIT);
+
+        CHIP8_Init(&reference, NULL, rom, sizeof(rom));
+        CHIP8_Init(&profiled, NULL, rom, sizeof(rom));
+        CHIP8_SetEngine(&reference, engine);
+        CHIP8_SetEngine(&profiled, engine);
+        CHIP8_SetSeed(&reference, itr + 1);
+        CHIP8_SetSeed(&profiled, itr + 1);
+        CHIP8_SetSpeed(&reference, TEST_IPS);
+        CHIP8_SetSpeed(&profiled, TEST_IPS);
+        CHIP8_ProfileStart(&profiled, test_periods[itr % (sizeof(test_periods) / sizeof(test_periods[0]))]);
+
+        /// Frames go through the scheduler, so the idle probe and the tick budget are covered as well
+        for(uint32_t frame = 0; frame < TEST_FRAMES; frame++)
+        {
+            chip8_key_id_t key = (chip8_key_id_t)test_random(CHIP8_KEY_ID_TOTAL);
+            bool state = test_random(2) != 0;
+
+            CHIP8_SetKeyId(&reference, key, state);
+            CHIP8_SetKeyId(&profiled, key, state);
+            CHIP8_RunFrame(&reference);
+            CHIP8_RunFrame(&profiled);
+        }
+
+        const char *field = test_compare_vm(&reference, &profiled);
+
+        if( field != NULL )
+        {
+            printf("%s: rom %u %s differ with the profiler attached (PC %03X, profiled PC %03X)\n", CHIP8_GetEngineName(engine),
+                   itr, field, reference.registers.PC, profiled.registers.PC);
+        }
+
+        CHIP8_Deinit(&reference);
+        CHIP8_Deinit(&profiled);
+
+        if( field != NULL )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,468 @@
+/////////////////////////////////////////////////
+/// Includes
+/////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "CHIP8/CHIP8.h"
+#include "CHIP8/CHIP8_Batch.h"
+#include "CHIP8/CHIP8_Lockstep.h"
+#include "CHIP8/CHIP8_Movie.h"
+#include "CHIP8/CHIP8_Stats.h"
+#include "CHIP8/CHIP8_Profile.h"
+#include "chip8_tools.h"
+
+/////////////////////////////////////////////////
+/// Defines
+/////////////////////////////////////////////////
+
+#define RUN_DEFAULT_CYCLES  10000000u
+#define RUN_CHUNK_CYCLES    1000000u
+#define RUN_BATCH_FRAMES    600u        /// Ten emulated seconds per instance when --frames is not given
+
+/////////////////////////////////////////////////
+/// Local variables
+/////////////////////////////////////////////////
+
+static chip8_t chip;
+static chip8_keymap_t keymap;
+
+/////////////////////////////////////////////////
+/// Local functions
+/////////////////////////////////////////////////
+
+static void print_usage(const char *name);
+static int run_batch(const chip8_config_t *config, chip8_engine_t engine, uint32_t ips, uint8_t *rom, uint32_t rom_size,
+                     uint32_t instances, uint32_t threads, uint32_t frames);
+static int run_lockstep(const chip8_config_t *config, uint32_t ips, uint8_t *rom, uint32_t rom_size, uint32_t lanes, uint32_t frames);
+static int run_replay(const char *path, chip8_engine_t engine);
+
+/////////////////////////////////////////////////
+/// Main function
+/////////////////////////////////////////////////
+
+int main(int argc, char **argv)
+{
+    chip8_config_t config = { 0 };
+    chip8_engine_t engine = CHIP8_ENGINE_TOTAL;
+    uint64_t cycles = RUN_DEFAULT_CYCLES;
+    uint64_t frames = 0;
+    uint32_t ips = CHIP8_DEFAULT_IPS;
+    uint32_t instances = 0;
+    uint32_t threads = CHIP8_BATCH_AUTO_THREADS;
+    bool lockstep = false;
+    const char *record = NULL;
+    const char *replay = NULL;
+    const char *stats = NULL;
+    const char *profile = NULL;
+    const char *heatmap = NULL;
+    uint32_t profile_period = CHIP8_PROFILE_DEFAULT_PERIOD;
+    int first_option = 2;
+
+    if( argc < 2 )
+    {
+        print_usage(argv[0]);
+        return -1;
+    }
+
+    /// A movie carries its own ROM
+    if( strcmp(argv[1], "--replay") == 0 )
+    {
+        if( argc < 3 )
+        {
+            print_usage(argv[0]);
+            return -1;
+        }
+        replay = argv[2];
+        first_option = 3;
+    }
+
+    for(int itr = first_option; itr < argc; itr++)
+    {
+        const char *value = (itr + 1 < argc) ? argv[itr + 1] : NULL;
+
+        if( strcmp(argv[itr], "--lockstep") == 0 )
+        {
+            lockstep = true;
+            continue;
+        }
+        else if( value == NULL )
+        {
+            print_usage(argv[0]);
+            return -1;
+        }
+        else if( strcmp(argv[itr], "--cycles") == 0 )
+        {
+            cycles = strtoull(value, NULL, 10);
+            frames = 0;
+        }
+        else if( strcmp(argv[itr], "--frames") == 0 )
+        {
+            frames = strtoull(value, NULL, 10);
+        }
+        else if( strcmp(argv[itr], "--ips") == 0 )
+        {
+            ips = (uint32_t)strtoul(value, NULL, 10);
+        }
+        else if( strcmp(argv[itr], "--seed") == 0 )
+        {
+            config.seed = strtoull(value, NULL, 0);
+        }
+        else if( strcmp(argv[itr], "--instances") == 0 )
+        {
+            instances = (uint32_t)strtoul(value, NULL, 10);
+        }
+        else if( strcmp(argv[itr], "--threads") == 0 )
+        {
+            threads = (uint32_t)strtoul(value, NULL, 10);
+        }
+        else if( strcmp(argv[itr], "--record") == 0 )
+        {
+            record = value;
+        }
+        else if( strcmp(argv[itr], "--stats") == 0 )
+        {
+            stats = value;
+        }
+        else if( strcmp(argv[itr], "--profile") == 0 )
+        {
+            profile = value;
+        }
+        else if( strcmp(argv[itr], "--heatmap") == 0 )
+        {
+            heatmap = value;
+        }
+        else if( strcmp(argv[itr], "--profile-period") == 0 )
+        {
+            profile_period = (uint32_t)strtoul(value, NULL, 10);
+        }
+        else if( strcmp(argv[itr], "--engine") == 0 )
+        {
+            if( tools_parse_engine(value, &engine) == false )
+            {
+                printf("Unsupported engine: %s\n", value);
+                return -1;
+            }
+        }
+        else
+        {
+            print_usage(argv[0]);
+            return -1;
+        }
+
+        itr++;
+    }
+
+    if( replay != NULL )
+    {
+        return run_replay(replay, engine);
+    }
+
+    uint32_t rom_size = 0;
+    uint8_t *rom = tools_load_rom(argv[1], &rom_size);
+    if( rom == NULL )
+    {
+        puts("Failed to load file");
+        return -1;
+    }
+
+    if( instances > 0 && lockstep )
+    {
+        int ret = run_lockstep(&config, ips, rom, rom_size, instances, (frames > 0) ? (uint32_t)frames : RUN_BATCH_FRAMES);
+        free(rom);
+        return ret;
+    }
+    else if( instances > 0 )
+    {
+        int ret = run_batch(&config, engine, ips, rom, rom_size, instances, threads, (frames > 0) ? (uint32_t)frames : RUN_BATCH_FRAMES);
+        free(rom);
+        return ret;
+    }
+
+    if( CHIP8_InitWithConfig(&chip, &config, &keymap, rom, rom_size) != CHIP8_ERROR_NO )
+    {
+        puts("Failed to init CHIP8");
+        free(rom);
+        return -1;
+    }
+
+    if( engine != CHIP8_ENGINE_TOTAL )
+    {
+        CHIP8_SetEngine(&chip, engine);
+    }
+    CHIP8_SetSpeed(&chip, ips);
+
+    /// Stopped by CHIP8_Deinit, a run without input still gives a regression movie of screen hashes
+    if( record != NULL && CHIP8_MovieRecordStart(&chip, record, rom, rom_size) != CHIP8_ERROR_NO )
+    {
+        puts("Failed to start recording (a bounded --ips is required)");
+        free(rom);
+        CHIP8_Deinit(&chip);
+        return -1;
+    }
+    free(rom);
+
+    if( stats != NULL && CHIP8_StatsStart(&chip, CHIP8_STATS_DEFAULT_SAMPLE_SHIFT) != CHIP8_ERROR_NO )
+    {
+        puts("Statistics not supported by this build (configure with -DCHIP8_STATS=ON)");
+        CHIP8_Deinit(&chip);
+        return -1;
+    }
+
+    if( (profile != NULL || heatmap != NULL) && CHIP8_ProfileStart(&chip, profile_period) != CHIP8_ERROR_NO )
+    {
+        puts("Failed to start the profiler (--profile-period must be at least 1)");
+        CHIP8_Deinit(&chip);
+        return -1;
+    }
+
+    uint64_t executed = 0;
+    chip8_error_t err = CHIP8_ERROR_NO;
+    double start = tools_get_time_s();
+
+    if( frames > 0 )
+    {
+        /// Emulated 60 Hz frames back to back, timers tick once per frame
+        err = CHIP8_RunFrames(&chip, frames);
+        executed = chip.scheduler.cycles;
+    }
+    else
+    {
+        uint32_t events = CHIP8_EVENT_NONE;
+        while( executed < cycles && (events & (CHIP8_EVENT_FAULT | CHIP8_EVENT_KEY_WAIT)) == 0 )
+        {
+            uint64_t chunk = cycles - executed;
+            executed += CHIP8_RunUntil(&chip, chunk > RUN_CHUNK_CYCLES ? RUN_CHUNK_CYCLES : (uint32_t)chunk, CHIP8_EVENT_FAULT, &events);
+        }
+
+        if( (events & CHIP8_EVENT_FAULT) != 0 )
+        {
+            err = CHIP8_GetFault(&chip);
+        }
+        else if( CHIP8_IsWaitingForKey(&chip) )
+        {
+            err = CHIP8_ERROR_WAITING_FOR_KEY;
+        }
+    }
+
+    double elapsed = tools_get_time_s() - start;
+
+    printf("engine: %s\n", CHIP8_GetEngineName(chip.engine));
+    printf("cycles: %llu\n", (unsigned long long)executed);
+    printf("idle:   %llu\n", (unsigned long long)chip.scheduler.idleCycles);
+    printf("hash:   %016llx\n", (unsigned long long)CHIP8_ScreenHash(&chip));
+    printf("ips:    %.0f\n", (elapsed > 0.0) ? (double)executed / elapsed : 0.0);
+
+    /// Nobody can press a key here, a ROM that waits for one has simply finished
+    if( err == CHIP8_ERROR_WAITING_FOR_KEY )
+    {
+        printf("waiting for key at PC %03X\n", chip.registers.PC);
+        err = CHIP8_ERROR_NO;
+    }
+    else if( err == CHIP8_ERROR_EXIT )
+    {
+        printf("exited at PC %03X\n", chip.registers.PC);
+        err = CHIP8_ERROR_NO;
+    }
+    else if( err != CHIP8_ERROR_NO )
+    {
+        printf("fault:  %d at PC %03X\n", (int)err, chip.registers.PC);
+    }
+
+    if( stats != NULL )
+    {
+        /// The exact opcode table is too large for the stack
+        chip8_stats_t *counters = (chip8_stats_t *)malloc(sizeof(chip8_stats_t));
+        if( counters == NULL || CHIP8_GetStats(&chip, counters) != CHIP8_ERROR_NO || CHIP8_StatsWriteCsv(counters, stats) != CHIP8_ERROR_NO )
+        {
+            printf("Failed to write %s\n", stats);
+            err = CHIP8_ERROR_INIT;
+        }
+        free(counters);
+    }
+
+    if( profile != NULL || heatmap != NULL )
+    {
+        chip8_profile_t *samples = (chip8_profile_t *)malloc(sizeof(chip8_profile_t));
+        if( samples == NULL || CHIP8_GetProfile(&chip, samples) != CHIP8_ERROR_NO )
+        {
+            puts("Failed to read the profile");
+            err = CHIP8_ERROR_INIT;
+        }
+        else
+        {
+            printf("samples: %llu\n", (unsigned long long)samples->samples);
+
+            if( profile != NULL && CHIP8_ProfileWriteFolded(samples, profile) != CHIP8_ERROR_NO )
+            {
+                printf("Failed to write %s\n", profile);
+                err = CHIP8_ERROR_INIT;
+            }
+
+            if( heatmap != NULL && CHIP8_ProfileWriteCsv(samples, &chip, heatmap) != CHIP8_ERROR_NO )
+            {
+                printf("Failed to write %s\n", heatmap);
+                err = CHIP8_ERROR_INIT;
+            }
+        }
+        free(samples);
+    }
+
+    CHIP8_Deinit(&chip);
+
+    return (err == CHIP8_ERROR_NO) ? 0 : 1;
+}
+
+static void print_usage(const char *name)
+{
+    printf("Usage: %s <rom> [--cycles N | --frames N] [--ips N] [--engine NAME] [--seed N] [--record MOVIE] [--stats CSV]\n"
+           "                [--profile FOLDED] [--heatmap CSV] [--profile-period N (1 samples every instruction)]\n"
+           "       %s <rom> --instances N [--threads N | --lockstep] [--frames N] [--ips N] [--engine NAME] [--seed N]\n"
+           "       %s --replay MOVIE [--engine NAME]\n", name, name, name);
+}
+
+static int run_batch(const chip8_config_t *config, chip8_engine_t engine, uint32_t ips, uint8_t *rom, uint32_t rom_size,
+                     uint32_t instances, uint32_t threads, uint32_t frames)
+{
+    chip8_batch_t *batch = NULL;
+    chip8_config_t instance_config = (*config);
+
+    if( CHIP8_BatchCreate(&batch, instances, threads) != CHIP8_ERROR_NO )
+    {
+        puts("Failed to create batch");
+        return -1;
+    }
+
+    for(uint32_t itr = 0; itr < instances; itr++)
+    {
+        /// Every instance gets its own random stream, instance 0 keeps the requested seed
+        instance_config.seed = config->seed + itr;
+
+        if( CHIP8_BatchInitInstance(batch, itr, &instance_config, &keymap, rom, rom_size) != CHIP8_ERROR_NO )
+        {
+            puts("Failed to init CHIP8");
+            CHIP8_BatchDestroy(batch);
+            return -1;
+        }
+
+        chip8_t *instance = CHIP8_BatchGetInstance(batch, itr);
+        if( engine != CHIP8_ENGINE_TOTAL )
+        {
+            CHIP8_SetEngine(instance, engine);
+        }
+        CHIP8_SetSpeed(instance, ips);
+    }
+
+    double start = tools_get_time_s();
+    CHIP8_BatchRunFrames(batch, frames);
+    double elapsed = tools_get_time_s() - start;
+
+    uint64_t executed = 0;
+    uint64_t idle = 0;
+    uint32_t faulted = 0;
+    for(uint32_t itr = 0; itr < instances; itr++)
+    {
+        executed += CHIP8_BatchGetInstance(batch, itr)->scheduler.cycles;
+        idle += CHIP8_BatchGetInstance(batch, itr)->scheduler.idleCycles;
+        chip8_error_t status = CHIP8_BatchGetStatus(batch, itr);
+        faulted += (status != CHIP8_ERROR_NO && status != CHIP8_ERROR_WAITING_FOR_KEY && status != CHIP8_ERROR_EXIT) ? 1 : 0;
+    }
+
+    printf("engine:    %s\n", CHIP8_GetEngineName(CHIP8_BatchGetInstance(batch, 0)->engine));
+    printf("instances: %u\n", instances);
+    printf("threads:   %u\n", batch->threads);
+    printf("cycles:    %llu\n", (unsigned long long)executed);
+    printf("idle:      %llu\n", (unsigned long long)idle);
+    printf("hash:      %016llx\n", (unsigned long long)CHIP8_ScreenHash(CHIP8_BatchGetInstance(batch, 0)));
+    printf("ips:       %.0f\n", (elapsed > 0.0) ? (double)executed / elapsed : 0.0);
+    printf("faulted:   %u\n", faulted);
+
+    CHIP8_BatchDestroy(batch);
+
+    return (faulted == 0) ? 0 : 1;
+}
+
+static int run_lockstep(const chip8_config_t *config, uint32_t ips, uint8_t *rom, uint32_t rom_size, uint32_t lanes, uint32_t frames)
+{
+    chip8_lockstep_t *lockstep = NULL;
+
+    /// Lane n is seeded like batch instance n, so both modes print the same hash
+    chip8_error_t err = CHIP8_LockstepCreate(&lockstep, lanes, config, rom, rom_size);
+    if( err != CHIP8_ERROR_NO )
+    {
+        puts((err == CHIP8_ERROR_NOT_SUPPORTED) ? "Lockstep engine not supported by this build" : "Failed to create lockstep");
+        return -1;
+    }
+
+    if( CHIP8_LockstepSetSpeed(lockstep, ips) != CHIP8_ERROR_NO )
+    {
+        puts("Lockstep needs a bounded --ips");
+        CHIP8_LockstepDestroy(lockstep);
+        return -1;
+    }
+
+    double start = tools_get_time_s();
+    for(uint32_t frame = 0; frame < frames; frame++)
+    {
+        CHIP8_LockstepRunFrame(lockstep);
+    }
+    double elapsed = tools_get_time_s() - start;
+
+    uint32_t faulted = 0;
+    for(uint32_t itr = 0; itr < lanes; itr++)
+    {
+        chip8_error_t status = CHIP8_LockstepGetStatus(lockstep, itr);
+        faulted += (status != CHIP8_ERROR_NO && status != CHIP8_ERROR_WAITING_FOR_KEY && status != CHIP8_ERROR_EXIT) ? 1 : 0;
+    }
+
+    printf("engine:    lockstep x%u\n", (uint32_t)CHIP8_LOCKSTEP_WIDTH);
+    printf("instances: %u\n", lanes);
+    printf("cycles:    %llu\n", (unsigned long long)lockstep->laneCycles);
+    printf("hash:      %016llx\n", (unsigned long long)CHIP8_LockstepScreenHash(lockstep, 0));
+    printf("ips:       %.0f\n", (elapsed > 0.0) ? (double)lockstep->laneCycles / elapsed : 0.0);
+    printf("occupancy: %.2f\n", (lockstep->steps > 0) ? (double)lockstep->laneCycles / (double)lockstep->steps : 0.0);
+    printf("faulted:   %u\n", faulted);
+
+    CHIP8_LockstepDestroy(lockstep);
+
+    return (faulted == 0) ? 0 : 1;
+}
+
+static int run_replay(const char *path, chip8_engine_t engine)
+{
+    chip8_movie_playback_t movie;
+    chip8_movie_result_t result;
+
+    if( CHIP8_MovieLoad(&movie, path) != CHIP8_ERROR_NO )
+    {
+        puts("Failed to load movie");
+        return -1;
+    }
+
+    double start = tools_get_time_s();
+    chip8_error_t err = CHIP8_MovieReplay(&movie, &chip, engine, &result);
+    double elapsed = tools_get_time_s() - start;
+
+    printf("engine:      %s\n", CHIP8_GetEngineName(chip.engine));
+    printf("ticks:       %llu (%.1f s emulated)\n", (unsigned long long)result.ticks, (double)result.ticks / CHIP8_TIMER_FREQUENCY_HZ);
+    printf("cycles:      %llu\n", (unsigned long long)result.cycles);
+    printf("keys:        %u\n", result.keyEvents);
+    printf("checkpoints: %u\n", result.checkpoints);
+    printf("time:        %.3f s\n", elapsed);
+
+    if( err == CHIP8_ERROR_DESYNC )
+    {
+        printf("DESYNC at tick %llu: expected %016llx got %016llx\n", (unsigned long long)result.desyncTick,
+               (unsigned long long)result.expected, (unsigned long long)result.actual);
+    }
+    else if( err != CHIP8_ERROR_NO )
+    {
+        printf("replay failed: %d\n", (int)err);
+    }
+
+    CHIP8_Deinit(&chip);
+    CHIP8_MovieUnload(&movie);
+
+    return (err == CHIP8_ERROR_NO) ? 0 : 1;
+}
@@ -0,0 +1,58 @@
+/////////////////////////////////////////////////
+/// Includes
+/////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "chip8_tools.h"
+
+/////////////////////////////////////////////////
+/// Public functions
+/////////////////////////////////////////////////
+
+bool tools_parse_engine(const char *name, chip8_engine_t *engine)
+{
+    for(uint32_t itr = 0; itr < CHIP8_ENGINE_TOTAL; itr++)
+    {
+        if( strcmp(name, CHIP8_GetEngineName((chip8_engine_t)itr)) == 0 && CHIP8_IsEngineSupported((chip8_engine_t)itr) )
+        {
+            (*engine) = (chip8_engine_t)itr;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+uint8_t *tools_load_rom(const char *filename, uint32_t *size)
+{
+    FILE *f = fopen(filename, "rb");
+    if( !f )
+    {
+        return NULL;
+    }
+
+    fseek(f, 0, SEEK_END);
+    (*size) = (uint32_t)ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    uint8_t *buff = (uint8_t *)malloc(*size);
+    if( buff != NULL && fread(buff, *size, 1, f) != 1 )
+    {
+        free(buff);
+        buff = NULL;
+    }
+
+    fclose(f);
+    return buff;
+}
+
+double tools_get_time_s(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
@@ -0,0 +1,25 @@
+#ifndef CHIP8_TOOLS_CHIP8_TOOLS_H
+#define CHIP8_TOOLS_CHIP8_TOOLS_H
+
+/////////////////////////////////////////////////
+/// Includes
+/////////////////////////////////////////////////
+
+#include "CHIP8/CHIP8.h"
+
+/////////////////////////////////////////////////
+/// Public Prototype Functions
+/////////////////////////////////////////////////
+
+/// Helpers shared by the command line tools
+
+/// Finds a supported engine by its CHIP8_GetEngineName name
+bool tools_parse_engine(const char *name, chip8_engine_t *engine);
+
+/// Reads a whole file into a malloc'd buffer, NULL when it cannot be read
+uint8_t *tools_load_rom(const char *filename, uint32_t *size);
+
+/// Wall clock in seconds
+double tools_get_time_s(void);
+
+#endif //CHIP8_TOOLS_CHIP8_TOOLS_H
@@ -5,8 +5,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include "raylib.h"
 #include "CHIP8/CHIP8.h"
+#include "CHIP8/CHIP8_Render.h"
+#include "CHIP8/CHIP8_Rewind.h"
+#include "CHIP8/CHIP8_Movie.h"
 
 #ifdef RAYGUI_IMPLEMENTATION
 #include "raygui.h"
@@ -18,25 +22,19 @@
 
 #define MAIN_WINDOW_NAME    "CHIP8"
 #define MAIN_WINDOW_SCALE_FACTOR    10
-#define MAIN_WINDOW_WIDTH   (CHIP8_WIDTH_SCREEN * MAIN_WINDOW_SCALE_FACTOR)
-#define MAIN_WINDOW_HEIGHT  (CHIP8_HEIGHT_SCREEN * MAIN_WINDOW_SCALE_FACTOR)
+#define MAIN_WINDOW_WIDTH   (CHIP8_LORES_WIDTH_SCREEN * MAIN_WINDOW_SCALE_FACTOR)  /// The SCHIP screen is scaled into the same window
+#define MAIN_WINDOW_HEIGHT  (CHIP8_LORES_HEIGHT_SCREEN * MAIN_WINDOW_SCALE_FACTOR)
 #define MAIN_WINDOW_FPS     60
-
-/////////////////////////////////////////////////
-/// Local variables
-/////////////////////////////////////////////////
-
-static chip8_keymap_t keymap;
-static uint8_t *buff;
-static uint32_t size;
+#define MAIN_REWIND_KEY     KEY_BACKSPACE   /// Held down to step back one frame per displayed frame
 
 /////////////////////////////////////////////////
 /// Local functions
 /////////////////////////////////////////////////
 
-static bool b_load_file(const char *filename);
-static void keyboard_map(void);
-static void keyboard_logic(void);
+static bool b_load_file(const char *filename, uint8_t **buff, uint32_t *size);
+static uint32_t color_to_pixel(Color color);
+static void keyboard_map(chip8_keymap_t *keymap);
+static void keyboard_logic(chip8_t *chip, const chip8_keymap_t *keymap);
 
 /////////////////////////////////////////////////
 /// Main function
@@ -50,60 +48,144 @@ int main(int argc, char **argv)
         return -1;
     }
 
-    if( b_load_file(argv[1]) == false )
+    ///Local variables
+    chip8_t CHIP8;
+    chip8_keymap_t keymap;
+    uint8_t *buff = NULL;
+    uint32_t size = 0;
+
+    if( b_load_file(argv[1], &buff, &size) == false )
     {
         puts("Failed to load file");
         return -1;
     }
 
-    ///Local variables
-    chip8_t CHIP8;
-
     ///Map keyboard
-    keyboard_map();
+    keyboard_map(&keymap);
+
+    ///Init CHIP8, a new random sequence on every launch
+    chip8_config_t config = { .seed = (uint64_t)time(NULL) };
+    CHIP8_InitWithConfig(&CHIP8, &config, &keymap, buff, size);
+
+    ///Optional instructions per second, 0 runs unbounded
+    if( argc >= 3 )
+    {
+        CHIP8_SetSpeed(&CHIP8, (uint32_t)strtoul(argv[2], NULL, 10));
+    }
 
-    ///Init CHIP8
-    CHIP8_Init(&CHIP8, &keymap, buff, size);
+    ///Optional movie of the session, replayed headless with chip8-run --replay
+    bool recording = false;
+    if( argc >= 4 )
+    {
+        recording = (CHIP8_MovieRecordStart(&CHIP8, argv[3], buff, size) == CHIP8_ERROR_NO);
+        if( recording == false )
+        {
+            puts("WARNING: Recording disabled, it needs a bounded speed");
+        }
+    }
     free(buff);
 
     InitWindow(MAIN_WINDOW_WIDTH, MAIN_WINDOW_HEIGHT, MAIN_WINDOW_NAME);
     SetTargetFPS(MAIN_WINDOW_FPS);
 
+    ///One RGBA texture holds the largest framebuffer, the active resolution is its top left corner scaled up when drawn
+    static uint32_t pixels[CHIP8_RENDER_PIXELS];
+    const uint32_t on_pixel = color_to_pixel(WHITE);
+    const uint32_t off_pixel = color_to_pixel(BLACK);
+
+    Image screen_image = GenImageColor(CHIP8_WIDTH_SCREEN, CHIP8_HEIGHT_SCREEN, BLACK);
+    Texture2D screen_texture = LoadTextureFromImage(screen_image);
+    UnloadImage(screen_image);
+    SetTextureFilter(screen_texture, TEXTURE_FILTER_POINT);
+
+    const Rectangle dest = { 0.0f, 0.0f, (float)MAIN_WINDOW_WIDTH, (float)MAIN_WINDOW_HEIGHT };
+
+    ///Every frame is recorded, the rewind key is ignored when the history could not be allocated
+    chip8_rewind_t *rewind = NULL;
+    if( CHIP8_RewindCreate(&rewind, CHIP8_REWIND_DEFAULT_CAPACITY) != CHIP8_ERROR_NO )
+    {
+        puts("WARNING: Rewind disabled");
+        rewind = NULL;
+    }
+    else
+    {
+        CHIP8_RewindPush(rewind, &CHIP8);
+    }
+
+    bool beeping = false;
+
     while (!WindowShouldClose())
     {
+        chip8_framebuffer_t fb;
+        CHIP8_GetFramebuffer(&CHIP8, &fb);
+
+        ///Only rasterize and upload the rows changed since the last frame
+        uint64_t dirty_rows = 0;
+        chip8_rect_t dirty;
+        if( CHIP8_GetDirtyRegion(&CHIP8, &dirty_rows, &dirty) )
+        {
+            CHIP8_RenderRGBARows(&CHIP8, pixels, on_pixel, off_pixel, dirty_rows);
+
+            const Rectangle band = { 0.0f, (float)dirty.y, (float)fb.width, (float)dirty.height };
+            UpdateTextureRec(screen_texture, band, &pixels[dirty.y * fb.width]);
+            CHIP8_ClearDirty(&CHIP8);
+        }
+
         BeginDrawing();
         ClearBackground(BLACK);
-        for(uint16_t y = 0; y < CHIP8_HEIGHT_SCREEN; y++)
+        const Rectangle source = { 0.0f, 0.0f, (float)fb.width, (float)fb.height };
+        DrawTexturePro(screen_texture, source, dest, (Vector2){ 0.0f, 0.0f }, 0.0f, WHITE);
+        EndDrawing();
+
+        /// Transitions made while rewinding stay queued, rewind keeps the live key mask so none may be lost
+        keyboard_logic(&CHIP8, &keymap);
+
+        /// A rewound session can no longer be replayed, rewind is off while recording
+        if( rewind != NULL && recording == false && IsKeyDown(MAIN_REWIND_KEY) )
+        {
+            CHIP8_RewindStep(rewind, &CHIP8);
+        }
+        else
         {
-            for(uint16_t x = 0; x < CHIP8_WIDTH_SCREEN; x++)
+            /// Run the instructions and timer ticks owed for the elapsed frame time
+            CHIP8_Update(&CHIP8, (uint32_t)(GetFrameTime() * 1000000.0f));
+
+            if( rewind != NULL )
             {
-                if( CHIP8_IsPixelSet(&CHIP8, x, y) )
-                {
-                    DrawRectangle(x * 10, y * 10, 10, 10, WHITE);
-                }
+                CHIP8_RewindPush(rewind, &CHIP8);
             }
         }
-        EndDrawing();
 
-        if(CHIP8_GetDelayTimer(&CHIP8) > 0)
+        if( CHIP8_GetSoundTimer(&CHIP8) > 0 )
         {
-            CHIP8_DecreaseDelayTimer(&CHIP8);
+            if( beeping == false )
+            {
+                puts("INFO: BEEP!");
+            }
+            beeping = true;
         }
-
-        if(CHIP8_GetSoundTimer(&CHIP8) > 0)
+        else
         {
-            puts("INFO: BEEP!");
-            CHIP8_ResetSoundTimer(&CHIP8);
+            beeping = false;
         }
-
-        CHIP8_Run(&CHIP8);
     }
 
+    CHIP8_RewindDestroy(rewind);
+    UnloadTexture(screen_texture);
     CloseWindow();
+    CHIP8_Deinit(&CHIP8);
     return 0;
 }
 
-static bool b_load_file(const char *filename) {
+static uint32_t color_to_pixel(Color color)
+{
+    /// Same byte order as PIXELFORMAT_UNCOMPRESSED_R8G8B8A8
+    uint32_t pixel = 0;
+    memcpy(&pixel, &color, sizeof(pixel));
+    return pixel;
+}
+
+static bool b_load_file(const char *filename, uint8_t **buff, uint32_t *size) {
     printf("File name: %s\n", filename);
 
     FILE *f = fopen(filename, "rb");
@@ -114,24 +196,27 @@ static bool b_load_file(const char *filename) {
 
     /// Get file size
     fseek(f, 0, SEEK_END);
-    size = ftell(f);
+    (*size) = ftell(f);
     fseek(f, 0, SEEK_SET);
 
     /// Allocate memory
-    buff = (uint8_t *) malloc(size);
-    if (buff == NULL)
+    (*buff) = (uint8_t *) malloc(*size);
+    if ((*buff) == NULL)
     {
         puts("Failed to allocate memory.");
+        fclose(f);
         return false;
     }
 
-    memset(buff, 0, size);
-    size_t res = fread(buff, size, 1, f);
+    memset(*buff, 0, *size);
+    size_t res = fread(*buff, *size, 1, f);
+    fclose(f);
     if(res != 1)
     {
         /// Clean memory and free it
-        memset(buff, 0, size);
-        free(buff);
+        memset(*buff, 0, *size);
+        free(*buff);
+        (*buff) = NULL;
 
         puts("Failed to read from file.");
         return false;
@@ -140,31 +225,38 @@ static bool b_load_file(const char *filename) {
     return true;
 }
 
-static void keyboard_map(void)
+static void keyboard_map(chip8_keymap_t *keymap)
 {
-    keymap.map[CHIP8_KEY_ID_0] = KEY_ZERO;
-    keymap.map[CHIP8_KEY_ID_1] = KEY_ONE;
-    keymap.map[CHIP8_KEY_ID_2] = KEY_TWO;
-    keymap.map[CHIP8_KEY_ID_3] = KEY_THREE;
-    keymap.map[CHIP8_KEY_ID_4] = KEY_FOUR;
-    keymap.map[CHIP8_KEY_ID_5] = KEY_FIVE;
-    keymap.map[CHIP8_KEY_ID_6] = KEY_SIX;
-    keymap.map[CHIP8_KEY_ID_7] = KEY_SEVEN;
-    keymap.map[CHIP8_KEY_ID_8] = KEY_EIGHT;
-    keymap.map[CHIP8_KEY_ID_9] = KEY_NINE;
-    keymap.map[CHIP8_KEY_ID_A] = KEY_Q;
-    keymap.map[CHIP8_KEY_ID_B] = KEY_W;
-    keymap.map[CHIP8_KEY_ID_C] = KEY_E;
-    keymap.map[CHIP8_KEY_ID_D] = KEY_A;
-    keymap.map[CHIP8_KEY_ID_E] = KEY_S;
-    keymap.map[CHIP8_KEY_ID_F] = KEY_D;
+    keymap->map[CHIP8_KEY_ID_0] = KEY_ZERO;
+    keymap->map[CHIP8_KEY_ID_1] = KEY_ONE;
+    keymap->map[CHIP8_KEY_ID_2] = KEY_TWO;
+    keymap->map[CHIP8_KEY_ID_3] = KEY_THREE;
+    keymap->map[CHIP8_KEY_ID_4] = KEY_FOUR;
+    keymap->map[CHIP8_KEY_ID_5] = KEY_FIVE;
+    keymap->map[CHIP8_KEY_ID_6] = KEY_SIX;
+    keymap->map[CHIP8_KEY_ID_7] = KEY_SEVEN;
+    keymap->map[CHIP8_KEY_ID_8] = KEY_EIGHT;
+    keymap->map[CHIP8_KEY_ID_9] = KEY_NINE;
+    keymap->map[CHIP8_KEY_ID_A] = KEY_Q;
+    keymap->map[CHIP8_KEY_ID_B] = KEY_W;
+    keymap->map[CHIP8_KEY_ID_C] = KEY_E;
+    keymap->map[CHIP8_KEY_ID_D] = KEY_A;
+    keymap->map[CHIP8_KEY_ID_E] = KEY_S;
+    keymap->map[CHIP8_KEY_ID_F] = KEY_D;
 }
 
-static void keyboard_logic(void)
+static void keyboard_logic(chip8_t *chip, const chip8_keymap_t *keymap)
 {
-    uint32_t key_pressed = GetKeyPressed();
-    if(key_pressed != 0)
+    /// Transitions are queued, the VM picks them up at the start of its next run
+    for(uint32_t itr = 0; itr < CHIP8_KEY_ID_TOTAL; itr++)
     {
-
+        if( IsKeyPressed((int)keymap->map[itr]) )
+        {
+            CHIP8_PushKeyEvent(chip, keymap->map[itr], true);
+        }
+        else if( IsKeyReleased((int)keymap->map[itr]) )
+        {
+            CHIP8_PushKeyEvent(chip, keymap->map[itr], false);
+        }
     }
 }
\ No newline at end of file